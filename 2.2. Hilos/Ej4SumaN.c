@@ -1,62 +1,323 @@
 /**
  * @file Ej4SumaN.c
  * @brief Cada hilo calcula una parte de la suma de los primeros N enteros.
- * Los resultados parciales se almacenan en un arreglo global y luego se suman.
+ * Los resultados parciales se combinan en árbol con la reducción de ../Comun/reduccion.h.
  * @author Salvador Gonzalez Arellano
+ *
+ * Los números 1..N no se guardan en un arreglo: cada operación recibe datos = NULL y
+ * genera el elemento i como i + 1. Así se pueden sumar hasta 10^12 enteros (o más) sin
+ * reservar memoria.
+ *
+ * El programa es también un banco de pruebas de la reducción de un rango. Compara tres
+ * formas de sumar el bloque de cada hilo:
+ *      - bucle:   un lazo escalar (el compilador tiene prohibido vectorizarlo)
+ *      - avx2:    un lazo AVX2 que suma 16 enteros por iteración en 4 registros de 4 carriles
+ *      - formula: la serie aritmética (a + b) * (b - a + 1) / 2, en tiempo constante
+ * y dos acumuladores:
+ *      - 64:  uint64_t, exacto solo para N <= 2^32 - 1 (después la suma se desborda)
+ *      - 128: unsigned __int128, exacto para cualquier N que acepte el programa
+ *
+ * Por cada combinación y número de hilos escribe una fila CSV con el tiempo, los
+ * Gelementos/s, la aceleración respecto al primer número de hilos y si la suma coincide con
+ * la fórmula. Como la suma de un rango no lee memoria, sirve como referencia de escalamiento
+ * limitado por cómputo para compararla con Ej2SumaBarrera.c (3.4), que sí está limitada
+ * por el ancho de banda de la memoria.
+ *
+ * Compilación:
+ *      gcc -O3 -march=native -o Ej4SumaN Ej4SumaN.c -lpthread -lm
+ *
+ * Ejecución:
+ *      ./Ej4SumaN                                   (N = 10000, 4 hilos)
+ *      ./Ej4SumaN -N 4000000000 -n 1,2,4,8
+ *      ./Ej4SumaN -N 1000000000000 -m avx2,formula -a 128
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
 #include <pthread.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "../Comun/reduccion.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
 
-#define N 10000          // Valor máximo a sumar
-#define NUM_HILOS 4     // Número de hilos a utilizar
+#define N 10000                     // Valor máximo a sumar por defecto
+#define NUM_HILOS 4                 // Número de hilos por defecto
+#define MAX_HILOS 1024              // Límite de -n
+#define MAX_LISTA 32                // Elementos máximos en cada lista de la línea de comandos
+#define MAX_N 1000000000000000ULL   // 10^15: la suma cabe holgada en 128 bits
+#define MAX_N_64 4294967295ULL      // Mayor N cuya suma cabe en 64 bits
+#define SUBBLOQUE_AVX2 (1 << 15)    // Elementos por vaciado de los carriles de 64 bits a 128
 
-int parciales[NUM_HILOS]; // Arreglo global para almacenar los resultados parciales
+typedef unsigned __int128 u128;
+
+enum Modo { MODO_BUCLE, MODO_AVX2, MODO_FORMULA };
+static const char *NOMBRES_MODO[] = { "bucle", "avx2", "formula" };
+
+/* ---------- Núcleos: suma de los enteros inicio + 1 .. fin ---------- */
 
 /**
- * @brief Función que calcula la suma de un rango determinado por el índice del hilo.
- * @param arg Puntero a entero (índice del hilo).
- * @return NULL
+ * @brief Lazo escalar. El atributo evita que GCC lo vectorice, para que sirva de referencia.
  */
-void *sumar_parcial(void *arg) {
-    int indice = *(int *)arg;
-    int paso = N / NUM_HILOS;
-    int inicio = indice * paso + 1;
-    int fin = (indice == NUM_HILOS - 1) ? N : (indice + 1) * paso;
-    int suma = 0;
+__attribute__((optimize("no-tree-vectorize")))
+static uint64_t sumar_bucle_64(size_t inicio, size_t fin) {
+    uint64_t suma = 0;
+    for (size_t i = inicio; i < fin; i++) {
+        suma += i + 1;
+    }
+    return suma;
+}
 
-    for (int i = inicio; i <= fin; i++) {
-        suma += i;
+__attribute__((optimize("no-tree-vectorize")))
+static u128 sumar_bucle_128(size_t inicio, size_t fin) {
+    u128 suma = 0;
+    for (size_t i = inicio; i < fin; i++) {
+        suma += i + 1;
     }
+    return suma;
+}
 
-    parciales[indice] = suma;
+#ifdef __AVX2__
+/**
+ * @brief Suma inicio + 1 .. fin en carriles de 64 bits y devuelve los 4 carriles sumados.
+ *
+ * Usa 4 acumuladores independientes (16 enteros por iteración) para que la latencia de
+ * una suma no detenga a la siguiente. Los carriles se desbordan módulo 2^64, igual que la
+ * suma escalar de 64 bits; la versión de 128 bits llama a esta función por subbloques lo
+ * bastante cortos para que ningún carril se desborde.
+ */
+static void sumar_avx2_carriles(size_t inicio, size_t fin, uint64_t carriles[4]) {
+    const __m256i paso = _mm256_set1_epi64x(16);
+    __m256i v0 = _mm256_setr_epi64x(inicio + 1, inicio + 2, inicio + 3, inicio + 4);
+    __m256i v1 = _mm256_add_epi64(v0, _mm256_set1_epi64x(4));
+    __m256i v2 = _mm256_add_epi64(v0, _mm256_set1_epi64x(8));
+    __m256i v3 = _mm256_add_epi64(v0, _mm256_set1_epi64x(12));
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0;
+    size_t i = inicio;
+
+    for (; i + 16 <= fin; i += 16) {
+        a0 = _mm256_add_epi64(a0, v0);
+        a1 = _mm256_add_epi64(a1, v1);
+        a2 = _mm256_add_epi64(a2, v2);
+        a3 = _mm256_add_epi64(a3, v3);
+        v0 = _mm256_add_epi64(v0, paso);
+        v1 = _mm256_add_epi64(v1, paso);
+        v2 = _mm256_add_epi64(v2, paso);
+        v3 = _mm256_add_epi64(v3, paso);
+    }
+    __m256i total = _mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3));
+    _mm256_storeu_si256((__m256i *)carriles, total);
+    for (; i < fin; i++) {
+        carriles[0] += i + 1;
+    }
+}
+#endif
 
-    printf("Hilo %d: suma [%d - %d] = %d\n", indice, inicio, fin, suma);
-    return NULL;
+static uint64_t sumar_avx2_64(size_t inicio, size_t fin) {
+#ifdef __AVX2__
+    uint64_t c[4];
+    sumar_avx2_carriles(inicio, fin, c);
+    return c[0] + c[1] + c[2] + c[3];
+#else
+    return sumar_bucle_64(inicio, fin);
+#endif
+}
+
+static u128 sumar_avx2_128(size_t inicio, size_t fin) {
+#ifdef __AVX2__
+    // Con subbloques de 2^15 elementos cada carril suma unos 2^13 valores menores que
+    // 2^50 (N <= 10^15), así que su suma queda por debajo de 2^64.
+    u128 suma = 0;
+    for (size_t b = inicio; b < fin; b += SUBBLOQUE_AVX2) {
+        size_t e = (fin - b > SUBBLOQUE_AVX2) ? b + SUBBLOQUE_AVX2 : fin;
+        uint64_t c[4];
+        sumar_avx2_carriles(b, e, c);
+        suma += (u128)c[0] + c[1] + c[2] + c[3];
+    }
+    return suma;
+#else
+    return sumar_bucle_128(inicio, fin);
+#endif
 }
 
 /**
- * @brief Función principal que lanza los hilos y suma los resultados parciales.
- * @return int Código de salida.
+ * @brief Serie aritmética: (inicio + 1) + ... + fin = (inicio + 1 + fin) * (fin - inicio) / 2.
  */
-int main() {
-    pthread_t hilos[NUM_HILOS];
-    int indices[NUM_HILOS];  // Se requiere un arreglo separado para evitar condiciones de carrera
+static u128 sumar_formula_128(size_t inicio, size_t fin) {
+    return (u128)(inicio + 1 + fin) * (fin - inicio) / 2;
+}
 
-    for (int i = 0; i < NUM_HILOS; i++) {
-        indices[i] = i;
-        pthread_create(&hilos[i], NULL, sumar_parcial, &indices[i]);
+static uint64_t sumar_formula_64(size_t inicio, size_t fin) {
+    // Se divide primero el factor par para que el producto solo se desborde si la suma lo hace
+    uint64_t a = inicio + 1 + fin, b = fin - inicio;
+    return (a % 2 == 0) ? (a / 2) * b : a * (b / 2);
+}
+
+/* ---------- Operaciones para reducir_paralelo ---------- */
+
+static void cero_u128(void *acc) { *(u128 *)acc = 0; }
+static void combinar_u64(void *acc, const void *otro) { *(uint64_t *)acc += *(const uint64_t *)otro; }
+static void combinar_u128(void *acc, const void *otro) { *(u128 *)acc += *(const u128 *)otro; }
+
+#define DEFINIR_ACUMULAR(NUCLEO, T) \
+    static void acumular_##NUCLEO(const void *datos, size_t inicio, size_t fin, void *acc) { \
+        (void)datos; \
+        *(T *)acc += sumar_##NUCLEO(inicio, fin); \
     }
 
-    for (int i = 0; i < NUM_HILOS; i++) {
-        pthread_join(hilos[i], NULL);
+DEFINIR_ACUMULAR(bucle_64, uint64_t)
+DEFINIR_ACUMULAR(bucle_128, u128)
+DEFINIR_ACUMULAR(avx2_64, uint64_t)
+DEFINIR_ACUMULAR(avx2_128, u128)
+DEFINIR_ACUMULAR(formula_64, uint64_t)
+DEFINIR_ACUMULAR(formula_128, u128)
+
+// OPERACIONES[modo][0] es la de 64 bits, OPERACIONES[modo][1] la de 128
+static const OperacionReduccion OPERACIONES[3][2] = {
+    { { sizeof(uint64_t), reduccion_cero_i64, acumular_bucle_64, combinar_u64 },
+      { sizeof(u128), cero_u128, acumular_bucle_128, combinar_u128 } },
+    { { sizeof(uint64_t), reduccion_cero_i64, acumular_avx2_64, combinar_u64 },
+      { sizeof(u128), cero_u128, acumular_avx2_128, combinar_u128 } },
+    { { sizeof(uint64_t), reduccion_cero_i64, acumular_formula_64, combinar_u64 },
+      { sizeof(u128), cero_u128, acumular_formula_128, combinar_u128 } },
+};
+
+/* ---------- Línea de comandos ---------- */
+
+/**
+ * @brief Convierte una lista de nombres de modo ("bucle,avx2") a valores de Modo.
+ * @return int Número de modos leídos, o -1 si alguno es inválido
+ */
+int leer_modos(const char *texto, int *modos) {
+    char copia[256];
+    int n = 0;
+    strncpy(copia, texto, sizeof(copia) - 1);
+    copia[sizeof(copia) - 1] = '\0';
+
+    for (char *parte = strtok(copia, ","); parte != NULL; parte = strtok(NULL, ",")) {
+        int m = 0;
+        while (m <= MODO_FORMULA && strcmp(parte, NOMBRES_MODO[m]) != 0) m++;
+        if (m > MODO_FORMULA || n == MAX_LISTA) return -1;
+        modos[n++] = m;
     }
+    return (n > 0) ? n : -1;
+}
+
+/**
+ * @brief Escribe un entero de 128 bits en decimal.
+ */
+void imprimir_u128(u128 valor) {
+    char texto[40];
+    int i = sizeof(texto) - 1;
+    texto[i] = '\0';
+    do {
+        texto[--i] = (char)('0' + (int)(valor % 10));
+        valor /= 10;
+    } while (valor != 0);
+    fputs(&texto[i], stdout);
+}
 
-    int suma_total = 0;
-    for (int i = 0; i < NUM_HILOS; i++) {
-        suma_total += parciales[i];
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-N valor_maximo] [-n hilos] [-m modos] [-a bits]\n"
+            "  -N N   suma 1..N, 1..10^15 (por defecto %d)\n"
+            "  -n L   lista de números de hilos, por ejemplo 1,2,4,8 (por defecto %d)\n"
+            "  -m L   lista de modos: bucle, avx2, formula (por defecto todos)\n"
+            "  -a B   acumulador: 64, 128 o ambos separados por coma (por defecto 64,128)\n",
+            programa, N, NUM_HILOS);
+}
+
+/**
+ * @brief Función principal: recorre modos, acumuladores y números de hilos, y escribe
+ *        una fila CSV por combinación.
+ * @return int Código de salida.
+ */
+int main(int argc, char *argv[]) {
+    unsigned long long n = N;
+    long valor;
+    int hilos[MAX_LISTA] = { NUM_HILOS }, num_listas_hilos = 1;
+    int modos[MAX_LISTA] = { MODO_BUCLE, MODO_AVX2, MODO_FORMULA }, num_modos = 3;
+    int bits[MAX_LISTA] = { 64, 128 }, num_bits = 2;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "N:n:m:a:")) != -1) {
+        switch (opcion) {
+            case 'N':
+                if (leer_entero(optarg, 1, (long)MAX_N, &valor) != 0) {
+                    fprintf(stderr, "N inválido: %s (1..%llu)\n", optarg, MAX_N);
+                    return 1;
+                }
+                n = (unsigned long long)valor;
+                break;
+            case 'n':
+                if ((num_listas_hilos = leer_lista_int(optarg, NULL, 1, MAX_HILOS, hilos, MAX_LISTA)) < 0) {
+                    fprintf(stderr, "Lista de hilos inválida: %s (1..%d)\n", optarg, MAX_HILOS);
+                    return 1;
+                }
+                break;
+            case 'm':
+                if ((num_modos = leer_modos(optarg, modos)) < 0) {
+                    fprintf(stderr, "Lista de modos inválida: %s (bucle, avx2, formula)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'a':
+                num_bits = leer_lista_int(optarg, NULL, 64, 128, bits, MAX_LISTA);
+                for (int i = 0; i < num_bits; i++) {
+                    if (bits[i] != 64 && bits[i] != 128) num_bits = -1;
+                }
+                if (num_bits < 0) {
+                    fprintf(stderr, "Acumulador inválido: %s (64 o 128)\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                uso(argv[0]);
+                return 1;
+        }
     }
+#ifndef __AVX2__
+    fprintf(stderr, "Aviso: compilado sin AVX2 (falta -march=native); el modo avx2 usa el lazo escalar.\n");
+#endif
+
+    u128 esperada = sumar_formula_128(0, n);
+    printf("# Suma total de 1 a %llu = ", n);
+    imprimir_u128(esperada);
+    printf("\n");
+    printf("modo,acumulador,hilos,N,segundos,gelem_s,aceleracion,verificacion\n");
+
+    for (int m = 0; m < num_modos; m++) {
+        for (int b = 0; b < num_bits; b++) {
+            const OperacionReduccion *op = &OPERACIONES[modos[m]][bits[b] == 128];
+            double base = 0;
+            for (int h = 0; h < num_listas_hilos; h++) {
+                u128 suma128 = 0;
+                uint64_t suma64 = 0;
+                void *resultado = (bits[b] == 128) ? (void *)&suma128 : (void *)&suma64;
+                double inicio = ahora();
+                if (reducir_paralelo(NULL, n, op, hilos[h], resultado) != 0) {
+                    fprintf(stderr, "Error al reservar memoria para la reducción.\n");
+                    return 1;
+                }
+                double segundos = ahora() - inicio;
+                if (h == 0) base = segundos;
 
-    printf("Suma total de 1 a %d = %d\n", N, suma_total);
+                const char *verificacion;
+                if (bits[b] == 128) verificacion = (suma128 == esperada) ? "ok" : "ERROR";
+                else if (suma64 == (uint64_t)esperada) verificacion = (n <= MAX_N_64) ? "ok" : "desborde";
+                else verificacion = "ERROR";
+
+                printf("%s,%d,%d,%llu,%.6f,%.3f,%.2f,%s\n", NOMBRES_MODO[modos[m]], bits[b], hilos[h],
+                       n, segundos, n / segundos / 1e9, base / segundos, verificacion);
+                fflush(stdout);
+            }
+        }
+    }
     return 0;
 }
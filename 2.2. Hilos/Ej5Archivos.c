@@ -1,73 +1,790 @@
 /**
  * @file Ej5Archivos.c
- * @brief Cada hilo lee un archivo de texto y cuenta cuántas líneas contiene.
+ * @brief Un grupo fijo de hilos cuenta las líneas de una lista de archivos.
  * Los resultados se recogen al final para sumar el total.
  * @author Salvador Gonzalez Arellano
+ *
+ * Los archivos pueden darse como rutas, patrones glob ("logs/app-*.log", entre comillas para
+ * que no los expanda el shell) o, con -r, directorios que se recorren recursivamente.
+ * En lugar de un hilo por archivo, -n hilos trabajadores toman tareas de una cola:
+ *      - Cada archivo es una tarea; los de más de 64 MiB se dividen en varias tareas de
+ *        64 MiB, así que un solo log de 50 GB también usa todos los hilos.
+ *      - La cola se ordena de la tarea más grande a la más chica: las grandes se
+ *        reparten primero y las chicas rellenan los huecos al final (equilibrio por tamaño).
+ *      - Un contador atómico es el frente de la cola; tomar una tarea es un fetch_add.
+ *
+ * Los '\n' se cuentan con instrucciones SIMD (AVX2 o SSE2, conteo_lineas.h). Hay tres
+ * formas de leer los archivos (-b):
+ *      - mmap (por defecto): cada rango se proyecta en memoria. Es lo más rápido si los
+ *        archivos ya están en la caché de páginas.
+ *      - uring: cada hilo tiene un io_uring (anillo_uring.h) con -p lecturas de 256 KiB
+ *        en vuelo, de varios archivos a la vez, y cuenta cada búfer cuando termina su
+ *        lectura. Con la caché fría en un NVMe lo que importa es la profundidad de la
+ *        cola del disco, y read bloqueante deja una sola lectura por hilo.
+ *      - pread: cada hilo lee con pread bloqueante; la profundidad es el número de
+ *        hilos. Se usa en lugar de uring si el kernel no tiene io_uring o está
+ *        deshabilitado.
+ * Con -f se sacan los archivos de la caché de páginas antes de medir (posix_fadvise con
+ * POSIX_FADV_DONTNEED) para medir una lectura en frío sin ser root.
+ *
+ * Con -l, -w, -c o -L la salida es la de GNU wc (LC_ALL=C) con esas columnas: líneas,
+ * palabras, bytes y ancho de la línea más larga, con el mismo ancho de columna y la fila
+ * "total". Se cuentan en una sola pasada por bloque (texto_contar en conteo_lineas.h);
+ * cada tarea o bloque se cuenta por separado y los resultados se juntan en orden, así
+ * que las palabras y líneas partidas entre dos tareas se cuentan bien. Sin archivos se
+ * lee la entrada estándar, como wc. El tiempo y los MiB/s van a stderr con -v.
+ *
+ * Compilación:
+ *      gcc -O3 -march=native -o Ej5Archivos Ej5Archivos.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej5Archivos                       (file1.txt, file2.txt y file3.txt)
+ *      ./Ej5Archivos -n 16 enorme.log      (16 hilos para un archivo)
+ *      ./Ej5Archivos -n 8 -q -r /var/log   (recursivo, solo el total)
+ *      ./Ej5Archivos "datos/parte-*.txt"   (patrón glob)
+ *      ./Ej5Archivos -b uring -p 64 -f -q -r logs    (en frío, 64 lecturas en vuelo por hilo)
+ *      ./Ej5Archivos -lwc -n 8 logs/app-*.log         (como wc -lwc, con 8 hilos)
  */
 
+#define _GNU_SOURCE     // nftw y madvise
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <glob.h>
+#include <ftw.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "conteo_lineas.h"
+#include "anillo_uring.h"
+#include "../Comun/medicion.h"
+#include "../Comun/opciones.h"
 
 #define NUM_ARCHIVOS 3
+#define MAX_HILOS 256
+#define TAM_TAREA CONTEO_RANGO_MIN      // Bytes máximos por tarea (64 MiB)
+#define TAM_BLOQUE (256UL << 10)        // Bytes por lectura con pread e io_uring
+#define PROFUNDIDAD 32                  // Lecturas en vuelo por hilo con io_uring
+#define MAX_PROFUNDIDAD 1024
+
+enum { METODO_MMAP, METODO_PREAD, METODO_URING };
+enum { COL_LINEAS = 1, COL_PALABRAS = 2, COL_BYTES = 4, COL_MAXIMA = 8 };     // Columnas de wc
+static const char *NOMBRES_METODO[] = { "mmap", "pread", "uring" };
+
+/**
+ * @struct Archivo
+ * @brief Un archivo de la lista y su resultado.
+ */
+typedef struct {
+    char *nombre;           ///< Ruta del archivo
+    uint64_t tamano;        ///< Tamaño según stat
+    int regular;            ///< 0 para tuberías y dispositivos: se leen con read
+    int entrada;            ///< 1 para "-": la entrada estándar, que siempre se lee con read
+    int primera_tarea;      ///< Índice de su primera tarea (las demás van seguidas)
+    int num_tareas;         ///< Tareas en que se dividió
+    EstadisticasTexto texto;    ///< Resultado: lo que cuenta wc
+    uint64_t lineas;        ///< Resultado: líneas, contando la última aunque no tenga '\n'
+    int error;              ///< errno si no se pudo leer, 0 si todo salió bien
+} Archivo;
 
 /**
- * @struct ArchivoParam
- * @brief Estructura para pasar el nombre del archivo al hilo.
+ * @struct Tarea
+ * @brief Rango de bytes [desde, hasta) de un archivo; lo cuenta un solo hilo.
  */
 typedef struct {
-    char nombre[100];  ///< Nombre del archivo a procesar
-} ArchivoParam;
+    int archivo;            ///< Índice en la lista de archivos
+    uint64_t desde;
+    uint64_t hasta;
+    EstadisticasTexto texto;    ///< Resultado del rango
+    char ultimo;            ///< Resultado: último byte del rango
+    EstadisticasTexto *bloques; ///< Resultado de cada bloque de TAM_BLOQUE (uring con -w o -L)
+    int error;              ///< errno si falló
+    int fd;                 ///< Descriptor abierto mientras tiene lecturas en vuelo (uring)
+    int en_vuelo;           ///< Lecturas pedidas que no han terminado (uring)
+    int enviada;            ///< 1 cuando ya se pidieron todas sus lecturas (uring)
+} Tarea;
 
 /**
- * @brief Función que cuenta las líneas de un archivo.
- * @param arg Puntero a ArchivoParam con el nombre del archivo.
- * @return Puntero a entero que representa el número de líneas (debe liberarse).
+ * @struct ListaArchivos
+ * @brief Arreglo dinámico de archivos.
  */
-void *contar_lineas(void *arg) {
-    ArchivoParam *param = (ArchivoParam *)arg;
-    FILE *archivo = fopen(param->nombre, "r");
-    int *contador = malloc(sizeof(int));
-    *contador = 0;
+typedef struct {
+    Archivo *v;
+    int n;
+    int capacidad;
+} ListaArchivos;
+
+/**
+ * @struct Cola
+ * @brief Tareas ordenadas de mayor a menor y el frente de la cola, compartidos por los hilos.
+ */
+typedef struct {
+    Archivo *archivos;
+    Tarea *tareas;
+    int *orden;             ///< Índices de tareas, de la más grande a la más chica
+    int num_tareas;
+    atomic_int siguiente;   ///< Frente de la cola
+    int metodo;             ///< METODO_MMAP, METODO_PREAD o METODO_URING
+    int profundidad;        ///< Lecturas en vuelo por hilo con io_uring
+    int completo;           ///< 1 si se piden palabras o línea más larga, no solo '\n'
+    int solo_bytes;         ///< 1 con solo -c: los archivos regulares no se leen
+} Cola;
 
-    if (archivo == NULL) {
-        perror("Error al abrir el archivo");
-        return contador;  // Retorna 0 si falla
+/**
+ * @struct Lectura
+ * @brief Una lectura en vuelo de io_uring: a qué tarea pertenece y dónde va el búfer.
+ */
+typedef struct {
+    struct iovec iov;       ///< Búfer que llena el kernel
+    int tarea;
+    uint64_t desplazamiento;
+} Lectura;
+
+static ListaArchivos lista;     // nftw no pasa contexto a su función
+static int fallas_lista = 0;    // Rutas que no se pudieron agregar
+
+/**
+ * @brief Agrega un archivo a la lista.
+ * @return int 0 si todo salió bien, -1 si no hay memoria
+ */
+int agregar_archivo(const char *nombre, const struct stat *info) {
+    if (lista.n == lista.capacidad) {
+        int capacidad = lista.capacidad ? 2 * lista.capacidad : 64;
+        Archivo *v = realloc(lista.v, capacidad * sizeof(Archivo));
+        if (!v) return -1;
+        lista.v = v;
+        lista.capacidad = capacidad;
     }
+    Archivo *a = &lista.v[lista.n];
+    memset(a, 0, sizeof(*a));
+    a->nombre = strdup(nombre);
+    if (!a->nombre) return -1;
+    a->regular = S_ISREG(info->st_mode);
+    a->tamano = a->regular ? (uint64_t)info->st_size : 0;
+    lista.n++;
+    return 0;
+}
 
-    char linea[256];
-    while (fgets(linea, sizeof(linea), archivo)) {
-        (*contador)++;
+/**
+ * @brief Función para nftw: agrega los archivos regulares que encuentra.
+ */
+int visitar(const char *ruta, const struct stat *info, int tipo, struct FTW *ftw) {
+    (void)ftw;
+    if (tipo == FTW_F && S_ISREG(info->st_mode)) {
+        if (agregar_archivo(ruta, info) != 0) return -1;
+    } else if (tipo == FTW_DNR || tipo == FTW_NS) {
+        fprintf(stderr, "No se pudo leer '%s'\n", ruta);
+        fallas_lista++;
     }
+    return 0;
+}
 
-    fclose(archivo);
-    printf("Archivo '%s': %d líneas\n", param->nombre, *contador);
-    return contador;
+/**
+ * @brief Agrega una ruta: un archivo o, con recursivo, todos los archivos bajo un directorio.
+ * @return int 0 si todo salió bien, -1 si no hay memoria
+ */
+int agregar_ruta(const char *ruta, int recursivo) {
+    struct stat info;
+    if (stat(ruta, &info) != 0) {
+        fprintf(stderr, "Error al abrir el archivo '%s': %s\n", ruta, strerror(errno));
+        fallas_lista++;
+        return 0;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        if (!recursivo) {
+            fprintf(stderr, "'%s' es un directorio (use -r para recorrerlo)\n", ruta);
+            fallas_lista++;
+            return 0;
+        }
+        return nftw(ruta, visitar, 64, FTW_PHYS) == 0 ? 0 : -1;
+    }
+    return agregar_archivo(ruta, &info);
 }
 
 /**
- * @brief Función principal que lanza hilos para leer archivos y suma el total de líneas.
- * @return int Código de salida.
+ * @brief Agrega un argumento: si tiene comodines se expande con glob(3).
+ * @return int 0 si todo salió bien, -1 si no hay memoria
  */
-int main() {
-    const char *nombres_archivos[NUM_ARCHIVOS] = {"file1.txt", "file2.txt", "file3.txt"};
-    pthread_t hilos[NUM_ARCHIVOS];
-    ArchivoParam params[NUM_ARCHIVOS];
+int agregar_argumento(const char *argumento, int recursivo) {
+    if (strcmp(argumento, "-") == 0) {
+        struct stat info;
+        if (fstat(STDIN_FILENO, &info) != 0) {
+            fprintf(stderr, "Error al leer la entrada estándar: %s\n", strerror(errno));
+            fallas_lista++;
+            return 0;
+        }
+        if (agregar_archivo(argumento, &info) != 0) return -1;
+        lista.v[lista.n - 1].entrada = 1;
+        return 0;
+    }
+    if (strpbrk(argumento, "*?[") == NULL) {
+        return agregar_ruta(argumento, recursivo);
+    }
 
-    for (int i = 0; i < NUM_ARCHIVOS; i++) {
-        strncpy(params[i].nombre, nombres_archivos[i], sizeof(params[i].nombre));
-        pthread_create(&hilos[i], NULL, contar_lineas, &params[i]);
+    glob_t coincidencias;
+    int codigo = glob(argumento, 0, NULL, &coincidencias);
+    if (codigo == GLOB_NOMATCH) {
+        fprintf(stderr, "Ningún archivo coincide con '%s'\n", argumento);
+        fallas_lista++;
+        return 0;
+    }
+    if (codigo != 0) {
+        globfree(&coincidencias);
+        return -1;
+    }
+    for (size_t i = 0; i < coincidencias.gl_pathc && codigo == 0; i++) {
+        codigo = agregar_ruta(coincidencias.gl_pathv[i], recursivo);
     }
+    globfree(&coincidencias);
+    return codigo;
+}
 
-    int total_lineas = 0;
-    for (int i = 0; i < NUM_ARCHIVOS; i++) {
-        int *resultado;
-        pthread_join(hilos[i], (void **)&resultado);
-        total_lineas += *resultado;
-        free(resultado);
+/**
+ * @brief Divide los archivos en tareas de a lo más TAM_TAREA bytes.
+ * @return Tarea* Arreglo de tareas (NULL si no hay memoria); su tamaño queda en num_tareas
+ */
+Tarea *crear_tareas(Archivo *archivos, int num_archivos, int *num_tareas) {
+    long total = 0;
+    for (int i = 0; i < num_archivos; i++) {
+        archivos[i].num_tareas = (archivos[i].tamano > TAM_TAREA) ?
+                                 (int)((archivos[i].tamano + TAM_TAREA - 1) / TAM_TAREA) : 1;
+        archivos[i].primera_tarea = (int)total;
+        total += archivos[i].num_tareas;
+    }
+
+    Tarea *tareas = calloc(total > 0 ? total : 1, sizeof(Tarea));
+    if (!tareas) return NULL;
+    for (int i = 0; i < num_archivos; i++) {
+        for (int k = 0; k < archivos[i].num_tareas; k++) {
+            Tarea *t = &tareas[archivos[i].primera_tarea + k];
+            t->archivo = i;
+            t->desde = (uint64_t)k * TAM_TAREA;
+            t->hasta = (k == archivos[i].num_tareas - 1) ? archivos[i].tamano : t->desde + TAM_TAREA;
+            texto_iniciar(&t->texto);
+        }
     }
+    *num_tareas = (int)total;
+    return tareas;
+}
+
+static Tarea *tareas_orden;     // Para comparar_tareas (qsort no pasa contexto)
+
+/**
+ * @brief Orden de la cola: primero la tarea más grande.
+ */
+int comparar_tareas(const void *a, const void *b) {
+    const Tarea *x = &tareas_orden[*(const int *)a], *y = &tareas_orden[*(const int *)b];
+    uint64_t tx = x->hasta - x->desde, ty = y->hasta - y->desde;
+    return (tx < ty) - (tx > ty);
+}
+
+/**
+ * @brief Indica si la tarea se puede leer por rangos (archivo regular con tamaño).
+ *
+ * Las tuberías, los dispositivos, la entrada estándar y los archivos que stat reporta
+ * vacíos (/proc) son una sola tarea que se cuenta con read en contar_especial.
+ */
+int por_rangos(Cola *cola, Tarea *t) {
+    Archivo *a = &cola->archivos[t->archivo];
+    return a->regular && a->tamano > 0 && !a->entrada;
+}
+
+/**
+ * @brief Toma la siguiente tarea del frente de la cola.
+ * @return Tarea* La tarea, o NULL si la cola se vació
+ */
+Tarea *tomar_tarea(Cola *cola) {
+    int i;
+    while ((i = atomic_fetch_add(&cola->siguiente, 1)) < cola->num_tareas) {
+        Tarea *t = &cola->tareas[cola->orden[i]];
+        // Con solo -c basta el tamaño que dio stat, como hace wc
+        if (cola->solo_bytes && por_rangos(cola, t)) {
+            t->texto.bytes = t->hasta - t->desde;
+            continue;
+        }
+        return t;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cuenta un búfer leído de la tarea, que empieza en el byte desplazamiento.
+ *
+ * Si no se pidieron palabras ni línea más larga basta contar los '\n', que es más rápido.
+ */
+void contar_bloque(Cola *cola, Tarea *t, EstadisticasTexto *e, const char *datos, size_t n,
+                   uint64_t desplazamiento) {
+    if (cola->completo) {
+        texto_contar(e, datos, n);
+    } else {
+        e->lineas += contar_saltos(datos, n);
+        e->bytes += n;
+    }
+    if (desplazamiento + n == t->hasta) t->ultimo = datos[n - 1];
+}
+
+/**
+ * @brief Cuenta con read una tarea que no se puede leer por rangos.
+ */
+void contar_especial(Cola *cola, Tarea *t) {
+    Archivo *a = &cola->archivos[t->archivo];
+    int fd = a->entrada ? STDIN_FILENO : open(a->nombre, O_RDONLY);
+    if (fd < 0) {
+        t->error = errno;
+        return;
+    }
+    char *bufer = malloc(CONTEO_TAM_LECTURA);
+    ssize_t leidos = 0;
+    while (bufer && (leidos = read(fd, bufer, CONTEO_TAM_LECTURA)) != 0) {
+        if (leidos < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        contar_bloque(cola, t, &t->texto, bufer, (size_t)leidos, 0);
+        t->ultimo = bufer[leidos - 1];
+    }
+    if (!bufer || leidos < 0) t->error = errno;
+    free(bufer);
+    if (!a->entrada) close(fd);
+}
+
+/**
+ * @brief Cuenta una tarea proyectando su rango en memoria.
+ */
+void leer_con_mmap(Cola *cola, Tarea *t) {
+    void *base;
+    size_t tam;
+    const char *datos = proyectar_rango(cola->archivos[t->archivo].nombre, t->desde, t->hasta, &base, &tam);
+    if (!datos) {
+        t->error = errno;
+        return;
+    }
+    contar_bloque(cola, t, &t->texto, datos, (size_t)(t->hasta - t->desde), t->desde);
+    munmap(base, tam);
+}
+
+/**
+ * @brief Cuenta una tarea leyéndola con pread en bloques de TAM_BLOQUE.
+ */
+void leer_con_pread(Cola *cola, Tarea *t, char *bufer) {
+    int fd = open(cola->archivos[t->archivo].nombre, O_RDONLY);
+    if (fd < 0) {
+        t->error = errno;
+        return;
+    }
+    uint64_t posicion = t->desde;
+    while (posicion < t->hasta) {
+        size_t n = (t->hasta - posicion < TAM_BLOQUE) ? (size_t)(t->hasta - posicion) : TAM_BLOQUE;
+        ssize_t leidos = pread(fd, bufer, n, (off_t)posicion);
+        if (leidos < 0) {
+            if (errno == EINTR) continue;
+            t->error = errno;
+            break;
+        }
+        if (leidos == 0) break;     // El archivo se acortó mientras se leía
+        contar_bloque(cola, t, &t->texto, bufer, (size_t)leidos, posicion);
+        posicion += (uint64_t)leidos;
+    }
+    close(fd);
+}
 
-    printf("Total de líneas en todos los archivos: %d\n", total_lineas);
+/**
+ * @brief Número de bloques de TAM_BLOQUE en que io_uring lee una tarea.
+ */
+size_t bloques_tarea(const Tarea *t) {
+    return (size_t)((t->hasta - t->desde + TAM_BLOQUE - 1) / TAM_BLOQUE);
+}
+
+/**
+ * @brief Cierra una tarea de io_uring cuyas lecturas ya terminaron.
+ *
+ * Los bloques terminan en cualquier orden; con -w o -L cada uno se contó por separado y
+ * aquí se juntan de izquierda a derecha.
+ */
+void terminar_tarea_uring(Tarea *t) {
+    close(t->fd);
+    if (!t->bloques) return;
+    for (size_t j = 0; j < bloques_tarea(t); j++) {
+        texto_juntar(&t->texto, &t->bloques[j]);
+    }
+    free(t->bloques);
+    t->bloques = NULL;
+}
+
+/**
+ * @brief Trabajador con io_uring: mantiene hasta cola->profundidad lecturas en vuelo.
+ *
+ * Las lecturas pueden ser de varias tareas (varios archivos chicos a la vez). Cuando una
+ * termina se cuenta su búfer y el lugar se reusa para la siguiente lectura. Cada tarea
+ * es de un solo hilo, así que sus resultados no necesitan atómicos.
+ *
+ * @return int 0 si todo salió bien, -1 si no hubo memoria para los búferes
+ */
+int trabajador_uring(Cola *cola, AnilloUring *anillo) {
+    int profundidad = cola->profundidad;
+    Lectura *lecturas = calloc(profundidad, sizeof(Lectura));
+    int *libres = malloc(sizeof(int) * profundidad);
+    char *memoria = aligned_alloc(4096, (size_t)profundidad * TAM_BLOQUE);
+    if (!lecturas || !libres || !memoria) {
+        free(lecturas);
+        free(libres);
+        free(memoria);
+        return -1;
+    }
+    for (int i = 0; i < profundidad; i++) {
+        libres[i] = i;
+    }
+
+    int num_libres = profundidad, en_vuelo = 0, sin_tareas = 0;
+    Tarea *actual = NULL;
+    uint64_t posicion = 0;
+
+    for (;;) {
+        // Llena los lugares libres con lecturas de la tarea actual o de las siguientes
+        while (num_libres > 0 && !sin_tareas) {
+            if (!actual) {
+                actual = tomar_tarea(cola);
+                if (!actual) {
+                    sin_tareas = 1;
+                    break;
+                }
+                if (!por_rangos(cola, actual)) {
+                    contar_especial(cola, actual);
+                    actual = NULL;
+                    continue;
+                }
+                if (cola->completo) {
+                    actual->bloques = malloc(bloques_tarea(actual) * sizeof(EstadisticasTexto));
+                    if (!actual->bloques) {
+                        actual->error = ENOMEM;
+                        actual = NULL;
+                        continue;
+                    }
+                    for (size_t j = 0; j < bloques_tarea(actual); j++) {
+                        texto_iniciar(&actual->bloques[j]);
+                    }
+                }
+                actual->fd = -1;
+                posicion = actual->desde;
+            }
+            if (actual->fd < 0) {
+                actual->fd = open(cola->archivos[actual->archivo].nombre, O_RDONLY);
+                // Cada archivo con lecturas en vuelo tiene un descriptor abierto: si se
+                // acabaron, se espera a que terminen lecturas y se vuelve a intentar
+                if (actual->fd < 0 && (errno == EMFILE || errno == ENFILE) && en_vuelo > 0) break;
+                if (actual->fd < 0) {
+                    actual->error = errno;
+                    free(actual->bloques);
+                    actual->bloques = NULL;
+                    actual = NULL;
+                    continue;
+                }
+            }
+
+            int k = libres[--num_libres];
+            Lectura *l = &lecturas[k];
+            l->tarea = (int)(actual - cola->tareas);
+            l->desplazamiento = posicion;
+            l->iov.iov_base = memoria + (size_t)k * TAM_BLOQUE;
+            l->iov.iov_len = (actual->hasta - posicion < TAM_BLOQUE) ? (size_t)(actual->hasta - posicion) : TAM_BLOQUE;
+            uring_pedir_lectura(anillo, actual->fd, &l->iov, posicion, (uint64_t)k);
+            actual->en_vuelo++;
+            en_vuelo++;
+            posicion += l->iov.iov_len;
+            if (posicion >= actual->hasta) {
+                actual->enviada = 1;
+                actual = NULL;
+            }
+        }
+        if (en_vuelo == 0) break;
+
+        if (uring_enviar(anillo, 1) != 0) {
+            fprintf(stderr, "Error en io_uring_enter: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        // Cuenta los búferes de todas las lecturas que terminaron
+        uint64_t dato;
+        int resultado;
+        while (uring_terminacion(anillo, &dato, &resultado)) {
+            Lectura *l = &lecturas[dato];
+            Tarea *t = &cola->tareas[l->tarea];
+            if (resultado > 0) {
+                // Una lectura corta sigue en el mismo bloque, así que el índice no cambia
+                EstadisticasTexto *e = t->bloques ? &t->bloques[(l->desplazamiento - t->desde) / TAM_BLOQUE] : &t->texto;
+                contar_bloque(cola, t, e, l->iov.iov_base, (size_t)resultado, l->desplazamiento);
+                if ((size_t)resultado < l->iov.iov_len) {
+                    // Lectura corta: se pide el resto en el mismo lugar
+                    l->iov.iov_base = (char *)l->iov.iov_base + resultado;
+                    l->iov.iov_len -= (size_t)resultado;
+                    l->desplazamiento += (uint64_t)resultado;
+                    uring_pedir_lectura(anillo, t->fd, &l->iov, l->desplazamiento, dato);
+                    continue;
+                }
+            } else if (resultado < 0 && !t->error) {
+                t->error = -resultado;
+            }
+            // resultado == 0: el archivo se acortó mientras se leía
+
+            libres[num_libres++] = (int)dato;
+            en_vuelo--;
+            if (--t->en_vuelo == 0 && t->enviada) terminar_tarea_uring(t);
+        }
+    }
+
+    free(lecturas);
+    free(libres);
+    free(memoria);
     return 0;
 }
+
+/**
+ * @brief Hilo trabajador: toma tareas del frente de la cola hasta vaciarla.
+ */
+void *trabajador(void *arg) {
+    Cola *cola = arg;
+
+    if (cola->metodo == METODO_URING) {
+        AnilloUring anillo;
+        if (uring_iniciar(&anillo, (unsigned)cola->profundidad) == 0) {
+            int codigo = trabajador_uring(cola, &anillo);
+            uring_cerrar(&anillo);
+            if (codigo == 0) return NULL;
+        }
+        // Si este hilo no pudo crear su anillo o sus búferes, sigue con pread
+    }
+
+    char *bufer = NULL;
+    if (cola->metodo != METODO_MMAP && !(bufer = malloc(TAM_BLOQUE))) {
+        fprintf(stderr, "Error al asignar memoria para el búfer de lectura.\n");
+        exit(1);
+    }
+
+    Tarea *t;
+    while ((t = tomar_tarea(cola)) != NULL) {
+        if (!por_rangos(cola, t)) {
+            contar_especial(cola, t);
+        } else if (bufer) {
+            leer_con_pread(cola, t, bufer);
+        } else {
+            leer_con_mmap(cola, t);
+        }
+    }
+    free(bufer);
+    return NULL;
+}
+
+/**
+ * @brief Saca de la caché de páginas los archivos regulares de la lista.
+ *
+ * El kernel solo descarta páginas limpias que nadie tenga proyectadas; para una prueba
+ * en frío exacta hay que usar, como root, echo 3 > /proc/sys/vm/drop_caches.
+ */
+void vaciar_cache(Archivo *archivos, int num_archivos) {
+    for (int i = 0; i < num_archivos; i++) {
+        if (!archivos[i].regular || archivos[i].entrada) continue;
+        int fd = open(archivos[i].nombre, O_RDONLY);
+        if (fd < 0) continue;   // El error se reporta al contarlo
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+/**
+ * @brief Junta en orden los resultados de las tareas de cada archivo.
+ */
+void juntar_resultados(Archivo *archivos, int num_archivos, Tarea *tareas) {
+    for (int i = 0; i < num_archivos; i++) {
+        Archivo *a = &archivos[i];
+        Tarea *ultima = &tareas[a->primera_tarea + a->num_tareas - 1];
+        texto_iniciar(&a->texto);
+        for (int k = 0; k < a->num_tareas; k++) {
+            Tarea *t = &tareas[a->primera_tarea + k];
+            if (t->error && !a->error) a->error = t->error;
+            texto_juntar(&a->texto, &t->texto);
+        }
+        a->lineas = a->texto.lineas + (a->texto.bytes > 0 && ultima->ultimo != '\n');
+    }
+}
+
+/**
+ * @brief Ancho de las columnas como lo calcula GNU wc.
+ *
+ * Es el número de dígitos de la suma de los tamaños de los archivos regulares, al menos
+ * 7 si hay tuberías o dispositivos (cuyo tamaño no se conoce), y 1 si solo se imprime
+ * una columna de una sola entrada.
+ */
+int ancho_columnas(Archivo *archivos, int num_archivos, int columnas, int entradas) {
+    if (entradas == 1 && __builtin_popcount(columnas) == 1) return 1;
+    uint64_t suma = 0;
+    int minimo = 1, ancho = 1;
+    for (int i = 0; i < num_archivos; i++) {
+        if (archivos[i].regular) suma += archivos[i].tamano;
+        else minimo = 7;
+    }
+    for (; suma >= 10; suma /= 10) ancho++;
+    return (ancho < minimo) ? minimo : ancho;
+}
+
+/**
+ * @brief Imprime una fila de wc: las columnas pedidas y el nombre (si no es NULL).
+ */
+void imprimir_fila(const uint64_t valores[4], int columnas, int ancho, const char *nombre) {
+    const char *separador = "";
+    for (int c = 0; c < 4; c++) {
+        if (columnas & (1 << c)) {
+            printf("%s%*llu", separador, ancho, (unsigned long long)valores[c]);
+            separador = " ";
+        }
+    }
+    if (nombre) printf(" %s", nombre);
+    putchar('\n');
+}
+
+/**
+ * @brief Función principal: arma la lista de archivos, la cuenta con el grupo de hilos y
+ *        suma el total de líneas.
+ * @return int Código de salida (1 si algún archivo no se pudo leer).
+ */
+int main(int argc, char *argv[]) {
+    const char *predeterminados[NUM_ARCHIVOS] = {"file1.txt", "file2.txt", "file3.txt"};
+    long num_hilos = sysconf(_SC_NPROCESSORS_ONLN);
+    long profundidad = PROFUNDIDAD;
+    int recursivo = 0, silencioso = 0, en_frio = 0, detallado = 0, metodo = METODO_MMAP, columnas = 0;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:rqb:p:flwcLv")) != -1) {
+        if (opcion == 'r') { recursivo = 1; continue; }
+        if (opcion == 'q') { silencioso = 1; continue; }
+        if (opcion == 'f') { en_frio = 1; continue; }
+        if (opcion == 'v') { detallado = 1; continue; }
+        if (opcion == 'l') { columnas |= COL_LINEAS; continue; }
+        if (opcion == 'w') { columnas |= COL_PALABRAS; continue; }
+        if (opcion == 'c') { columnas |= COL_BYTES; continue; }
+        if (opcion == 'L') { columnas |= COL_MAXIMA; continue; }
+        if (opcion == 'b') {
+            for (metodo = METODO_URING; metodo >= 0 && strcmp(optarg, NOMBRES_METODO[metodo]) != 0; metodo--);
+            if (metodo >= 0) continue;
+            fprintf(stderr, "Método desconocido: %s (mmap, pread o uring)\n", optarg);
+        }
+        if (opcion == 'p') {
+            if (leer_entero(optarg, 1, MAX_PROFUNDIDAD, &profundidad) == 0) continue;
+            fprintf(stderr, "Profundidad inválida: %s (1..%d)\n", optarg, MAX_PROFUNDIDAD);
+        }
+        if (opcion == 'n') {
+            if (leer_entero(optarg, 1, MAX_HILOS, &num_hilos) == 0) continue;
+            fprintf(stderr, "Número de hilos inválido: %s (1..%d)\n", optarg, MAX_HILOS);
+        }
+        fprintf(stderr, "Uso: %s [-n hilos] [-r] [-q] [-b mmap|pread|uring] [-p profundidad] [-f] "
+                        "[-l] [-w] [-c] [-L] [-v] [archivo|directorio|\"patrón\"|-...]\n", argv[0]);
+        return 1;
+    }
+    if (num_hilos < 1) num_hilos = 1;
+    if (num_hilos > MAX_HILOS) num_hilos = MAX_HILOS;     // hilos[] tiene MAX_HILOS lugares
+
+    if (metodo == METODO_URING) {
+        AnilloUring prueba;
+        if (uring_iniciar(&prueba, 1) != 0) {
+            fprintf(stderr, "io_uring no disponible (%s); se usa pread\n", strerror(errno));
+            metodo = METODO_PREAD;
+        } else {
+            uring_cerrar(&prueba);
+        }
+    }
+
+    // Como wc, sin archivos se lee la entrada estándar (y no se imprime su nombre)
+    const char *entrada_estandar[] = {"-"};
+    const char **nombres = (optind < argc) ? (const char **)&argv[optind] : columnas ? entrada_estandar : predeterminados;
+    int num_argumentos = (optind < argc) ? argc - optind : columnas ? 1 : NUM_ARCHIVOS;
+    for (int i = 0; i < num_argumentos; i++) {
+        if (agregar_argumento(nombres[i], recursivo) != 0) {
+            fprintf(stderr, "Error al asignar memoria para la lista de archivos.\n");
+            return 1;
+        }
+    }
+
+    Cola cola;
+    cola.archivos = lista.v;
+    cola.tareas = crear_tareas(lista.v, lista.n, &cola.num_tareas);
+    cola.orden = malloc(sizeof(int) * (cola.num_tareas > 0 ? cola.num_tareas : 1));
+    if (!cola.tareas || !cola.orden) {
+        fprintf(stderr, "Error al asignar memoria para las tareas.\n");
+        return 1;
+    }
+    for (int i = 0; i < cola.num_tareas; i++) {
+        cola.orden[i] = i;
+    }
+    tareas_orden = cola.tareas;
+    qsort(cola.orden, cola.num_tareas, sizeof(int), comparar_tareas);
+    atomic_init(&cola.siguiente, 0);
+    cola.metodo = metodo;
+    cola.profundidad = (int)profundidad;
+    cola.completo = (columnas & (COL_PALABRAS | COL_MAXIMA)) != 0;
+    cola.solo_bytes = (columnas == COL_BYTES);
+    if (en_frio) vaciar_cache(lista.v, lista.n);
+
+    // No tiene caso tener más hilos que tareas
+    if (num_hilos > cola.num_tareas) num_hilos = cola.num_tareas > 0 ? cola.num_tareas : 1;
+    pthread_t hilos[MAX_HILOS];
+    double inicio = ahora();
+    for (int i = 1; i < num_hilos; i++) {
+        if (pthread_create(&hilos[i], NULL, trabajador, &cola) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            return 1;
+        }
+    }
+    trabajador(&cola);      // El hilo principal también es trabajador
+    for (int i = 1; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - inicio;
+
+    juntar_resultados(lista.v, lista.n, cola.tareas);
+    uint64_t total_bytes = 0, total[4] = { 0 };
+    int fallas = fallas_lista;
+    int ancho = ancho_columnas(lista.v, lista.n, columnas, lista.n + fallas_lista);
+    for (int i = 0; i < lista.n; i++) {
+        Archivo *a = &lista.v[i];
+        if (a->error) {
+            fprintf(stderr, "Error al leer el archivo '%s': %s\n", a->nombre, strerror(a->error));
+            fallas++;
+        } else if (columnas) {
+            uint64_t fila[4] = { a->texto.lineas, a->texto.palabras, a->texto.bytes,
+                                 cola.completo ? texto_linea_maxima(&a->texto) : 0 };
+            imprimir_fila(fila, columnas, ancho, (optind < argc) ? a->nombre : NULL);
+            for (int c = 0; c < 3; c++) total[c] += fila[c];
+            if (fila[3] > total[3]) total[3] = fila[3];     // En el total, -L es el máximo
+        } else {
+            total[0] += a->lineas;
+            if (!silencioso) {
+                printf("Archivo '%s': %llu líneas\n", a->nombre, (unsigned long long)a->lineas);
+            }
+        }
+        if (!a->error) total_bytes += a->texto.bytes;
+        free(a->nombre);
+    }
+
+    if (!columnas) {
+        printf("Total de líneas en todos los archivos: %llu\n", (unsigned long long)total[0]);
+    } else if (lista.n + fallas_lista > 1) {
+        imprimir_fila(total, columnas, ancho, "total");
+    }
+    // Con las columnas de wc el rendimiento va a stderr para no cambiar la salida
+    FILE *salida = columnas ? stderr : stdout;
+    if (!columnas || detallado) {
+        fprintf(salida, "%d archivos, %d tareas, %ld hilos, %s", lista.n, cola.num_tareas, num_hilos, NOMBRES_METODO[metodo]);
+        if (metodo == METODO_URING) fprintf(salida, " (%ld lecturas en vuelo por hilo)", profundidad);
+        fprintf(salida, ", %.1f MiB en %.3f s (%.1f MiB/s)\n", total_bytes / 1048576.0, segundos,
+                segundos > 0 ? total_bytes / 1048576.0 / segundos : 0.0);
+    }
+    free(cola.tareas);
+    free(cola.orden);
+    free(lista.v);
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file Ej7FalsoCompartido.c
+ * @brief Mide el costo del falso compartido (false sharing) entre hilos.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Cada hilo incrementa muchas veces su propio contador. Ningun contador se comparte,
+ * pero se comparan tres formas de guardarlos:
+ *
+ *      - empaquetado: int64_t contadores[n], varios contadores en la misma linea de cache.
+ *        Cada escritura invalida la linea en los demas nucleos, que deben volver a pedirla.
+ *      - ranura:      RanuraI64 contadores[n] de ../Comun/ranura.h, una linea por contador.
+ *      - local:       el hilo acumula en una variable local y escribe una sola vez al final.
+ *
+ * Los contadores se acceden como volatile para que el compilador haga una lectura y una
+ * escritura a memoria por incremento, como lo haria un acumulador compartido en una
+ * version que suma "en su lugar".
+ *
+ * El efecto solo aparece cuando los hilos corren al mismo tiempo en nucleos distintos;
+ * con -a cada hilo se fija a un CPU.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej7FalsoCompartido Ej7FalsoCompartido.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej7FalsoCompartido -n 4 -i 100000000 -a
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "../Comun/ranura.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define ITERACIONES 100000000L
+
+enum Modo { MODO_EMPAQUETADO, MODO_RANURA, MODO_LOCAL };
+static const char *NOMBRES_MODO[] = { "empaquetado", "ranura", "local" };
+
+int num_hilos;
+long iteraciones = ITERACIONES;
+int fijar_cpu = 0;
+enum Modo modo;
+
+int64_t *empaquetados;          // n contadores seguidos
+RanuraI64 *ranuras;             // n contadores, uno por linea de cache
+pthread_barrier_t barrera;      // Para que todos los hilos empiecen juntos
+
+/**
+ * @brief Fija el hilo que llama al CPU id modulo el numero de CPUs en linea.
+ */
+void fijar_a_cpu(int id) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(id % (cpus > 0 ? cpus : 1), &conjunto);
+    pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+}
+
+/**
+ * @brief Incrementa iteraciones veces el contador del hilo segun el modo actual.
+ * @param arg Puntero a entero con el indice del hilo.
+ * @return NULL
+ */
+void *incrementar(void *arg) {
+    int id = *(int *)arg;
+    if (fijar_cpu) fijar_a_cpu(id);
+
+    volatile int64_t *contador = (modo == MODO_EMPAQUETADO) ? &empaquetados[id] : &ranuras[id].valor;
+    pthread_barrier_wait(&barrera);
+
+    if (modo == MODO_LOCAL) {
+        int64_t local = 0;
+        for (long i = 0; i < iteraciones; i++) {
+            __asm__ volatile("" : "+r"(local));     // Evita que el lazo se reduzca a una suma
+            local++;
+        }
+        *contador = local;
+    } else {
+        for (long i = 0; i < iteraciones; i++) {
+            (*contador)++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ejecuta los hilos en un modo y devuelve los segundos que tardaron.
+ */
+double medir(enum Modo m) {
+    pthread_t hilos[MAX_HILOS];
+    int ids[MAX_HILOS];
+
+    modo = m;
+    for (int i = 0; i < num_hilos; i++) {
+        empaquetados[i] = 0;
+        ranuras[i].valor = 0;
+    }
+    // El hilo principal tambien espera en la barrera y toma el tiempo al soltarla
+    pthread_barrier_init(&barrera, NULL, num_hilos + 1);
+    for (int i = 0; i < num_hilos; i++) {
+        ids[i] = i;
+        if (pthread_create(&hilos[i], NULL, incrementar, &ids[i]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    pthread_barrier_wait(&barrera);
+    double inicio = ahora();
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - inicio;
+    pthread_barrier_destroy(&barrera);
+
+    for (int i = 0; i < num_hilos; i++) {
+        int64_t valor = (m == MODO_EMPAQUETADO) ? empaquetados[i] : ranuras[i].valor;
+        if (valor != iteraciones) {
+            fprintf(stderr, "Contador %d incorrecto: %lld\n", i, (long long)valor);
+        }
+    }
+    return segundos;
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN), valor;
+    int opcion;
+
+    num_hilos = (cpus > 1) ? (int)(cpus < MAX_HILOS ? cpus : MAX_HILOS) : 2;
+    while ((opcion = getopt(argc, argv, "n:i:a")) != -1) {
+        switch (opcion) {
+            case 'n':
+                if (leer_entero(optarg, 1, MAX_HILOS, &valor) != 0) {
+                    fprintf(stderr, "Número de hilos inválido: %s (1..%d)\n", optarg, MAX_HILOS);
+                    return 1;
+                }
+                num_hilos = (int)valor;
+                break;
+            case 'i':
+                if (leer_entero(optarg, 1, 1L << 40, &valor) != 0) {
+                    fprintf(stderr, "Iteraciones inválidas: %s\n", optarg);
+                    return 1;
+                }
+                iteraciones = valor;
+                break;
+            case 'a':
+                fijar_cpu = 1;
+                break;
+            default:
+                fprintf(stderr, "Uso: %s [-n hilos] [-i iteraciones] [-a]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    empaquetados = aligned_alloc(LINEA_CACHE, ranura_tam(sizeof(int64_t) * num_hilos));
+    ranuras = ranuras_reservar(num_hilos, sizeof(RanuraI64));
+    if (!empaquetados || !ranuras) {
+        fprintf(stderr, "Error al asignar memoria para los contadores.\n");
+        return 1;
+    }
+
+    printf("Hilos: %d, iteraciones por hilo: %ld, CPUs en línea: %ld, línea de cache: %d bytes\n",
+           num_hilos, iteraciones, cpus, LINEA_CACHE);
+    if (cpus < 2) {
+        printf("Aviso: con un solo CPU los hilos no corren a la vez y no hay falso compartido que medir.\n");
+    }
+    double tiempos[3];
+    for (int m = MODO_EMPAQUETADO; m <= MODO_LOCAL; m++) {
+        tiempos[m] = medir((enum Modo)m);
+        printf("%-12s %8.3f s  %6.2f ns/incremento\n", NOMBRES_MODO[m], tiempos[m],
+               tiempos[m] * 1e9 / iteraciones);
+    }
+    printf("Penalización del falso compartido: %.1fx (empaquetado / ranura)\n",
+           tiempos[MODO_EMPAQUETADO] / tiempos[MODO_RANURA]);
+
+    free(empaquetados);
+    free(ranuras);
+    return 0;
+}
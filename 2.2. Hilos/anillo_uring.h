@@ -0,0 +1,169 @@
+/**
+ * @file anillo_uring.h
+ * @brief Envoltura minima de io_uring con llamadas al sistema directas (sin liburing).
+ * @author Salvador Gonzalez Arellano
+ *
+ * io_uring comparte con el kernel dos colas circulares proyectadas en memoria:
+ *      - La cola de envio (SQ): el programa escribe ahi pedidos de lectura (SQE) y avanza
+ *        la cola; una sola llamada io_uring_enter los entrega todos al kernel.
+ *      - La cola de terminacion (CQ): el kernel escribe ahi el resultado de cada pedido
+ *        (CQE) y el programa la consume sin llamadas al sistema.
+ * Asi un solo hilo mantiene decenas de lecturas en vuelo, que es lo que necesita un
+ * disco NVMe para dar su rendimiento: con read bloqueante hay una sola a la vez por hilo.
+ *
+ * Las cabezas y colas se comparten con el kernel: se leen con semantica acquire y se
+ * escriben con release, igual que lo haria liburing.
+ *
+ * Solo usa IORING_OP_READV (Linux 5.1). Si el kernel no tiene io_uring (ENOSYS) o esta
+ * deshabilitado (EPERM, /proc/sys/kernel/io_uring_disabled), uring_iniciar devuelve -1
+ * y el programa debe usar otro metodo de lectura.
+ */
+
+#ifndef ANILLO_URING_H
+#define ANILLO_URING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+/**
+ * @struct AnilloUring
+ * @brief Las dos colas de un io_uring proyectadas en memoria.
+ */
+typedef struct {
+    int fd;
+    unsigned *sq_cabeza, *sq_cola, *sq_mascara, *sq_indices;
+    unsigned *cq_cabeza, *cq_cola, *cq_mascara;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    unsigned pendientes;        ///< SQE escritos que aun no se entregan con uring_enviar
+    void *sq_memoria, *cq_memoria;
+    size_t sq_tam, cq_tam, sqes_tam;
+} AnilloUring;
+
+/**
+ * @brief Crea un io_uring con al menos `entradas` lugares en la cola de envio.
+ * @return int 0 si todo salio bien, -1 si no (errno indica por que)
+ */
+static inline int uring_iniciar(AnilloUring *anillo, unsigned entradas) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(anillo, 0, sizeof(*anillo));
+
+    anillo->fd = (int)syscall(__NR_io_uring_setup, entradas, &p);
+    if (anillo->fd < 0) return -1;
+
+    anillo->sq_tam = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    anillo->cq_tam = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    // Desde Linux 5.4 las dos colas viven en una sola proyeccion
+    int una_sola = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (una_sola) {
+        if (anillo->cq_tam > anillo->sq_tam) anillo->sq_tam = anillo->cq_tam;
+        anillo->cq_tam = anillo->sq_tam;
+    }
+
+    anillo->sq_memoria = mmap(NULL, anillo->sq_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              anillo->fd, IORING_OFF_SQ_RING);
+    if (anillo->sq_memoria == MAP_FAILED) goto error;
+    anillo->cq_memoria = una_sola ? anillo->sq_memoria
+                                  : mmap(NULL, anillo->cq_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                         anillo->fd, IORING_OFF_CQ_RING);
+    if (anillo->cq_memoria == MAP_FAILED) goto error;
+    anillo->sqes_tam = p.sq_entries * sizeof(struct io_uring_sqe);
+    anillo->sqes = mmap(NULL, anillo->sqes_tam, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        anillo->fd, IORING_OFF_SQES);
+    if (anillo->sqes == MAP_FAILED) goto error;
+
+    char *sq = anillo->sq_memoria, *cq = anillo->cq_memoria;
+    anillo->sq_cabeza = (unsigned *)(sq + p.sq_off.head);
+    anillo->sq_cola = (unsigned *)(sq + p.sq_off.tail);
+    anillo->sq_mascara = (unsigned *)(sq + p.sq_off.ring_mask);
+    anillo->sq_indices = (unsigned *)(sq + p.sq_off.array);
+    anillo->cq_cabeza = (unsigned *)(cq + p.cq_off.head);
+    anillo->cq_cola = (unsigned *)(cq + p.cq_off.tail);
+    anillo->cq_mascara = (unsigned *)(cq + p.cq_off.ring_mask);
+    anillo->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+
+error:;
+    int codigo = errno;
+    if (anillo->sq_memoria && anillo->sq_memoria != MAP_FAILED) munmap(anillo->sq_memoria, anillo->sq_tam);
+    if (!una_sola && anillo->cq_memoria && anillo->cq_memoria != MAP_FAILED) munmap(anillo->cq_memoria, anillo->cq_tam);
+    close(anillo->fd);
+    errno = codigo;
+    return -1;
+}
+
+static inline void uring_cerrar(AnilloUring *anillo) {
+    munmap(anillo->sqes, anillo->sqes_tam);
+    if (anillo->cq_memoria != anillo->sq_memoria) munmap(anillo->cq_memoria, anillo->cq_tam);
+    munmap(anillo->sq_memoria, anillo->sq_tam);
+    close(anillo->fd);
+}
+
+/**
+ * @brief Escribe en la cola de envio una lectura de iov en fd desde desplazamiento.
+ *
+ * El pedido no llega al kernel hasta uring_enviar. El iovec debe seguir valido hasta
+ * que llegue su terminacion. El llamador no debe tener mas lecturas en vuelo que
+ * entradas tiene el anillo.
+ */
+static inline void uring_pedir_lectura(AnilloUring *anillo, int fd, const struct iovec *iov,
+                                       uint64_t desplazamiento, uint64_t dato) {
+    unsigned cola = *anillo->sq_cola;
+    unsigned i = cola & *anillo->sq_mascara;
+    struct io_uring_sqe *sqe = &anillo->sqes[i];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)iov;
+    sqe->len = 1;
+    sqe->off = desplazamiento;
+    sqe->user_data = dato;
+    anillo->sq_indices[i] = i;
+    // El kernel no debe ver la nueva cola antes que el SQE completo
+    __atomic_store_n(anillo->sq_cola, cola + 1, __ATOMIC_RELEASE);
+    anillo->pendientes++;
+}
+
+/**
+ * @brief Entrega los pedidos pendientes y espera hasta tener `esperar` terminaciones.
+ * @return int 0 si todo salio bien, -1 si io_uring_enter fallo (errno indica por que)
+ */
+static inline int uring_enviar(AnilloUring *anillo, unsigned esperar) {
+    while (anillo->pendientes > 0 || esperar > 0) {
+        long r = syscall(__NR_io_uring_enter, anillo->fd, anillo->pendientes, esperar,
+                         esperar ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        anillo->pendientes -= (unsigned)r;
+        esperar = 0;    // Si quedaron pedidos sin entregar se entregan sin esperar mas
+    }
+    return 0;
+}
+
+/**
+ * @brief Toma la siguiente terminacion, si hay.
+ * @return int 1 si habia una (queda en dato y resultado), 0 si la cola esta vacia
+ */
+static inline int uring_terminacion(AnilloUring *anillo, uint64_t *dato, int *resultado) {
+    unsigned cabeza = *anillo->cq_cabeza;
+    if (cabeza == __atomic_load_n(anillo->cq_cola, __ATOMIC_ACQUIRE)) return 0;
+
+    struct io_uring_cqe *cqe = &anillo->cqes[cabeza & *anillo->cq_mascara];
+    *dato = cqe->user_data;
+    *resultado = cqe->res;
+    // Devuelve el lugar al kernel despues de leer el CQE
+    __atomic_store_n(anillo->cq_cabeza, cabeza + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#endif // ANILLO_URING_H
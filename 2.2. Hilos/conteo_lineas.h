@@ -0,0 +1,331 @@
+/**
+ * @file conteo_lineas.h
+ * @brief Conteo de lineas (y de palabras, bytes y linea mas larga, como wc) con mmap e
+ *        instrucciones SIMD.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Reemplaza el conteo con fgets y un bufer de 256 bytes de la primera version de
+ * Ej5Archivos.c, que era lento y contaba dos veces las lineas de mas de 255 bytes.
+ *
+ *      - contar_saltos: cuenta los '\n' de un bloque de memoria. Con AVX2 compara 32 bytes
+ *        por instruccion contra '\n', convierte el resultado en una mascara de bits
+ *        (movemask) y cuenta sus unos (popcount); con SSE2 hace lo mismo de 16 en 16.
+ *      - proyectar_rango: proyecta en memoria con mmap (sin copiarlo a un bufer) un rango
+ *        de bytes de un archivo. Ej5Archivos.c divide los archivos grandes en tareas de
+ *        CONTEO_RANGO_MIN bytes, asi un solo archivo de 50 GB usa todos los nucleos.
+ *      - texto_contar: lineas, palabras, bytes y ancho de la linea mas larga en una sola
+ *        pasada (ver EstadisticasTexto).
+ *
+ * Una linea es un '\n' o, si el archivo no termina en '\n', tambien el texto final:
+ * lineas = saltos + (tamano > 0 y ultimo byte != '\n'). Es lo que contaba fgets.
+ */
+
+#ifndef CONTEO_LINEAS_H
+#define CONTEO_LINEAS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#define CONTEO_RANGO_MIN (64UL << 20)           // Bytes por tarea de un archivo grande (64 MiB)
+#define CONTEO_TAM_LECTURA (1UL << 20)          // Bufer de read para archivos sin mmap
+
+/**
+ * @brief Cuenta los bytes '\n' de datos[0, n).
+ */
+static inline uint64_t contar_saltos(const char *datos, size_t n) {
+    uint64_t cuenta = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i salto = _mm256_set1_epi8('\n');
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(datos + i));
+        cuenta += (uint64_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, salto)));
+    }
+#elif defined(__SSE2__)
+    const __m128i salto = _mm_set1_epi8('\n');
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(datos + i));
+        cuenta += (uint64_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, salto)));
+    }
+#endif
+    for (; i < n; i++) {
+        cuenta += (datos[i] == '\n');
+    }
+    return cuenta;
+}
+
+/**
+ * @brief Proyecta en memoria los bytes [desde, hasta) de un archivo regular.
+ *
+ * mmap exige que el desplazamiento sea multiplo del tamano de pagina, asi que se
+ * proyecta desde la pagina que contiene a desde. Sirve para que varias tareas
+ * independientes lean partes del mismo archivo. Se libera con munmap(*base, *tam).
+ *
+ * @return const char* Puntero al byte desde, o NULL si falla (errno indica por que)
+ */
+static inline const char *proyectar_rango(const char *nombre, uint64_t desde, uint64_t hasta,
+                                          void **base, size_t *tam) {
+    int fd = open(nombre, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    uint64_t pagina = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t inicio = desde / pagina * pagina;
+    *tam = (size_t)(hasta - inicio);
+    *base = mmap(NULL, *tam, PROT_READ, MAP_PRIVATE, fd, (off_t)inicio);
+    int error = errno;
+    close(fd);
+    if (*base == MAP_FAILED) {
+        errno = error;
+        return NULL;
+    }
+    madvise(*base, *tam, MADV_SEQUENTIAL);
+    return (const char *)*base + (desde - inicio);
+}
+
+/**
+ * @struct EstadisticasTexto
+ * @brief Lo que cuenta wc (lineas, palabras, bytes, linea mas larga) de un trozo de texto.
+ *
+ * Sigue las reglas de GNU wc con LC_ALL=C:
+ *      - Una linea es un '\n'.
+ *      - Una palabra es una secuencia de bytes imprimibles (0x21..0x7e) separada por
+ *        espacios (' ', \t, \n, \v, \f, \r). Los demas bytes (control, >= 0x80) no
+ *        empiezan ni terminan palabras.
+ *      - El ancho de una linea (wc -L) cuenta 1 por byte imprimible; \t avanza al
+ *        siguiente multiplo de 8, \r y \f vuelven a la columna 0 y los demas bytes no
+ *        ocupan lugar.
+ *
+ * Un archivo se puede dividir en trozos que se cuentan por separado y en cualquier
+ * orden, y luego se juntan de izquierda a derecha con texto_juntar. Para eso cada trozo
+ * guarda lo que depende de lo que hay antes de el:
+ *      - Si empieza dentro de una palabra (empieza_en_palabra) y el trozo anterior
+ *        termino dentro de una (en_palabra), esa palabra se conto dos veces.
+ *      - El texto antes del primer fin de linea continua la linea del trozo anterior,
+ *        que estaba en la columna c. Su ancho es c + prefijo_a, o, si contiene un \t,
+ *        tabular(c + prefijo_a) + prefijo_b: despues del primer \t la columna ya es
+ *        multiplo de 8 y lo que sigue no depende de c.
+ */
+typedef struct {
+    uint64_t lineas;
+    uint64_t palabras;
+    uint64_t bytes;
+    uint64_t maxima;            ///< Linea mas ancha que empieza y termina dentro del trozo
+    uint64_t prefijo_a;         ///< Ancho antes del primer \t del prefijo
+    uint64_t prefijo_b;         ///< Ancho despues del primer \t del prefijo
+    uint64_t sufijo;            ///< Columna al final del trozo (si tiene_fin)
+    uint8_t tiene_fin;          ///< Hay un fin de linea ('\n', \r o \f) en el trozo
+    uint8_t prefijo_tab;        ///< El prefijo contiene un \t
+    uint8_t transparente;       ///< Todavia no hay bytes que sean palabra o separador
+    uint8_t empieza_en_palabra; ///< El primer byte no transparente es de palabra
+    uint8_t en_palabra;         ///< El ultimo byte no transparente es de palabra
+} EstadisticasTexto;
+
+static inline void texto_iniciar(EstadisticasTexto *e) {
+    memset(e, 0, sizeof(*e));
+    e->transparente = 1;
+}
+
+/**
+ * @brief Columna despues de un \t en la columna x (GNU wc siempre avanza al menos 1).
+ */
+static inline uint64_t texto_tabular(uint64_t x) {
+    return x - x % 8 + 8;
+}
+
+/**
+ * @brief Ancho del prefijo si la linea venia en la columna c.
+ */
+static inline uint64_t texto_aplicar(const EstadisticasTexto *e, uint64_t c) {
+    return e->prefijo_tab ? texto_tabular(c + e->prefijo_a) + e->prefijo_b : c + e->prefijo_a;
+}
+
+static inline void texto_avanzar(EstadisticasTexto *e, uint64_t n) {
+    if (e->tiene_fin) e->sufijo += n;
+    else if (e->prefijo_tab) e->prefijo_b += n;
+    else e->prefijo_a += n;
+}
+
+static inline void texto_tabulador(EstadisticasTexto *e) {
+    if (e->tiene_fin) {
+        e->sufijo = texto_tabular(e->sufijo);
+    } else if (e->prefijo_tab) {
+        e->prefijo_b = texto_tabular(e->prefijo_b);
+    } else {
+        e->prefijo_tab = 1;
+        e->prefijo_b = 0;
+    }
+}
+
+static inline void texto_fin_linea(EstadisticasTexto *e) {
+    if (e->tiene_fin && e->sufijo > e->maxima) e->maxima = e->sufijo;
+    e->tiene_fin = 1;
+    e->sufijo = 0;
+}
+
+static inline void texto_visto(EstadisticasTexto *e, int palabra) {
+    if (e->transparente) {
+        e->transparente = 0;
+        e->empieza_en_palabra = (uint8_t)palabra;
+    }
+    e->palabras += (palabra && !e->en_palabra);
+    e->en_palabra = (uint8_t)palabra;
+}
+
+/**
+ * @brief Procesa un byte con las reglas de GNU wc (camino escalar).
+ */
+static inline void texto_byte(EstadisticasTexto *e, unsigned char c) {
+    int palabra = 0;
+    switch (c) {
+        case '\n': e->lineas++; texto_fin_linea(e); break;
+        case '\r': case '\f': texto_fin_linea(e); break;
+        case '\t': texto_tabulador(e); break;
+        case ' ': texto_avanzar(e, 1); break;
+        case '\v': break;
+        default:
+            if (c < 0x20 || c >= 0x7f) return;     // No imprimible: no cambia nada
+            texto_avanzar(e, 1);
+            palabra = 1;
+    }
+    texto_visto(e, palabra);
+}
+
+/**
+ * @brief Procesa un bloque de w bytes que solo tiene imprimibles y '\n' (camino rapido).
+ *
+ * @param palabra Mascara de bits de los bytes de palabra (imprimibles que no son ' ')
+ * @param saltos Mascara de bits de los '\n'
+ */
+static inline void texto_bloque(EstadisticasTexto *e, uint32_t palabra, uint32_t saltos, int w) {
+    if (e->transparente) {
+        e->transparente = 0;
+        e->empieza_en_palabra = palabra & 1;
+    }
+    // Empieza una palabra donde hay un byte de palabra y el anterior no lo es
+    uint32_t anterior = (palabra << 1) | e->en_palabra;
+    e->palabras += (uint64_t)__builtin_popcount(palabra & ~anterior);
+    e->en_palabra = (palabra >> (w - 1)) & 1;
+
+    // Cada byte que no es '\n' ocupa una columna
+    int posicion = 0;
+    e->lineas += (uint64_t)__builtin_popcount(saltos);
+    while (saltos) {
+        int p = __builtin_ctz(saltos);
+        texto_avanzar(e, (uint64_t)(p - posicion));
+        texto_fin_linea(e);
+        posicion = p + 1;
+        saltos &= saltos - 1;
+    }
+    texto_avanzar(e, (uint64_t)(w - posicion));
+}
+
+/**
+ * @brief Agrega datos[0, n) a las estadisticas (se puede llamar con bufer tras bufer).
+ *
+ * Con AVX2 (o SSE2) clasifica 32 (o 16) bytes a la vez. Si el bloque solo tiene texto
+ * imprimible y '\n', que es lo normal en un log, palabras y lineas salen de mascaras
+ * de bits con popcount; si tiene tabuladores, \r u otros bytes se procesa byte a byte.
+ */
+static inline void texto_contar(EstadisticasTexto *e, const char *datos, size_t n) {
+    size_t i = 0;
+    e->bytes += n;
+#if defined(__AVX2__)
+    const __m256i salto = _mm256_set1_epi8('\n'), espacio = _mm256_set1_epi8(' ');
+    const __m256i menor = _mm256_set1_epi8(0x1f), mayor = _mm256_set1_epi8(0x7f);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(datos + i));
+        // Comparacion con signo: los bytes >= 0x80 son negativos y no son imprimibles
+        __m256i imprimible = _mm256_and_si256(_mm256_cmpgt_epi8(v, menor), _mm256_cmpgt_epi8(mayor, v));
+        __m256i saltos = _mm256_cmpeq_epi8(v, salto);
+        if ((uint32_t)_mm256_movemask_epi8(_mm256_or_si256(imprimible, saltos)) == 0xFFFFFFFFu) {
+            __m256i palabra = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, espacio), imprimible);
+            texto_bloque(e, (uint32_t)_mm256_movemask_epi8(palabra), (uint32_t)_mm256_movemask_epi8(saltos), 32);
+        } else {
+            for (size_t j = i; j < i + 32; j++) texto_byte(e, (unsigned char)datos[j]);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i salto = _mm_set1_epi8('\n'), espacio = _mm_set1_epi8(' ');
+    const __m128i menor = _mm_set1_epi8(0x1f), mayor = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(datos + i));
+        __m128i imprimible = _mm_and_si128(_mm_cmpgt_epi8(v, menor), _mm_cmpgt_epi8(mayor, v));
+        __m128i saltos = _mm_cmpeq_epi8(v, salto);
+        if ((uint32_t)_mm_movemask_epi8(_mm_or_si128(imprimible, saltos)) == 0xFFFFu) {
+            __m128i palabra = _mm_andnot_si128(_mm_cmpeq_epi8(v, espacio), imprimible);
+            texto_bloque(e, (uint32_t)_mm_movemask_epi8(palabra), (uint32_t)_mm_movemask_epi8(saltos), 16);
+        } else {
+            for (size_t j = i; j < i + 16; j++) texto_byte(e, (unsigned char)datos[j]);
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        texto_byte(e, (unsigned char)datos[i]);
+    }
+}
+
+/**
+ * @brief Junta las estadisticas de un trozo con las del trozo que le sigue: izq = izq + der.
+ */
+static inline void texto_juntar(EstadisticasTexto *izq, const EstadisticasTexto *der) {
+    // Una palabra partida entre los dos trozos se conto en ambos
+    int partida = !izq->transparente && izq->en_palabra && !der->transparente && der->empieza_en_palabra;
+    izq->palabras += der->palabras - (uint64_t)partida;
+    izq->lineas += der->lineas;
+    izq->bytes += der->bytes;
+    if (izq->transparente) {
+        izq->transparente = der->transparente;
+        izq->empieza_en_palabra = der->empieza_en_palabra;
+        izq->en_palabra = der->en_palabra;
+    } else if (!der->transparente) {
+        izq->en_palabra = der->en_palabra;
+    }
+
+    if (!izq->tiene_fin) {
+        // El prefijo de izq sigue en der: se componen los dos prefijos
+        if (izq->prefijo_tab && der->prefijo_tab) {
+            izq->prefijo_b = texto_tabular(izq->prefijo_b + der->prefijo_a) + der->prefijo_b;
+        } else if (izq->prefijo_tab) {
+            izq->prefijo_b += der->prefijo_a;
+        } else {
+            izq->prefijo_a += der->prefijo_a;
+            izq->prefijo_tab = der->prefijo_tab;
+            izq->prefijo_b = der->prefijo_b;
+        }
+        izq->tiene_fin = der->tiene_fin;
+        izq->maxima = der->maxima;
+        izq->sufijo = der->sufijo;
+        return;
+    }
+
+    // La ultima linea de izq continua en el prefijo de der
+    uint64_t ancho = texto_aplicar(der, izq->sufijo);
+    if (der->tiene_fin) {
+        if (ancho > izq->maxima) izq->maxima = ancho;
+        if (der->maxima > izq->maxima) izq->maxima = der->maxima;
+        izq->sufijo = der->sufijo;
+    } else {
+        izq->sufijo = ancho;
+    }
+}
+
+/**
+ * @brief Ancho de la linea mas larga de un archivo completo (wc -L).
+ */
+static inline uint64_t texto_linea_maxima(const EstadisticasTexto *e) {
+    uint64_t maxima = e->maxima, primera = texto_aplicar(e, 0);
+    if (primera > maxima) maxima = primera;
+    if (e->tiene_fin && e->sufijo > maxima) maxima = e->sufijo;
+    return maxima;
+}
+
+#endif // CONTEO_LINEAS_H
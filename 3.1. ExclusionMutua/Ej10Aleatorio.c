@@ -0,0 +1,159 @@
+/**
+ * @file Ej10Aleatorio.c
+ * @brief Números aleatorios por segundo con rand(), rand_r y el generador por hilo de
+ *        ../Comun/aleatorio.h, al agregar hilos.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Los cajeros, los filósofos, el puente y los productores llamaban rand() desde todos sus
+ * hilos. rand() guarda su estado en una variable global protegida por un cerrojo de glibc,
+ * así que cada número aleatorio es una pequeña región crítica: los hilos se forman en ese
+ * cerrojo y la línea de caché del estado viaja de núcleo en núcleo. En un benchmark de
+ * cerrojos eso es un segundo cerrojo escondido que se mide junto con el que se quiere medir.
+ *
+ * Cada hilo genera -r números en [0, 50) (el monto de un cajero) con cuatro generadores:
+ *      - rand:           rand() % 50, estado global con cerrojo.
+ *      - rand_r:         rand_r(&semilla) % 50, semilla propia de 32 bits por hilo.
+ *      - aleatorio:      aleatorio_rango(&rng, 50) con un Aleatorio local del hilo.
+ *      - aleatorio_hilo: aleatorio_rango(aleatorio_hilo(), 50), el que usan ahora las
+ *                        simulaciones en lugar de rand().
+ * Por cada generador y número de hilos escribe una fila CSV con los números por segundo
+ * entre todos los hilos y los nanosegundos por número de cada hilo. Con rand los números
+ * por segundo no suben (o bajan) al agregar hilos; con los otros crecen con los núcleos.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej10Aleatorio Ej10Aleatorio.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej10Aleatorio                         (1,2,4,8 hilos)
+ *      ./Ej10Aleatorio -n 1,2,4,8,16 -r 10000000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../Comun/ranura.h"
+#include "../Comun/aleatorio.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define MAX_LISTA 32                // Elementos máximos en la lista de hilos
+#define REPETICIONES 1000000        // Números por hilo por defecto
+#define RANGO 50                    // Los números van de 0 a RANGO - 1, como los montos
+
+enum { RAND, RAND_R, ALEATORIO, ALEATORIO_HILO };
+static const char *NOMBRES[] = { "rand", "rand_r", "aleatorio", "aleatorio_hilo" };
+
+DEFINIR_RANURA(RanuraSuma, uint64_t);
+
+RanuraSuma *sumas;                  // Suma de los números de cada hilo, para que no se eliminen
+pthread_barrier_t inicio;           // Todos empiezan a la vez
+long repeticiones = REPETICIONES;
+int generador;
+
+void *trabajo(void *arg) {
+    int id = *(int *)arg;
+    uint64_t suma = 0;
+    unsigned semilla = (unsigned)id + 1;
+    Aleatorio rng;
+    aleatorio_sembrar(&rng, 1, (uint64_t)id);
+
+    pthread_barrier_wait(&inicio);
+    switch (generador) {
+        case RAND:
+            for (long i = 0; i < repeticiones; i++) suma += (uint64_t)(rand() % RANGO);
+            break;
+        case RAND_R:
+            for (long i = 0; i < repeticiones; i++) suma += (uint64_t)(rand_r(&semilla) % RANGO);
+            break;
+        case ALEATORIO:
+            for (long i = 0; i < repeticiones; i++) suma += aleatorio_rango(&rng, RANGO);
+            break;
+        case ALEATORIO_HILO:
+            for (long i = 0; i < repeticiones; i++) suma += aleatorio_rango(aleatorio_hilo(), RANGO);
+            break;
+    }
+    sumas[id].valor = suma;
+    return NULL;
+}
+
+/**
+ * @brief Corre un generador con num_hilos hilos y escribe su fila.
+ * @return int 0 si todo salió bien, -1 si no hubo memoria o no se crearon los hilos
+ */
+int medir(int g, int num_hilos) {
+    pthread_t hilos[MAX_HILOS];
+    int indices[MAX_HILOS];
+
+    generador = g;
+    sumas = ranuras_reservar(num_hilos, sizeof(RanuraSuma));
+    if (!sumas) return -1;
+    pthread_barrier_init(&inicio, NULL, (unsigned)num_hilos);
+
+    double t0 = ahora();
+    for (int i = 0; i < num_hilos; i++) {
+        indices[i] = i;
+        if (pthread_create(&hilos[i], NULL, trabajo, &indices[i]) != 0) return -1;
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - t0;
+    double total = (double)repeticiones * num_hilos;
+    uint64_t suma = 0;
+    for (int i = 0; i < num_hilos; i++) {
+        suma += sumas[i].valor;
+    }
+    // La media de [0, RANGO) es (RANGO - 1) / 2; solo sirve para ver que nada está roto
+    printf("%s,%d,%.0f,%.2f,%.2f\n", NOMBRES[g], num_hilos, total / segundos,
+           segundos * 1e9 * num_hilos / total, (double)suma / total);
+
+    pthread_barrier_destroy(&inicio);
+    free(sumas);
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-n hilos] [-r repeticiones]\n"
+            "  -n L   lista de números de hilos (por defecto 1,2,4,8)\n"
+            "  -r N   números por hilo (por defecto %d)\n",
+            programa, REPETICIONES);
+}
+
+int main(int argc, char *argv[]) {
+    long hilos[MAX_LISTA] = { 1, 2, 4, 8 };
+    int num_hilos = 4;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:r:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'n': valido = (num_hilos = leer_lista(optarg, 1, MAX_HILOS, hilos, MAX_LISTA)) > 0; break;
+            case 'r': valido = leer_entero(optarg, 1, 1000000000, &repeticiones) == 0; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    srand((unsigned)time(NULL));
+    aleatorio_semilla_hilos((uint64_t)time(NULL));
+    printf("# %ld CPU, %ld números por hilo\n", sysconf(_SC_NPROCESSORS_ONLN), repeticiones);
+    printf("generador,hilos,numeros_s,ns_por_numero,media\n");
+    for (int g = RAND; g <= ALEATORIO_HILO; g++) {
+        for (int h = 0; h < num_hilos; h++) {
+            if (medir(g, (int)hilos[h]) != 0) {
+                fprintf(stderr, "Error al reservar memoria o crear los hilos.\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file Ej1AlgoritmoFiltroV3.c
+ * @brief Prueba de estrés del algoritmo de filtro con atómicos de C11 contra la versión
+ *        de Ej1AlgoritmoFiltroV2.c.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Ej1AlgoritmoFiltroV2.c explica por qué el filtro con variables normales falla: el
+ * compilador y la CPU reordenan las escrituras de level[i] y last_to_enter[l] con las
+ * lecturas que siguen. En x86 basta el búfer de escrituras de cada núcleo: un hilo puede
+ * leer level[k] antes de que su propia escritura de level[i] sea visible para los demás.
+ *
+ * La versión corregida está en cerrojos.h (filtro_c11_entrar y filtro_c11_salir):
+ *      - level y last_to_enter son _Atomic, cada elemento en su propia línea de caché.
+ *      - last_to_enter[l] se escribe con atomic_exchange (acq_rel). Es la única barrera
+ *        por nivel: ordena la escritura de level[i] y la de last_to_enter[l] antes de las
+ *        lecturas del while, y en x86 se traduce en un xchg, que ya es una barrera completa.
+ *      - Las lecturas son acquire y salir_region_critica escribe level[i] = -1 con release,
+ *        así el siguiente hilo ve lo que se hizo en la región crítica.
+ *      - El while de espera ejecuta la instrucción pause.
+ *
+ * Este programa repite -k rondas del experimento de Ej1AlgoritmoFiltroV2.c con cada
+ * versión: -n hilos incrementan -r veces un contador dentro de la región crítica. Por
+ * cada versión reporta cuántas rondas terminaron con el contador mal, el peor valor y el
+ * tiempo promedio por entrada a la región crítica. El contador es volatile para que el
+ * incremento sea una lectura y una escritura separadas dentro de la región crítica.
+ *
+ * Los errores de la versión anterior solo aparecen con varios núcleos: con una sola CPU
+ * los hilos no corren al mismo tiempo y las dos versiones dan el valor correcto.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej1AlgoritmoFiltroV3 Ej1AlgoritmoFiltroV3.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej1AlgoritmoFiltroV3                  (4 hilos, 100000 repeticiones, 5 rondas)
+ *      ./Ej1AlgoritmoFiltroV3 -n 8 -r 20000 -k 20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cerrojos.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 64
+#define NUM_HILOS 4             // Número de hilos por defecto
+#define REPETICIONES 100000     // Incrementos por hilo por defecto
+#define RONDAS 5                // Rondas por defecto
+
+/**
+ * @struct Prueba
+ * @brief Estado compartido de una ronda.
+ */
+typedef struct {
+    const TipoCerrojo *tipo;
+    void *cerrojo;
+    long repeticiones;
+    pthread_barrier_t inicio;   // Todos empiezan a la vez
+    volatile long contador;     // Variable compartida
+} Prueba;
+
+/**
+ * @struct ArgHilo
+ * @brief Lo que recibe cada hilo.
+ */
+typedef struct {
+    Prueba *p;
+    int id;
+} ArgHilo;
+
+/**
+ * @brief Incrementa el contador muchas veces usando el cerrojo de la prueba.
+ * @param arg apuntador al ArgHilo del hilo.
+ */
+void *incrementar(void *arg) {
+    ArgHilo *a = arg;
+    Prueba *p = a->p;
+
+    pthread_barrier_wait(&p->inicio);
+    for (long j = 0; j < p->repeticiones; j++) {
+        p->tipo->entrar(p->cerrojo, a->id);
+        // Region critica
+        p->contador++;
+        p->tipo->salir(p->cerrojo, a->id);
+        // Region no critica
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ejecuta rondas del experimento con un cerrojo y escribe el resumen.
+ * @return int 0 si todo salió bien, -1 si no se pudo crear el cerrojo o los hilos
+ */
+int probar(const char *titulo, const TipoCerrojo *tipo, int num_hilos, long repeticiones, long rondas) {
+    pthread_t hilos[MAX_HILOS];
+    ArgHilo args[MAX_HILOS];
+    Prueba p;
+    long esperado = repeticiones * num_hilos, peor = esperado;
+    int errores = 0;
+    double segundos = 0;
+
+    p.tipo = tipo;
+    p.repeticiones = repeticiones;
+    for (long r = 0; r < rondas; r++) {
+        p.contador = 0;
+        p.cerrojo = tipo->crear(num_hilos);
+        if (!p.cerrojo) return -1;
+        pthread_barrier_init(&p.inicio, NULL, (unsigned)num_hilos);
+
+        double t0 = ahora();
+        for (int i = 0; i < num_hilos; i++) {
+            args[i].p = &p;
+            args[i].id = i;
+            if (pthread_create(&hilos[i], NULL, incrementar, &args[i]) != 0) return -1;
+        }
+        for (int i = 0; i < num_hilos; i++) {
+            pthread_join(hilos[i], NULL);
+        }
+        segundos += ahora() - t0;
+
+        if (p.contador != esperado) {
+            errores++;
+            if (labs(p.contador - esperado) > labs(peor - esperado)) peor = p.contador;
+        }
+        pthread_barrier_destroy(&p.inicio);
+        tipo->destruir(p.cerrojo);
+    }
+
+    printf("%-28s %ld rondas, %d con error, peor contador %ld de %ld, %.1f ns por entrada\n",
+           titulo, rondas, errores, peor, esperado, segundos * 1e9 / ((double)esperado * (double)rondas));
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-n hilos] [-r repeticiones] [-k rondas]\n"
+            "  -n N   número de hilos, de 2 a %d (por defecto %d)\n"
+            "  -r N   incrementos por hilo en cada ronda (por defecto %d)\n"
+            "  -k N   rondas con cada versión (por defecto %d)\n",
+            programa, MAX_HILOS, NUM_HILOS, REPETICIONES, RONDAS);
+}
+
+int main(int argc, char *argv[]) {
+    long num_hilos = NUM_HILOS, repeticiones = REPETICIONES, rondas = RONDAS;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:r:k:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'n': valido = leer_entero(optarg, 2, MAX_HILOS, &num_hilos) == 0; break;
+            case 'r': valido = leer_entero(optarg, 1, 100000000, &repeticiones) == 0; break;
+            case 'k': valido = leer_entero(optarg, 1, 100000, &rondas) == 0; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%ld hilos, %ld CPU, %ld incrementos por hilo\n", num_hilos, sysconf(_SC_NPROCESSORS_ONLN), repeticiones);
+    if (probar("Filtro V2 (sin atómicos):", buscar_cerrojo("filtro"), (int)num_hilos, repeticiones, rondas) != 0 ||
+        probar("Filtro V3 (atómicos C11):", buscar_cerrojo("filtro_c11"), (int)num_hilos, repeticiones, rondas) != 0) {
+        fprintf(stderr, "Error al crear el cerrojo o los hilos.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file Ej1AlgoritmoTorneo.c
+ * @brief Exclusión mutua para n hilos con un torneo de cerrojos de Peterson, usado con
+ *        las mismas funciones entrar_region_critica y salir_region_critica que
+ *        Ej1AlgoritmoFiltroV2.c.
+ * @author Salvador Gonzalez Arellano
+ *
+ * En el algoritmo de filtro un hilo pasa por n - 1 niveles y en cada uno compNivSup
+ * revisa el nivel de los n hilos: entrar cuesta O(n^2) lecturas de variables compartidas,
+ * aunque el hilo esté solo.
+ *
+ * El torneo usa el cerrojo de Peterson, que resuelve la exclusión mutua entre 2 hilos,
+ * como los partidos de un torneo de eliminación:
+ *      - Los hilos se acomodan en las hojas de un árbol binario completo.
+ *      - Cada nodo interno es un cerrojo de Peterson entre el hilo que sube por su hijo
+ *        izquierdo y el que sube por el derecho.
+ *      - Para entrar, un hilo gana los nodos desde su hoja hasta la raíz; para salir los
+ *        suelta de la raíz hacia su hoja.
+ * Entrar cuesta O(log n) nodos con 3 variables cada uno. Con 64 hilos son 6 nodos contra
+ * 63 niveles de 64 lecturas del filtro.
+ *
+ * La implementación está en cerrojos.h (torneo_entrar y torneo_salir), con atómicos de
+ * C11 y cada nodo en su propia línea de caché. Para comparar con el filtro en 4, 16 y 64
+ * hilos:
+ *      ./Ej7BenchCerrojos -c filtro_c11,torneo -n 4,16,64
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej1AlgoritmoTorneo Ej1AlgoritmoTorneo.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej1AlgoritmoTorneo                (4 hilos, 100000 incrementos cada uno)
+ *      ./Ej1AlgoritmoTorneo -n 16 -r 20000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cerrojos.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define NUM_HILOS 4             // Número de hilos por defecto
+#define REPETICIONES 100000     // Incrementos por hilo por defecto
+
+volatile long contador = 0;     // Variable compartida
+CerrojoTorneo *torneo;          // Árbol de cerrojos de Peterson
+long repeticiones = REPETICIONES;
+
+/**
+ * @brief Gana los nodos del torneo desde la hoja del hilo hasta la raíz
+ * @param i indice del hilo
+ */
+void entrar_region_critica(int i) {
+    torneo_entrar(torneo, i);
+}
+
+/**
+ * @brief Suelta los nodos del torneo que ganó el hilo
+ * @param i indice del hilo
+ */
+void salir_region_critica(int i) {
+    torneo_salir(torneo, i);
+}
+
+/**
+ * @brief Incrementa el contador muchas veces usando el torneo.
+ * @param arg apuntador al indice del hilo.
+ */
+void *incrementar(void *arg) {
+    int i = *(int *)arg;
+
+    for (long j = 0; j < repeticiones; j++) {
+        entrar_region_critica(i);
+        // Region critica
+        contador++;
+        salir_region_critica(i);
+        // Region no critica
+    }
+
+    pthread_exit(NULL);
+}
+
+int main(int argc, char *argv[]) {
+    pthread_t hilos[MAX_HILOS];
+    int indices[MAX_HILOS];  // Se requiere un arreglo separado para evitar condiciones de carrera
+    long num_hilos = NUM_HILOS;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:r:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'n': valido = leer_entero(optarg, 1, MAX_HILOS, &num_hilos) == 0; break;
+            case 'r': valido = leer_entero(optarg, 1, 100000000, &repeticiones) == 0; break;
+        }
+        if (!valido) {
+            fprintf(stderr, "Uso: %s [-n hilos (1 a %d)] [-r incrementos por hilo]\n", argv[0], MAX_HILOS);
+            return 1;
+        }
+    }
+
+    torneo = torneo_crear((int)num_hilos);
+    if (!torneo) {
+        fprintf(stderr, "Error al asignar memoria para el torneo.\n");
+        return 1;
+    }
+    printf("%ld hilos: %d niveles en el torneo\n", num_hilos, torneo->niveles);
+
+    double t0 = ahora();
+
+    /** Creamos los hilos */
+    for (int j = 0; j < num_hilos; j++) {
+        indices[j] = j;
+        pthread_create(&hilos[j], NULL, incrementar, &indices[j]);
+    }
+
+    /** Esperamos a que los hilos terminen */
+    for (int j = 0; j < num_hilos; j++) {
+        pthread_join(hilos[j], NULL);
+    }
+
+    double segundos = ahora() - t0;
+
+    printf("Valor esperado: %ld\n", repeticiones * num_hilos);
+    printf("Valor real: %ld\n", contador);
+    printf("Tiempo por entrada a la región crítica: %.1f ns\n", segundos * 1e9 / (double)(repeticiones * num_hilos));
+    torneo_destruir(torneo);
+    return contador == repeticiones * num_hilos ? 0 : 1;
+}
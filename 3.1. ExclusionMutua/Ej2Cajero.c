@@ -8,40 +8,25 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <time.h>
+#include "../Comun/aleatorio.h"
+#include "cerrojos.h"
 
 #define N 5                 // Numero de hilos
 #define OPERACIONES 100     // Operaciones a realizar
 
 int saldo = 1000;           // Saldo inicial de la cuenta
-int level[N];               // Nivel en el que se encuentra cada hilo
-int last_to_enter[N - 1];   // Ultimo hilo que entro a cada nivel
-
-/**
- * @brief Comprobar si existe k != i, tal que level[k] >= l
- * @param i indice del hilo
- * @param l nivel a revisar
- * @return 1 si la condición se cumple para alguna k, 0 en otro caso
- */
-int compNivSup(int i, int l) {
-    for (int k=0; k<N; k++) {
-        if((k != i) && level[k] >= l) {
-            return 1;
-        }
-    }
-    return 0;
-}
+void *filtro;               // Algoritmo de filtro con atomicos de C11 (cerrojos.h)
 
 /**
  * @brief Metodo con la parte que corresponde al algoritmo de filtro para entrar a 
- *        la region critica
+ *        la region critica. Con int simples en level[] y last_to_enter[] el compilador
+ *        puede sacar las lecturas del while y la CPU reordenar la escritura de level[i]
+ *        con ellas; filtro_c11_entrar usa el orden de memoria que el algoritmo necesita.
  * @param i indice del hilo
  */
 void entrar_region_critica(int i) {
-    for (int l=0; l<(N-1); l++) {
-        level[i] = l;
-        last_to_enter[l] = i;
-        while ( (last_to_enter[l] == i) && compNivSup(i,l));
-    }
+    filtro_c11_entrar(filtro, i);
 }
 
 /**
@@ -50,7 +35,7 @@ void entrar_region_critica(int i) {
  * @param i indice del hilo
  */
 void salir_region_critica(int i){
-    level[i] = -1;
+    filtro_c11_salir(filtro, i);
 }
 
 /**
@@ -59,10 +44,11 @@ void salir_region_critica(int i){
  */
 void *cajero(void *arg) {
     int id = *(int *)arg;
+    Aleatorio *rng = aleatorio_hilo();     // Generador propio del hilo (rand() tiene un cerrojo)
 
     for (int i = 0; i < OPERACIONES; i++) {
-        int operacion = rand() % 2;         // 0: retiro, 1: depósito
-        int cantidad = (rand() % 50) + 1;   // monto de la operacion
+        int operacion = aleatorio_rango(rng, 2);         // 0: retiro, 1: depósito
+        int cantidad = aleatorio_rango(rng, 50) + 1;     // monto de la operacion
 
         entrar_region_critica(id);
         // Region critica
@@ -89,11 +75,13 @@ int main() {
     pthread_t hilos[N];
     int indices[N];
 
-    srand(time(NULL)); // Para cambiar la semilla de rand en cada ejecucion
+    aleatorio_semilla_hilos(time(NULL)); // Para cambiar la semilla en cada ejecucion
 
-    /** Inicializamos los niveles del algoritmo de filtro a -1, inicialmente no hay nadie */
-    for (int i = 0; i < N; i++) {
-        level[i] = -1;
+    /** Los niveles del algoritmo de filtro empiezan en -1, inicialmente no hay nadie */
+    filtro = filtro_c11_crear(N);
+    if (!filtro) {
+        fprintf(stderr, "Error al asignar memoria para el filtro.\n");
+        return 1;
     }
 
     /** Creamos los hilos */
@@ -108,5 +96,6 @@ int main() {
     }
 
     printf("Saldo final: %d\n", saldo);
+    filtro_c11_destruir(filtro);
     return 0;
 }
\ No newline at end of file
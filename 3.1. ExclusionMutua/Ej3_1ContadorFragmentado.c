@@ -0,0 +1,256 @@
+/**
+ * @file Ej3_1ContadorFragmentado.c
+ * @brief Incrementos por segundo del atomic_int de Ej3AtomicInt.c contra un contador
+ *        con un fragmento por hilo (contador_fragmentado.h).
+ * @author Salvador Gonzalez Arellano
+ *
+ * Cada hilo suma 1 al contador -r veces, como en Ej3AtomicInt.c, con tres contadores:
+ *      - atomico:     atomic_fetch_add sobre un solo atomic_long. La línea de caché del
+ *                     contador pasa de núcleo en núcleo en cada incremento.
+ *      - fragmentado: cada hilo suma en su propio fragmento, en su propia línea de caché.
+ *      - descuidado:  como fragmentado, pero cada -u incrementos el hilo pasa lo que lleva
+ *                     a un total global; leer el global es O(1) aunque se quede corto.
+ * Por cada contador y número de hilos escribe una fila CSV con los incrementos por
+ * segundo entre todos los hilos, el valor leído al final (con la lectura exacta) y ok si
+ * es igual a hilos * repeticiones.
+ *
+ * Con el atómico los incrementos por segundo no suben (o bajan) al agregar hilos; con los
+ * fragmentos crecen con el número de núcleos.
+ *
+ * Con -l se repite cada medición con un hilo lector más que, mientras los demás suman,
+ * lee el contador en lotes de LOTE_LECTURA con contador_leer_aprox y con contador_leer (en
+ * el atómico las dos son un atomic_load). Escribe una segunda tabla con los nanosegundos
+ * por lectura y el error de cada una: lo que cada hilo dice haber sumado (lo publica en su
+ * ranura antes de cada incremento), sumado justo después de la lectura, menos lo leído. Es
+ * una cota superior del error, porque incluye lo que los hilos sumaron mientras tanto. En
+ * modo descuidado el error de contador_leer_aprox llega a hilos * (umbral - 1).
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej3_1ContadorFragmentado Ej3_1ContadorFragmentado.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej3_1ContadorFragmentado                      (1,2,4,8 hilos)
+ *      ./Ej3_1ContadorFragmentado -n 1,2,4,8,16,32 -r 10000000 -u 4096
+ *      ./Ej3_1ContadorFragmentado -n 1,4,16 -l      (además, costo y error de las lecturas)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h> // biblioteca para las instrucciones atomicas
+#include "contador_fragmentado.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define MAX_LISTA 32                // Elementos máximos en la lista de hilos
+#define REPETICIONES 1000000        // Incrementos por hilo por defecto
+#define UMBRAL 1024                 // Umbral del modo descuidado por defecto
+#define LOTE_LECTURA 64             // Lecturas seguidas que el lector mide juntas
+
+enum { ATOMICO, FRAGMENTADO, DESCUIDADO };
+static const char *NOMBRES[] = { "atomico", "fragmentado", "descuidado" };
+
+DEFINIR_RANURA(RanuraHechos, atomic_long);
+
+/**
+ * @struct Lecturas
+ * @brief Lo que mide el lector con una de las dos funciones de lectura.
+ */
+typedef struct {
+    long lotes;
+    uint64_t ns;                // Tiempo total de los lotes
+    double error_total;         // Para el promedio
+    long error_max;
+} Lecturas;
+
+_Alignas(LINEA_CACHE) atomic_long unico;   // Contador de una sola variable (modo atomico)
+ContadorFragmentado *contador;              // Contador de los otros dos modos
+RanuraHechos *hechos;                       // Incrementos que lleva cada hilo (solo con lector)
+atomic_int activos;                         // Hilos que aún suman
+pthread_barrier_t inicio;                   // Todos empiezan a la vez
+long repeticiones = REPETICIONES;
+int modo;
+int num_sumadores;
+
+void *trabajo(void *arg) {
+    int id = *(int *)arg;
+    atomic_long *propio = hechos ? &hechos[id].valor : NULL;
+
+    pthread_barrier_wait(&inicio);
+    for (long i = 0; i < repeticiones; i++) {
+        // Antes de sumar: así lo publicado nunca es menor que lo que el contador ya tiene
+        if (propio) atomic_store_explicit(propio, i + 1, memory_order_release);
+        if (modo == ATOMICO) {
+            atomic_fetch_add_explicit(&unico, 1, memory_order_relaxed);
+        } else {
+            contador_sumar(contador, id, 1);
+        }
+    }
+    if (modo == DESCUIDADO) contador_vaciar(contador, id);
+    atomic_fetch_sub(&activos, 1);
+    return NULL;
+}
+
+long leer(int exacta) {
+    if (modo == ATOMICO) return atomic_load_explicit(&unico, memory_order_relaxed);
+    return exacta ? contador_leer(contador) : contador_leer_aprox(contador);
+}
+
+/**
+ * @brief Lee LOTE_LECTURA veces seguidas y compara la última lectura con lo que los
+ *        hilos dicen haber sumado.
+ */
+void medir_lote(int exacta, Lecturas *l) {
+    long valor = 0;
+    uint64_t t0 = ahora_ns();
+    for (int k = 0; k < LOTE_LECTURA; k++) {
+        valor = leer(exacta);
+        __asm__ volatile("" : : "r"(valor));
+    }
+    l->ns += ahora_ns() - t0;
+
+    long verdad = 0;
+    for (int i = 0; i < num_sumadores; i++) {
+        verdad += atomic_load_explicit(&hechos[i].valor, memory_order_acquire);
+    }
+    long error = verdad - valor;
+    l->lotes++;
+    l->error_total += (double)error;
+    if (error > l->error_max) l->error_max = error;
+}
+
+void *lector(void *arg) {
+    Lecturas *lecturas = arg;      // [0]: contador_leer_aprox, [1]: contador_leer
+
+    pthread_barrier_wait(&inicio);
+    while (atomic_load(&activos) > 0) {
+        medir_lote(0, &lecturas[0]);
+        medir_lote(1, &lecturas[1]);
+    }
+    return NULL;
+}
+
+void escribir_lecturas(const Lecturas *l) {
+    if (l->lotes == 0) {
+        printf(",0,,,");
+        return;
+    }
+    printf(",%ld,%.1f,%.1f,%ld", l->lotes * LOTE_LECTURA,
+           (double)l->ns / ((double)l->lotes * LOTE_LECTURA), l->error_total / (double)l->lotes,
+           l->error_max);
+}
+
+/**
+ * @brief Corre un modo con num_hilos hilos y escribe su fila: la de incrementos o, con
+ *        con_lector, la de lecturas.
+ * @return int 0 si todo salió bien, -1 si no hubo memoria o no se crearon los hilos
+ */
+int medir(int m, int num_hilos, long umbral, int con_lector) {
+    pthread_t hilos[MAX_HILOS + 1];
+    int indices[MAX_HILOS];
+    Lecturas lecturas[2] = { { 0 } };
+
+    modo = m;
+    num_sumadores = num_hilos;
+    atomic_store(&unico, 0);
+    atomic_store(&activos, num_hilos);
+    contador = contador_crear(num_hilos, m == DESCUIDADO ? umbral : 0);
+    hechos = con_lector ? ranuras_reservar(num_hilos, sizeof(RanuraHechos)) : NULL;
+    if (!contador || (con_lector && !hechos)) return -1;
+    for (int i = 0; con_lector && i < num_hilos; i++) {
+        atomic_init(&hechos[i].valor, 0);
+    }
+    pthread_barrier_init(&inicio, NULL, (unsigned)(num_hilos + con_lector));
+
+    double t0 = ahora();
+    for (int i = 0; i < num_hilos; i++) {
+        indices[i] = i;
+        if (pthread_create(&hilos[i], NULL, trabajo, &indices[i]) != 0) return -1;
+    }
+    if (con_lector && pthread_create(&hilos[num_hilos], NULL, lector, lecturas) != 0) return -1;
+    for (int i = 0; i < num_hilos + con_lector; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - t0;
+    long valor = (m == ATOMICO) ? atomic_load(&unico) : contador_leer(contador);
+    long esperado = repeticiones * num_hilos;
+    printf("%s,%d,%ld,%.0f", NOMBRES[m], num_hilos, m == DESCUIDADO ? umbral : 0,
+           (double)esperado / segundos);
+    if (con_lector) {
+        escribir_lecturas(&lecturas[0]);
+        escribir_lecturas(&lecturas[1]);
+        printf("\n");
+    } else {
+        printf(",%ld,%s\n", valor, valor == esperado ? "ok" : "ERROR");
+    }
+
+    pthread_barrier_destroy(&inicio);
+    contador_destruir(contador);
+    free(hechos);
+    return 0;
+}
+
+/**
+ * @brief Corre todos los modos con cada número de hilos.
+ * @return int 0 si todo salió bien, -1 si algo falló
+ */
+int medir_todo(const long *hilos, int num_hilos, long umbral, int con_lector) {
+    for (int m = ATOMICO; m <= DESCUIDADO; m++) {
+        for (int h = 0; h < num_hilos; h++) {
+            if (medir(m, (int)hilos[h], umbral, con_lector) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-n hilos] [-r repeticiones] [-u umbral] [-l]\n"
+            "  -n L   lista de números de hilos (por defecto 1,2,4,8)\n"
+            "  -r N   incrementos por hilo (por defecto %d)\n"
+            "  -u N   incrementos que acumula cada hilo en modo descuidado (por defecto %d)\n"
+            "  -l     mide además el costo y el error de las lecturas con un hilo lector\n",
+            programa, REPETICIONES, UMBRAL);
+}
+
+int main(int argc, char *argv[]) {
+    long hilos[MAX_LISTA] = { 1, 2, 4, 8 };
+    int num_hilos = 4;
+    long umbral = UMBRAL;
+    int con_lector = 0;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:r:u:l")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'n': valido = (num_hilos = leer_lista(optarg, 1, MAX_HILOS, hilos, MAX_LISTA)) > 0; break;
+            case 'r': valido = leer_entero(optarg, 1, 1000000000, &repeticiones) == 0; break;
+            case 'u': valido = leer_entero(optarg, 1, 1000000000, &umbral) == 0; break;
+            case 'l': valido = con_lector = 1; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    printf("# %ld CPU, %ld incrementos por hilo\n", sysconf(_SC_NPROCESSORS_ONLN), repeticiones);
+    printf("contador,hilos,umbral,incrementos_s,valor,verificacion\n");
+    int error = medir_todo(hilos, num_hilos, umbral, 0);
+    if (error == 0 && con_lector) {
+        printf("\n# Con un hilo lector; error = suma de lo publicado por los hilos - lectura\n");
+        printf("contador,hilos,umbral,incrementos_s,lecturas_aprox,ns_aprox,error_medio_aprox,"
+               "error_max_aprox,lecturas,ns_leer,error_medio_leer,error_max_leer\n");
+        error = medir_todo(hilos, num_hilos, umbral, 1);
+    }
+    if (error != 0) {
+        fprintf(stderr, "Error al crear el contador o los hilos.\n");
+        return 1;
+    }
+    return 0;
+}
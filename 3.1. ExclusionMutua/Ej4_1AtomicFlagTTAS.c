@@ -0,0 +1,94 @@
+/**
+ * @file Ej4_1AtomicFlagTTAS.c
+ * @brief La región crítica de Ej4AtomicFlag.c protegida con un spinlock
+ *        test-and-test-and-set con espera exponencial, comparado con el original.
+ * @author Salvador Gonzalez Arellano
+ *
+ * En Ej4AtomicFlag.c cada vuelta de la espera activa es un atomic_flag_test_and_set: una
+ * escritura atómica que se lleva la línea de caché del cerrojo a un núcleo. Con muchos
+ * hilos girando, la línea rebota entre núcleos en cada vuelta, y el hilo que quiere
+ * soltar el cerrojo también tiene que esperar su turno para escribirla.
+ *
+ * ttas_entrar (cerrojos.h) espera leyendo el cerrojo sin escribirlo y solo intenta el
+ * intercambio cuando lo ve libre. Si pierde, espera un número aleatorio de pausas que se
+ * duplica en cada fallo hasta un tope; en el tope cede la CPU con sched_yield.
+ *
+ * El programa hace el experimento del contador con los dos cerrojos y reporta el tiempo
+ * por entrada. La diferencia crece con el número de hilos; para recorrer varios:
+ *      ./Ej7BenchCerrojos -c tas,ttas -n 4,8,16,32,64
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej4_1AtomicFlagTTAS Ej4_1AtomicFlagTTAS.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej4_1AtomicFlagTTAS               (4 hilos)
+ *      ./Ej4_1AtomicFlagTTAS 32
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h> // biblioteca para las instrucciones atomicas
+#include "cerrojos.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define NUM_HILOS 4
+#define MAX_HILOS 256
+#define REPETICIONES 100000
+
+int contador = 0;
+const TipoCerrojo *tipo;    // Cerrojo que usan los hilos en la prueba actual
+void *lock;
+
+void *trabajo(void *arg) {
+    int id = *(int *)arg;
+
+    for (int i = 0; i < REPETICIONES; i++) {
+        tipo->entrar(lock, id);
+
+        contador++;  // Región crítica
+
+        tipo->salir(lock, id);  // Libera el lock
+    }
+    return NULL;
+}
+
+/**
+ * @brief Hace el experimento del contador con un cerrojo y escribe el resultado.
+ */
+void probar(const char *nombre, int num_hilos) {
+    pthread_t hilos[MAX_HILOS];
+    int indices[MAX_HILOS];
+
+    tipo = buscar_cerrojo(nombre);
+    lock = tipo->crear(num_hilos);
+    contador = 0;
+
+    uint64_t t0 = ahora_ns();
+    for (int i = 0; i < num_hilos; i++) {
+        indices[i] = i;
+        pthread_create(&hilos[i], NULL, trabajo, &indices[i]);
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double ns = (double)(ahora_ns() - t0);
+    printf("%-5s valor esperado: %d, valor real: %d, %.1f ns por entrada\n",
+           nombre, num_hilos * REPETICIONES, contador, ns / ((double)num_hilos * REPETICIONES));
+    tipo->destruir(lock);
+}
+
+int main(int argc, char *argv[]) {
+    long num_hilos = NUM_HILOS;
+
+    if (argc > 2 || (argc == 2 && leer_entero(argv[1], 1, MAX_HILOS, &num_hilos) != 0)) {
+        fprintf(stderr, "Uso: %s [hilos (1 a %d)]\n", argv[0], MAX_HILOS);
+        return 1;
+    }
+    printf("%ld hilos, %d incrementos cada uno\n", num_hilos, REPETICIONES);
+    probar("tas", (int)num_hilos);
+    probar("ttas", (int)num_hilos);
+    return 0;
+}
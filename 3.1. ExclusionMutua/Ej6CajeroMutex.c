@@ -9,6 +9,7 @@
 #include <pthread.h>
 #include <unistd.h>
 #include <time.h>
+#include "../Comun/aleatorio.h"
 
 #define N 5                 // Numero de hilos
 #define OPERACIONES 100     // Operaciones a realizar
@@ -22,10 +23,11 @@ pthread_mutex_t mutex;      // Mutex para sincronizar acceso a saldo
  */
 void *cajero(void *arg) {
     int id = *(int *)arg;
+    Aleatorio *rng = aleatorio_hilo();     // Generador propio del hilo (rand() tiene un cerrojo)
 
     for (int i = 0; i < OPERACIONES; i++) {
-        int operacion = rand() % 2;         // 0: retiro, 1: depósito
-        int cantidad = (rand() % 50) + 1;   // monto de la operación
+        int operacion = aleatorio_rango(rng, 2);         // 0: retiro, 1: depósito
+        int cantidad = aleatorio_rango(rng, 50) + 1;     // monto de la operación
 
         // Entrar a la región crítica
         pthread_mutex_lock(&mutex);
@@ -55,7 +57,7 @@ int main() {
     pthread_t hilos[N];
     int indices[N];
 
-    srand(time(NULL)); // Semilla para rand
+    aleatorio_semilla_hilos(time(NULL)); // Semilla de los generadores de los hilos
     pthread_mutex_init(&mutex, NULL); // Inicializa el mutex con atributos por defecto
 
     for (int i = 0; i < N; i++) {
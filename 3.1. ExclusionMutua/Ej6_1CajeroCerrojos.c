@@ -0,0 +1,224 @@
+/**
+ * @file Ej6_1CajeroCerrojos.c
+ * @brief Los cajeros de Ej6CajeroMutex.c con el cerrojo a elegir: pthread_mutex, ticket,
+ *        MCS o cualquiera de cerrojos.h. Mide rendimiento e inanición con muchos hilos.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Ninguno de los cerrojos anteriores es a la vez justo y rápido: el filtro es justo pero
+ * lento, y tas es rápido pero un hilo puede quedarse esperando mucho tiempo mientras otro
+ * vuelve a tomar el cerrojo una y otra vez. cerrojos.h agrega dos cerrojos FIFO:
+ *      - ticket: cada hilo toma un número con atomic_fetch_add y espera su turno.
+ *      - mcs:    los hilos se forman en una cola enlazada y cada uno espera sobre su
+ *                propio nodo, en su propia línea de caché.
+ *
+ * Cada cajero hace -o operaciones como en Ej6CajeroMutex.c (retiro o depósito de $1 a $50
+ * al azar) y duerme -u microsegundos entre ellas. Por cada cerrojo el programa reporta:
+ *      - ops_s:       operaciones por segundo entre todos los cajeros
+ *      - espera_prom: tiempo promedio para tomar el cerrojo
+ *      - espera_max:  la espera más larga de cualquier cajero (inanición)
+ *      - fin_min_max: cuándo terminó el primer cajero entre cuándo terminó el último; con
+ *                     un cerrojo justo todos terminan casi a la vez (cerca de 1)
+ *      - verificacion: ok si el saldo final es 1000 más los depósitos menos los retiros
+ *                     aceptados que contó cada cajero
+ * Las diferencias se notan con más hilos que los 5 de Ej6CajeroMutex.c, por eso el valor
+ * por defecto es 32. Con más hilos que núcleos, ticket y mcs se degradan: si el siguiente
+ * en la fila no tiene CPU, nadie más puede entrar.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej6_1CajeroCerrojos Ej6_1CajeroCerrojos.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej6_1CajeroCerrojos                       (mutex, ticket y mcs con 32 cajeros)
+ *      ./Ej6_1CajeroCerrojos -c mutex,tas,mcs -n 64 -o 20000 -u 0
+ *      ./Ej6_1CajeroCerrojos -c mcs -n 5 -o 100 -u 10000 -v   (como Ej6CajeroMutex.c)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "cerrojos.h"
+#include "../Comun/aleatorio.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 1024
+#define MAX_LISTA 32        // Cerrojos máximos en la lista de -c
+#define N 32                // Numero de hilos por defecto
+#define OPERACIONES 10000   // Operaciones por cajero por defecto
+#define SALDO_INICIAL 1000
+#define SEMILLA 1           // Misma semilla en cada ejecución para comparar cerrojos
+
+/**
+ * @struct DatosCajero
+ * @brief Lo que cuenta cada cajero; va en su propia línea de caché.
+ */
+typedef struct {
+    long depositado;        // Suma de los depósitos
+    long retirado;          // Suma de los retiros aceptados
+    uint64_t espera_total;  // ns esperando el cerrojo
+    uint64_t espera_max;
+    uint64_t fin;           // ns desde el inicio hasta que terminó sus operaciones
+} DatosCajero;
+
+DEFINIR_RANURA(RanuraCajero, DatosCajero);
+
+int saldo = SALDO_INICIAL;      // Saldo de la cuenta, protegido por el cerrojo
+const TipoCerrojo *tipo;        // Cerrojo de la medición actual
+void *cerrojo;
+RanuraCajero *datos;
+pthread_barrier_t inicio;       // Todos los cajeros empiezan a la vez
+uint64_t t_inicio;
+long operaciones = OPERACIONES;
+long pausa_us = 0;
+int detallado = 0;              // -v: escribe cada operación como Ej6CajeroMutex.c
+
+/**
+ * @brief Función simulada de cajero que accede a saldo compartido.
+ * @param arg apuntador al índice del hilo.
+ */
+void *cajero(void *arg) {
+    int id = *(int *)arg;
+    DatosCajero *d = &datos[id].valor;
+    Aleatorio rng;
+    aleatorio_sembrar(&rng, SEMILLA, (uint64_t)id);
+
+    pthread_barrier_wait(&inicio);
+    for (long i = 0; i < operaciones; i++) {
+        int operacion = aleatorio_rango(&rng, 2);         // 0: retiro, 1: depósito
+        int cantidad = aleatorio_rango(&rng, 50) + 1;     // monto de la operación
+
+        // Entrar a la región crítica
+        uint64_t t0 = ahora_ns();
+        tipo->entrar(cerrojo, id);
+        uint64_t espera = ahora_ns() - t0;
+
+        if (operacion == 0) {
+            if (saldo >= cantidad) {
+                saldo -= cantidad;
+                d->retirado += cantidad;
+                if (detallado) printf("Hilo %d retiró $%d. Saldo: %d\n", id, cantidad, saldo);
+            } else if (detallado) {
+                printf("Hilo %d no pudo retirar $%d. Saldo insuficiente: %d\n", id, cantidad, saldo);
+            }
+        } else {
+            saldo += cantidad;
+            d->depositado += cantidad;
+            if (detallado) printf("Hilo %d depositó $%d. Saldo: %d\n", id, cantidad, saldo);
+        }
+
+        // Salir de la región crítica
+        tipo->salir(cerrojo, id);
+
+        d->espera_total += espera;
+        if (espera > d->espera_max) d->espera_max = espera;
+        if (pausa_us > 0) usleep((useconds_t)pausa_us);
+    }
+    d->fin = ahora_ns() - t_inicio;
+    return NULL;
+}
+
+/**
+ * @brief Corre la simulación con un cerrojo y escribe su fila.
+ * @return int 0 si todo salió bien, -1 si no se pudo crear el cerrojo o los hilos
+ */
+int medir(const TipoCerrojo *t, int num_hilos) {
+    pthread_t hilos[MAX_HILOS];
+    int indices[MAX_HILOS];
+
+    tipo = t;
+    cerrojo = tipo->crear(num_hilos);
+    datos = ranuras_reservar(num_hilos, sizeof(RanuraCajero));
+    if (!cerrojo || !datos) return -1;
+    memset(datos, 0, ranura_tam(sizeof(DatosCajero)) * (size_t)num_hilos);
+    saldo = SALDO_INICIAL;
+    pthread_barrier_init(&inicio, NULL, (unsigned)num_hilos);
+
+    t_inicio = ahora_ns();
+    for (int i = 0; i < num_hilos; i++) {
+        indices[i] = i;
+        if (pthread_create(&hilos[i], NULL, cajero, &indices[i]) != 0) return -1;
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = (double)(ahora_ns() - t_inicio) / 1e9;
+
+    long esperado = SALDO_INICIAL;
+    uint64_t espera_total = 0, espera_max = 0, fin_min = UINT64_MAX, fin_max = 0;
+    for (int i = 0; i < num_hilos; i++) {
+        DatosCajero *d = &datos[i].valor;
+        esperado += d->depositado - d->retirado;
+        espera_total += d->espera_total;
+        if (d->espera_max > espera_max) espera_max = d->espera_max;
+        if (d->fin < fin_min) fin_min = d->fin;
+        if (d->fin > fin_max) fin_max = d->fin;
+    }
+    double total = (double)operaciones * num_hilos;
+    printf("%s,%d,%.0f,%.0f,%llu,%.3f,%s\n", tipo->nombre, num_hilos, total / segundos,
+           (double)espera_total / total, (unsigned long long)espera_max,
+           fin_max ? (double)fin_min / (double)fin_max : 1.0, saldo == esperado ? "ok" : "ERROR");
+
+    pthread_barrier_destroy(&inicio);
+    tipo->destruir(cerrojo);
+    free(datos);
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-c cerrojos] [-n cajeros] [-o operaciones] [-u us] [-v]\n"
+            "  -c L   lista de cerrojos (por defecto mutex,ticket,mcs; disponibles:",
+            programa);
+    for (const TipoCerrojo *t = CERROJOS; t->nombre; t++) {
+        fprintf(stderr, " %s", t->nombre);
+    }
+    fprintf(stderr, ")\n"
+            "  -n N   número de cajeros (por defecto %d)\n"
+            "  -o N   operaciones por cajero (por defecto %d)\n"
+            "  -u US  microsegundos que duerme cada cajero entre operaciones (por defecto 0)\n"
+            "  -v     escribe cada operación\n", N, OPERACIONES);
+}
+
+int main(int argc, char *argv[]) {
+    const TipoCerrojo *tipos[MAX_LISTA];
+    int num_tipos = 0;
+    long num_hilos = N;
+    int opcion;
+
+    tipos[num_tipos++] = buscar_cerrojo("mutex");
+    tipos[num_tipos++] = buscar_cerrojo("ticket");
+    tipos[num_tipos++] = buscar_cerrojo("mcs");
+    while ((opcion = getopt(argc, argv, "c:n:o:u:v")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'c': valido = (num_tipos = leer_cerrojos(optarg, tipos, MAX_LISTA)) > 0; break;
+            case 'n': valido = leer_entero(optarg, 1, MAX_HILOS, &num_hilos) == 0; break;
+            case 'o': valido = leer_entero(optarg, 1, 100000000, &operaciones) == 0; break;
+            case 'u': valido = leer_entero(optarg, 0, 1000000, &pausa_us) == 0; break;
+            case 'v': valido = detallado = 1; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("# %ld CPU, %ld cajeros, %ld operaciones cada uno\n", cpus, num_hilos, operaciones);
+    if (num_hilos > cpus) {
+        printf("# Aviso: con más hilos que CPU los cerrojos de espera activa giran mientras el que tiene el cerrojo no corre.\n");
+    }
+    printf("cerrojo,hilos,ops_s,espera_prom_ns,espera_max_ns,fin_min_max,verificacion\n");
+    for (int c = 0; c < num_tipos; c++) {
+        if (medir(tipos[c], (int)num_hilos) != 0) {
+            fprintf(stderr, "Error al crear el cerrojo %s o los hilos.\n", tipos[c]->nombre);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file Ej7BenchCerrojos.c
+ * @brief Banco de pruebas de los cerrojos de cerrojos.h: rendimiento, justicia y latencia.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Los demás programas de la carpeta muestran cada primitiva por separado y solo revisan
+ * que el contador salga bien. Este las pone a competir con la misma carga para saber
+ * cuál conviene con cuánta contención. Cada hilo repite durante -d milisegundos:
+ *      1. Toma el cerrojo y mide cuánto tardó en tomarlo (latencia de adquisición).
+ *      2. Región crítica: incrementa un contador compartido y hace -s unidades de trabajo.
+ *      3. Suelta el cerrojo y hace -f unidades de trabajo fuera de la región crítica.
+ * Una unidad de trabajo es un paso de un generador congruencial (unos pocos ns) que el
+ * compilador no puede eliminar. Con -f 0 todos los hilos compiten todo el tiempo;
+ * con -f grande casi nunca se encuentran.
+ *
+ * Por cada cerrojo, número de hilos, largo de la región crítica y trabajo fuera escribe
+ * una fila CSV con:
+ *      - ops_s:   adquisiciones por segundo entre todos los hilos
+ *      - jain:    índice de justicia de Jain de las adquisiciones por hilo,
+ *                 (Σx)² / (n·Σx²): 1 si todos adquirieron lo mismo, 1/n si uno solo
+ *      - min_max: adquisiciones del hilo que menos entre las del que más
+ *      - p50_ns, p99_ns, p999_ns, max_ns: percentiles de la latencia de adquisición,
+ *        tomados de un histograma logarítmico (4 cubetas por potencia de 2, error < 25%).
+ *        Incluyen los ~20 ns de las dos llamadas a clock_gettime.
+ *      - verificacion: ok si el contador compartido es igual al total de adquisiciones;
+ *        ERROR si dos hilos estuvieron a la vez en la región crítica.
+ *
+ * Los cerrojos de espera activa se degradan mucho si hay más hilos que núcleos: el hilo
+ * que tiene el cerrojo puede perder la CPU mientras los demás giran.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej7BenchCerrojos Ej7BenchCerrojos.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej7BenchCerrojos                                  (todos, 1,2,4 hilos)
+ *      ./Ej7BenchCerrojos -c tas,mutex -n 1,2,4,8,16 -s 0,100 -f 0,1000 -d 500
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "cerrojos.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define MAX_LISTA 32                // Elementos máximos en cada lista de la línea de comandos
+#define DURACION_MS 200             // Duración de cada medición por defecto
+#define NUM_CUBETAS (4 * 63)        // Histograma: 4 cubetas por potencia de 2 hasta 2^63 ns
+
+/**
+ * @struct DatosHilo
+ * @brief Lo que mide cada hilo; va en su propia línea de caché.
+ */
+typedef struct {
+    uint64_t adquisiciones;
+    uint64_t latencia_max;
+    uint64_t histograma[NUM_CUBETAS];
+} DatosHilo;
+
+DEFINIR_RANURA(RanuraHilo, DatosHilo);
+
+/**
+ * @struct Medicion
+ * @brief Parámetros y estado compartido de una medición.
+ */
+typedef struct {
+    const TipoCerrojo *tipo;
+    void *cerrojo;
+    int num_hilos;
+    long seccion;                   // Unidades de trabajo dentro de la región crítica
+    long fuera;                     // Unidades de trabajo fuera
+    pthread_barrier_t inicio;       // Todos empiezan a la vez
+    atomic_int detener;             // Lo pone el hilo principal al terminar el tiempo
+    RanuraHilo *hilos;
+    uint64_t contador;              // Lo incrementa la región crítica (protegido por el cerrojo)
+} Medicion;
+
+/**
+ * @struct ArgHilo
+ * @brief Lo que recibe cada hilo.
+ */
+typedef struct {
+    Medicion *m;
+    int id;
+} ArgHilo;
+
+/**
+ * @brief Cubeta del histograma para ns: 4 cubetas por potencia de 2.
+ */
+static inline int cubeta(uint64_t ns) {
+    if (ns < 4) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    return 4 * (e - 1) + (int)((ns >> (e - 2)) & 3);
+}
+
+/**
+ * @brief Límite inferior (en ns) de la cubeta c.
+ */
+static inline uint64_t valor_cubeta(int c) {
+    if (c < 4) return (uint64_t)c;
+    int e = c / 4 + 1;
+    return (uint64_t)(4 + c % 4) << (e - 2);
+}
+
+void *hilo(void *arg) {
+    ArgHilo *a = arg;
+    Medicion *m = a->m;
+    DatosHilo *d = &m->hilos[a->id].valor;
+    uint64_t x = (uint64_t)a->id + 1;
+
+    pthread_barrier_wait(&m->inicio);
+    while (!atomic_load_explicit(&m->detener, memory_order_relaxed)) {
+        uint64_t t0 = ahora_ns();
+        m->tipo->entrar(m->cerrojo, a->id);
+        uint64_t latencia = ahora_ns() - t0;
+
+        m->contador++;                      // Región crítica
+        x = trabajar(x, m->seccion);
+        m->tipo->salir(m->cerrojo, a->id);
+
+        d->adquisiciones++;
+        d->histograma[cubeta(latencia)]++;
+        if (latencia > d->latencia_max) d->latencia_max = latencia;
+        x = trabajar(x, m->fuera);          // Región no crítica
+    }
+    __asm__ volatile("" : : "r"(x));
+    return NULL;
+}
+
+/**
+ * @brief Percentil q (0..1) del histograma.
+ */
+uint64_t percentil(const uint64_t *histograma, uint64_t total, double q) {
+    uint64_t objetivo = (uint64_t)(q * total), acumulado = 0;
+    for (int c = 0; c < NUM_CUBETAS; c++) {
+        acumulado += histograma[c];
+        if (acumulado > objetivo) return valor_cubeta(c);
+    }
+    return valor_cubeta(NUM_CUBETAS - 1);
+}
+
+/**
+ * @brief Ejecuta una medición y escribe su fila CSV.
+ * @return int 0 si todo salió bien, -1 si no hubo memoria o no se pudieron crear los hilos
+ */
+int medir(const TipoCerrojo *tipo, int num_hilos, long seccion, long fuera, long duracion_ms) {
+    Medicion m;
+    pthread_t hilos[MAX_HILOS];
+    ArgHilo args[MAX_HILOS];
+
+    m.tipo = tipo;
+    m.num_hilos = num_hilos;
+    m.seccion = seccion;
+    m.fuera = fuera;
+    m.contador = 0;
+    atomic_init(&m.detener, 0);
+    m.cerrojo = tipo->crear(num_hilos);
+    m.hilos = ranuras_reservar(num_hilos, sizeof(RanuraHilo));
+    if (!m.cerrojo || !m.hilos) {
+        if (m.cerrojo) tipo->destruir(m.cerrojo);
+        free(m.hilos);
+        return -1;
+    }
+    memset(m.hilos, 0, sizeof(RanuraHilo) * num_hilos);
+    pthread_barrier_init(&m.inicio, NULL, num_hilos + 1);
+
+    for (int i = 0; i < num_hilos; i++) {
+        args[i].m = &m;
+        args[i].id = i;
+        if (pthread_create(&hilos[i], NULL, hilo, &args[i]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    pthread_barrier_wait(&m.inicio);
+    uint64_t t0 = ahora_ns();
+    dormir_ms(duracion_ms);
+    atomic_store(&m.detener, 1);
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = (ahora_ns() - t0) / 1e9;
+
+    uint64_t histograma[NUM_CUBETAS] = { 0 };
+    uint64_t total = 0, minimo = UINT64_MAX, maximo = 0, latencia_max = 0;
+    double suma_cuadrados = 0;
+    for (int i = 0; i < num_hilos; i++) {
+        DatosHilo *d = &m.hilos[i].valor;
+        total += d->adquisiciones;
+        suma_cuadrados += (double)d->adquisiciones * d->adquisiciones;
+        if (d->adquisiciones < minimo) minimo = d->adquisiciones;
+        if (d->adquisiciones > maximo) maximo = d->adquisiciones;
+        if (d->latencia_max > latencia_max) latencia_max = d->latencia_max;
+        for (int c = 0; c < NUM_CUBETAS; c++) {
+            histograma[c] += d->histograma[c];
+        }
+    }
+    double jain = (suma_cuadrados > 0) ? (double)total * total / (num_hilos * suma_cuadrados) : 0;
+
+    printf("%s,%d,%ld,%ld,%.0f,%.3f,%.3f,%llu,%llu,%llu,%llu,%s\n", tipo->nombre, num_hilos, seccion, fuera,
+           total / segundos, jain, maximo ? (double)minimo / maximo : 0.0,
+           (unsigned long long)percentil(histograma, total, 0.50),
+           (unsigned long long)percentil(histograma, total, 0.99),
+           (unsigned long long)percentil(histograma, total, 0.999),
+           (unsigned long long)latencia_max, (m.contador == total) ? "ok" : "ERROR");
+    fflush(stdout);
+
+    pthread_barrier_destroy(&m.inicio);
+    tipo->destruir(m.cerrojo);
+    free(m.hilos);
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-c cerrojos] [-n hilos] [-s seccion] [-f fuera] [-d ms]\n"
+            "  -c L   lista de cerrojos (por defecto todos:",
+            programa);
+    for (const TipoCerrojo *t = CERROJOS; t->nombre; t++) {
+        fprintf(stderr, " %s", t->nombre);
+    }
+    fprintf(stderr, ")\n"
+            "  -n L   lista de números de hilos (por defecto 1,2,4)\n"
+            "  -s L   unidades de trabajo dentro de la región crítica (por defecto 0)\n"
+            "  -f L   unidades de trabajo fuera de la región crítica (por defecto 0,200)\n"
+            "  -d MS  duración de cada medición en milisegundos (por defecto %d)\n", DURACION_MS);
+}
+
+/**
+ * @brief Función principal: recorre cerrojos, hilos, secciones y trabajo fuera, y escribe
+ *        una fila CSV por combinación.
+ * @return int Código de salida.
+ */
+int main(int argc, char *argv[]) {
+    const TipoCerrojo *tipos[MAX_LISTA];
+    long hilos[MAX_LISTA] = { 1, 2, 4 }, secciones[MAX_LISTA] = { 0 }, fueras[MAX_LISTA] = { 0, 200 };
+    int num_tipos = 0, num_hilos = 3, num_secciones = 1, num_fueras = 2;
+    long duracion = DURACION_MS;
+    int opcion;
+
+    for (const TipoCerrojo *t = CERROJOS; t->nombre && num_tipos < MAX_LISTA; t++) {
+        tipos[num_tipos++] = t;
+    }
+    while ((opcion = getopt(argc, argv, "c:n:s:f:d:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'c': valido = (num_tipos = leer_cerrojos(optarg, tipos, MAX_LISTA)) > 0; break;
+            case 'n': valido = (num_hilos = leer_lista(optarg, 1, MAX_HILOS, hilos, MAX_LISTA)) > 0; break;
+            case 's': valido = (num_secciones = leer_lista(optarg, 0, 1000000, secciones, MAX_LISTA)) > 0; break;
+            case 'f': valido = (num_fueras = leer_lista(optarg, 0, 1000000, fueras, MAX_LISTA)) > 0; break;
+            case 'd': valido = leer_entero(optarg, 1, 60000, &duracion) == 0; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("# %ld CPU, %ld ms por medición\n", cpus, duracion);
+    for (int h = 0; h < num_hilos; h++) {
+        if (hilos[h] > cpus) {
+            printf("# Aviso: con más hilos que CPU los cerrojos de espera activa giran mientras el que tiene el cerrojo no corre.\n");
+            break;
+        }
+    }
+    printf("cerrojo,hilos,seccion,fuera,ops_s,jain,min_max,p50_ns,p99_ns,p999_ns,max_ns,verificacion\n");
+
+    for (int c = 0; c < num_tipos; c++) {
+        for (int h = 0; h < num_hilos; h++) {
+            for (int s = 0; s < num_secciones; s++) {
+                for (int f = 0; f < num_fueras; f++) {
+                    if (medir(tipos[c], (int)hilos[h], secciones[s], fueras[f], duracion) != 0) {
+                        fprintf(stderr, "Error al asignar memoria para el cerrojo %s.\n", tipos[c]->nombre);
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
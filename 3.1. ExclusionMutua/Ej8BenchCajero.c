@@ -0,0 +1,357 @@
+/**
+ * @file Ej8BenchCajero.c
+ * @brief Cajeros con mucha contención sobre una sola cuenta: cuenta sin cerrojos (CAS),
+ *        combinación plana y delegación a un servidor contra la cuenta protegida con un
+ *        cerrojo de cerrojos.h.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Cada hilo es un cajero que durante -d milisegundos hace operaciones al azar sobre la
+ * misma cuenta, como en Ej6CajeroMutex.c: retiro o depósito de $1 a $50, y el retiro se
+ * rechaza si el saldo no alcanza. Entre operaciones hace -f unidades de trabajo (un paso
+ * de un generador congruencial cada una); con -f 0 todos compiten todo el tiempo.
+ *
+ * La cuenta se maneja con uno de estos métodos (-c):
+ *      - atomica: CuentaAtomica de cuenta.h, depósito con fetch_add y retiro con un lazo
+ *                 compare_exchange. No hay cerrojo.
+ *      - combinada: CuentaCombinada de cuenta.h. Cada cajero publica su operación; el que
+ *                 toma el cerrojo aplica las de todos en lote (flat combining).
+ *      - servidor: CuentaServidor de cuenta.h. Un hilo extra, además de los -n cajeros,
+ *                 aplica todas las operaciones; los cajeros solo publican y esperan.
+ *      - el nombre de un cerrojo de cerrojos.h (mutex, filtro, filtro_c11, ticket, mcs...):
+ *                 revisar y actualizar el saldo es la región crítica, como en Ej2Cajero.c
+ *                 (filtro) y Ej6CajeroMutex.c (mutex).
+ *
+ * Auditoría: cada cajero suma lo que depositó y lo que retiró con éxito. Al final el saldo
+ * debe ser SALDO_INICIAL + depósitos - retiros aceptados, y nunca negativo; si no, la
+ * columna verificacion dice ERROR (por ejemplo, el filtro sin atómicos con varios núcleos).
+ *
+ * Columnas del CSV: cuenta, hilos, fuera, ops_s (operaciones por segundo entre todos),
+ * rechazos (retiros rechazados por saldo), lote (operaciones aplicadas por cada recorrido
+ * del combinador o del servidor; vacío con los demás métodos), saldo_final, verificacion.
+ *
+ * Con mucha contención (-f 0 y muchos hilos) la combinación y el servidor evitan que la
+ * línea del saldo y la del cerrojo viajen entre núcleos en cada operación. Con poca
+ * contención (-f grande) cada lote trae una sola operación y solo se paga el recorrido.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej8BenchCajero Ej8BenchCajero.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej8BenchCajero                            (atomica, mutex, filtro, filtro_c11)
+ *      ./Ej8BenchCajero -c atomica,mutex,mcs -n 1,2,4,8,16 -f 0,100 -d 500
+ *      ./Ej8BenchCajero -c mutex,combinada,servidor -n 4,8,16,32 -f 0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "cerrojos.h"
+#include "cuenta.h"
+#include "../Comun/aleatorio.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define MAX_LISTA 32                // Elementos máximos en cada lista de la línea de comandos
+#define DURACION_MS 200             // Duración de cada medición por defecto
+#define SALDO_INICIAL 1000
+#define SEMILLA 1                   // Misma semilla en cada ejecución para comparar métodos
+
+/**
+ * @enum Metodo
+ * @brief Cómo se protege la cuenta.
+ */
+typedef enum {
+    ATOMICA,        // CuentaAtomica (cuenta.h)
+    COMBINADA,      // CuentaCombinada (cuenta.h)
+    SERVIDOR,       // CuentaServidor (cuenta.h)
+    CERROJO         // long protegido con un cerrojo de cerrojos.h
+} Metodo;
+
+/**
+ * @struct Cuenta
+ * @brief Un método para manejar la cuenta, como se escribe en -c.
+ */
+typedef struct {
+    const char *nombre;
+    Metodo metodo;
+    const TipoCerrojo *tipo;        // Solo con CERROJO
+} Cuenta;
+
+/**
+ * @struct DatosCajero
+ * @brief Lo que cuenta cada cajero; va en su propia línea de caché.
+ */
+typedef struct {
+    uint64_t operaciones;
+    uint64_t rechazos;
+    long depositado;                // Suma de los depósitos
+    long retirado;                  // Suma de los retiros aceptados
+} DatosCajero;
+
+DEFINIR_RANURA(RanuraCajero, DatosCajero);
+
+/**
+ * @struct Medicion
+ * @brief Parámetros y estado compartido de una medición.
+ */
+typedef struct {
+    const Cuenta *cuenta;
+    void *cerrojo;                  // Con CERROJO
+    long fuera;                     // Unidades de trabajo entre operaciones
+    pthread_barrier_t inicio;       // Todos empiezan a la vez
+    atomic_int detener;             // Lo pone el hilo principal al terminar el tiempo
+    RanuraCajero *cajeros;
+    CuentaAtomica atomica;          // Con ATOMICA
+    CuentaCombinada *combinada;     // Con COMBINADA
+    CuentaServidor *servidor;       // Con SERVIDOR
+    _Alignas(LINEA_CACHE) long saldo;   // Con CERROJO, protegido por el cerrojo
+} Medicion;
+
+/**
+ * @struct ArgHilo
+ * @brief Lo que recibe cada hilo.
+ */
+typedef struct {
+    Medicion *m;
+    int id;
+} ArgHilo;
+
+/**
+ * @brief Hace un retiro (operacion 0) o un depósito (operacion 1) con el método de la
+ *        medición.
+ * @return int 1 si la operación se hizo, 0 si el retiro se rechazó
+ */
+static inline int operar(Medicion *m, int id, int operacion, long cantidad) {
+    int aceptada = 1;
+
+    switch (m->cuenta->metodo) {
+        case ATOMICA:
+            if (operacion == 0) return cuenta_retirar(&m->atomica, cantidad);
+            cuenta_depositar(&m->atomica, cantidad);
+            break;
+        case COMBINADA:
+            return cuenta_combinada_operar(m->combinada, id, operacion, cantidad);
+        case SERVIDOR:
+            return cuenta_servidor_operar(m->servidor, id, operacion, cantidad);
+        case CERROJO:
+            m->cuenta->tipo->entrar(m->cerrojo, id);
+            // Region critica
+            if (operacion == 0) {
+                if (m->saldo >= cantidad) {
+                    m->saldo -= cantidad;
+                } else {
+                    aceptada = 0;
+                }
+            } else {
+                m->saldo += cantidad;
+            }
+            m->cuenta->tipo->salir(m->cerrojo, id);
+            break;
+    }
+    return aceptada;
+}
+
+void *cajero(void *arg) {
+    ArgHilo *a = arg;
+    Medicion *m = a->m;
+    DatosCajero *d = &m->cajeros[a->id].valor;
+    Aleatorio rng;
+    aleatorio_sembrar(&rng, SEMILLA, (uint64_t)a->id);
+    uint64_t x = (uint64_t)a->id + 1;
+
+    pthread_barrier_wait(&m->inicio);
+    while (!atomic_load_explicit(&m->detener, memory_order_relaxed)) {
+        int operacion = aleatorio_rango(&rng, 2);           // 0: retiro, 1: depósito
+        long cantidad = aleatorio_rango(&rng, 50) + 1;      // monto de la operación
+
+        if (operar(m, a->id, operacion, cantidad)) {
+            if (operacion == 0) {
+                d->retirado += cantidad;
+            } else {
+                d->depositado += cantidad;
+            }
+        } else {
+            d->rechazos++;
+        }
+        d->operaciones++;
+        x = trabajar(x, m->fuera);                      // Fuera de la cuenta
+    }
+    __asm__ volatile("" : : "r"(x));
+    return NULL;
+}
+
+/**
+ * @brief Corre una medición y escribe su fila CSV.
+ * @return int 0 si todo salió bien, -1 si no hubo memoria o no se crearon los hilos
+ */
+int medir(const Cuenta *cuenta, int num_hilos, long fuera, long duracion_ms) {
+    pthread_t hilos[MAX_HILOS];
+    ArgHilo args[MAX_HILOS];
+    Medicion *m = ranuras_reservar(1, sizeof(Medicion));
+    if (!m) return -1;
+    memset(m, 0, sizeof(Medicion));
+    m->cuenta = cuenta;
+    m->fuera = fuera;
+    m->saldo = SALDO_INICIAL;
+    cuenta_iniciar(&m->atomica, SALDO_INICIAL);
+    atomic_init(&m->detener, 0);
+    m->cajeros = ranuras_reservar(num_hilos, sizeof(RanuraCajero));
+    switch (cuenta->metodo) {
+        case ATOMICA: break;
+        case COMBINADA: if (!(m->combinada = cuenta_combinada_crear(num_hilos, SALDO_INICIAL))) return -1; break;
+        case SERVIDOR: if (!(m->servidor = cuenta_servidor_crear(num_hilos, SALDO_INICIAL))) return -1; break;
+        case CERROJO: if (!(m->cerrojo = cuenta->tipo->crear(num_hilos))) return -1; break;
+    }
+    if (!m->cajeros) return -1;
+    memset(m->cajeros, 0, ranura_tam(sizeof(DatosCajero)) * (size_t)num_hilos);
+    pthread_barrier_init(&m->inicio, NULL, (unsigned)num_hilos + 1);
+
+    for (int i = 0; i < num_hilos; i++) {
+        args[i].m = m;
+        args[i].id = i;
+        if (pthread_create(&hilos[i], NULL, cajero, &args[i]) != 0) return -1;
+    }
+    pthread_barrier_wait(&m->inicio);
+    double t0 = ahora();
+    dormir_ms(duracion_ms);
+    atomic_store(&m->detener, 1);
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - t0;
+
+    uint64_t operaciones = 0, rechazos = 0;
+    long esperado = SALDO_INICIAL;
+    for (int i = 0; i < num_hilos; i++) {
+        DatosCajero *d = &m->cajeros[i].valor;
+        operaciones += d->operaciones;
+        rechazos += d->rechazos;
+        esperado += d->depositado - d->retirado;
+    }
+    long saldo = m->saldo;
+    char lote[32] = "";
+    switch (cuenta->metodo) {
+        case ATOMICA:
+            saldo = cuenta_saldo(&m->atomica);
+            break;
+        case COMBINADA:
+            saldo = m->combinada->saldo;
+            snprintf(lote, sizeof(lote), "%.2f", (double)m->combinada->aplicados / (double)m->combinada->rondas);
+            cuenta_combinada_destruir(m->combinada);
+            break;
+        case SERVIDOR:
+            cuenta_servidor_detener(m->servidor);
+            saldo = m->servidor->saldo;
+            snprintf(lote, sizeof(lote), "%.2f", (double)m->servidor->aplicados / (double)m->servidor->rondas);
+            cuenta_servidor_destruir(m->servidor);
+            break;
+        case CERROJO:
+            cuenta->tipo->destruir(m->cerrojo);
+            break;
+    }
+    printf("%s,%d,%ld,%.0f,%llu,%s,%ld,%s\n", cuenta->nombre, num_hilos, fuera,
+           (double)operaciones / segundos, (unsigned long long)rechazos, lote, saldo,
+           (saldo == esperado && saldo >= 0) ? "ok" : "ERROR");
+
+    pthread_barrier_destroy(&m->inicio);
+    free(m->cajeros);
+    free(m);
+    return 0;
+}
+
+/**
+ * @brief Convierte una lista de métodos ("atomica,mutex") a cuentas.
+ * @return int Número de métodos leídos, o -1 si alguno no existe
+ */
+int leer_cuentas(const char *texto, Cuenta *cuentas) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > MAX_LISTA) return -1;
+
+    for (int n = 0; n < l.n; n++) {
+        const char *parte = l.partes[n];
+        cuentas[n].tipo = NULL;
+        if (strcmp(parte, "atomica") == 0) {
+            cuentas[n].nombre = "atomica";
+            cuentas[n].metodo = ATOMICA;
+        } else if (strcmp(parte, "combinada") == 0) {
+            cuentas[n].nombre = "combinada";
+            cuentas[n].metodo = COMBINADA;
+        } else if (strcmp(parte, "servidor") == 0) {
+            cuentas[n].nombre = "servidor";
+            cuentas[n].metodo = SERVIDOR;
+        } else if ((cuentas[n].tipo = buscar_cerrojo(parte)) != NULL) {
+            cuentas[n].nombre = cuentas[n].tipo->nombre;
+            cuentas[n].metodo = CERROJO;
+        } else {
+            return -1;
+        }
+    }
+    return l.n;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-c cuentas] [-n hilos] [-f fuera] [-d ms]\n"
+            "  -c L   lista de métodos: atomica, combinada, servidor o un cerrojo de cerrojos.h (",
+            programa);
+    for (const TipoCerrojo *t = CERROJOS; t->nombre; t++) {
+        fprintf(stderr, "%s%s", t == CERROJOS ? "" : " ", t->nombre);
+    }
+    fprintf(stderr, ")\n"
+            "         por defecto atomica,mutex,filtro,filtro_c11\n"
+            "  -n L   lista de números de hilos (por defecto 1,2,4,8)\n"
+            "  -f L   unidades de trabajo entre operaciones (por defecto 0)\n"
+            "  -d MS  duración de cada medición en milisegundos (por defecto %d)\n", DURACION_MS);
+}
+
+int main(int argc, char *argv[]) {
+    Cuenta cuentas[MAX_LISTA];
+    long hilos[MAX_LISTA] = { 1, 2, 4, 8 }, fueras[MAX_LISTA] = { 0 };
+    int num_cuentas, num_hilos = 4, num_fueras = 1;
+    long duracion = DURACION_MS;
+    int opcion;
+
+    num_cuentas = leer_cuentas("atomica,mutex,filtro,filtro_c11", cuentas);
+    while ((opcion = getopt(argc, argv, "c:n:f:d:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'c': valido = (num_cuentas = leer_cuentas(optarg, cuentas)) > 0; break;
+            case 'n': valido = (num_hilos = leer_lista(optarg, 1, MAX_HILOS, hilos, MAX_LISTA)) > 0; break;
+            case 'f': valido = (num_fueras = leer_lista(optarg, 0, 1000000, fueras, MAX_LISTA)) > 0; break;
+            case 'd': valido = leer_entero(optarg, 1, 60000, &duracion) == 0; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("# %ld CPU, %ld ms por medición, saldo inicial %d\n", cpus, duracion, SALDO_INICIAL);
+    for (int h = 0; h < num_hilos; h++) {
+        if (hilos[h] > cpus) {
+            printf("# Aviso: con más hilos que CPU los cerrojos de espera activa giran mientras el que tiene el cerrojo no corre.\n");
+            break;
+        }
+    }
+    printf("cuenta,hilos,fuera,ops_s,rechazos,lote,saldo_final,verificacion\n");
+
+    for (int c = 0; c < num_cuentas; c++) {
+        for (int h = 0; h < num_hilos; h++) {
+            for (int f = 0; f < num_fueras; f++) {
+                if (medir(&cuentas[c], (int)hilos[h], fueras[f], duracion) != 0) {
+                    fprintf(stderr, "Error al crear la cuenta %s o los hilos.\n", cuentas[c].nombre);
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file Ej9Banco.c
+ * @brief Banco con muchas cuentas y transferencias entre ellas: un cerrojo por cuenta o
+ *        por franja, tomados en orden de dirección o con intento y espera.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Los cajeros de Ej2Cajero.c y Ej6CajeroMutex.c operan sobre un solo saldo, así que
+ * todos se forman en el mismo cerrojo. Aquí hay -a cuentas y cada operación es una
+ * transferencia de $1 a $50 de una cuenta a otra (se rechaza si el saldo del origen no
+ * alcanza). Dos transferencias entre cuentas distintas pueden ir en paralelo.
+ *
+ * Cerrojos (-m):
+ *      - cuenta:  un pthread_mutex_t por cuenta.
+ *      - franjas: -e cerrojos; la cuenta c usa el cerrojo c % e. Menos memoria, pero dos
+ *                 cuentas de la misma franja se estorban aunque no tengan nada que ver.
+ *
+ * Una transferencia necesita los cerrojos de las dos cuentas. Si el hilo A toma el de la
+ * cuenta 1 y espera el de la 2, mientras B toma el de la 2 y espera el de la 1, ninguno
+ * avanza nunca (interbloqueo). Dos formas de evitarlo (-t):
+ *      - orden:   todos toman primero el cerrojo de dirección menor. Nadie puede tener el
+ *                 mayor y esperar el menor, así que no se forma el ciclo.
+ *      - intento: se toma el cerrojo del origen y se intenta el del destino con
+ *                 pthread_mutex_trylock; si está ocupado se suelta el primero, se espera
+ *                 un tiempo que crece al doble en cada fallo (con tope) y se reintenta.
+ * Si las dos cuentas caen en el mismo cerrojo (misma franja) se toma una sola vez.
+ *
+ * Las cuentas se eligen con una distribución de Zipf de parámetro -z: la cuenta de rango
+ * k sale con probabilidad proporcional a 1 / (k + 1)^z. Con z = 0 todas por igual; con
+ * z cerca de 1 unas pocas cuentas concentran casi todas las transferencias (cuentas
+ * calientes), como pasa con las cuentas de un comercio grande.
+ *
+ * Por cada combinación escribe una fila CSV con las transferencias por segundo, las
+ * rechazadas por saldo, los reintentos (solo con intento) y la auditoría: la suma de
+ * todos los saldos debe seguir siendo cuentas * SALDO_INICIAL y ningún saldo negativo.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej9Banco Ej9Banco.c -lpthread -lm
+ *
+ * Ejecución:
+ *      ./Ej9Banco
+ *      ./Ej9Banco -a 16,1024,65536 -z 0,0.8,0.99 -m cuenta,franjas -e 64 -t orden,intento -n 1,4,8
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "cerrojos.h"
+#include "../Comun/aleatorio.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define MAX_HILOS 256
+#define MAX_CUENTAS 1000000
+#define MAX_LISTA 32                // Elementos máximos en cada lista de la línea de comandos
+#define DURACION_MS 200             // Duración de cada medición por defecto
+#define FRANJAS 64                  // Cerrojos en modo franjas por defecto
+#define SALDO_INICIAL 1000
+#define SEMILLA 1                   // Misma semilla en cada ejecución para comparar configuraciones
+#define ESPERA_MIN 4                // Pausas de la primera espera en modo intento
+#define ESPERA_MAX 1024             // Tope de pausas; al llegar ahí el hilo cede la CPU
+
+static const char *const MODOS[] = { "franjas", "cuenta", NULL };          // -m, en orden de por_cuenta
+static const char *const ADQUISICIONES[] = { "orden", "intento", NULL };    // -t, en orden de intento
+
+DEFINIR_RANURA(RanuraMutex, pthread_mutex_t);
+DEFINIR_RANURA(RanuraSaldo, long);
+
+/**
+ * @struct DatosHilo
+ * @brief Lo que cuenta cada hilo; va en su propia línea de caché.
+ */
+typedef struct {
+    uint64_t transferencias;
+    uint64_t rechazos;
+    uint64_t reintentos;
+} DatosHilo;
+
+DEFINIR_RANURA(RanuraHilo, DatosHilo);
+
+/**
+ * @struct Banco
+ * @brief Cuentas, cerrojos y parámetros de una medición.
+ */
+typedef struct {
+    int num_cuentas;
+    int num_cerrojos;               // num_cuentas con -m cuenta, -e con -m franjas
+    int intento;                    // 1: -t intento, 0: -t orden
+    RanuraSaldo *saldos;            // Cada saldo en su propia línea de caché
+    RanuraMutex *cerrojos;
+    double *acumulada;              // Distribución de Zipf acumulada, una por cuenta
+    pthread_barrier_t inicio;       // Todos empiezan a la vez
+    atomic_int detener;             // Lo pone el hilo principal al terminar el tiempo
+    RanuraHilo *hilos;
+} Banco;
+
+/**
+ * @struct ArgHilo
+ * @brief Lo que recibe cada hilo.
+ */
+typedef struct {
+    Banco *b;
+    int id;
+} ArgHilo;
+
+static inline pthread_mutex_t *cerrojo_de(Banco *b, int cuenta) {
+    return &b->cerrojos[cuenta % b->num_cerrojos].valor;
+}
+
+/**
+ * @brief Elige una cuenta con la distribución de Zipf: búsqueda binaria de un número al
+ *        azar en [0, 1) dentro de la distribución acumulada.
+ */
+static inline int elegir_cuenta(Banco *b, Aleatorio *rng) {
+    double u = aleatorio_real(rng);
+    int izq = 0, der = b->num_cuentas - 1;
+    while (izq < der) {
+        int medio = (izq + der) / 2;
+        if (b->acumulada[medio] > u) {
+            der = medio;
+        } else {
+            izq = medio + 1;
+        }
+    }
+    return izq;
+}
+
+/**
+ * @brief Toma los dos cerrojos, el de dirección menor primero.
+ */
+static inline void tomar_en_orden(pthread_mutex_t *a, pthread_mutex_t *b) {
+    if ((uintptr_t)a > (uintptr_t)b) {
+        pthread_mutex_t *t = a;
+        a = b;
+        b = t;
+    }
+    pthread_mutex_lock(a);
+    if (b != a) pthread_mutex_lock(b);
+}
+
+/**
+ * @brief Toma el primer cerrojo y prueba el segundo; si está ocupado suelta el primero y
+ *        espera antes de volver a intentar.
+ * @return uint64_t Número de reintentos
+ */
+static inline uint64_t tomar_con_intento(pthread_mutex_t *a, pthread_mutex_t *b, Aleatorio *rng) {
+    uint64_t reintentos = 0;
+    unsigned espera = ESPERA_MIN;
+
+    for (;;) {
+        pthread_mutex_lock(a);
+        if (b == a || pthread_mutex_trylock(b) == 0) return reintentos;
+        pthread_mutex_unlock(a);
+        reintentos++;
+
+        // Espera al azar para que los dos hilos no vuelvan a chocar al mismo tiempo
+        for (unsigned k = aleatorio_rango(rng, espera) + 1; k > 0; k--) {
+            cerrojo_pausa();
+        }
+        if (espera < ESPERA_MAX) {
+            espera *= 2;
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+void *trabajo(void *arg) {
+    ArgHilo *a = arg;
+    Banco *b = a->b;
+    DatosHilo *d = &b->hilos[a->id].valor;
+    Aleatorio rng;
+    aleatorio_sembrar(&rng, SEMILLA, (uint64_t)a->id);
+
+    pthread_barrier_wait(&b->inicio);
+    while (!atomic_load_explicit(&b->detener, memory_order_relaxed)) {
+        int origen = elegir_cuenta(b, &rng);
+        int destino = elegir_cuenta(b, &rng);
+        if (origen == destino) continue;
+        long cantidad = aleatorio_rango(&rng, 50) + 1;
+        pthread_mutex_t *c_origen = cerrojo_de(b, origen), *c_destino = cerrojo_de(b, destino);
+
+        if (b->intento) {
+            d->reintentos += tomar_con_intento(c_origen, c_destino, &rng);
+        } else {
+            tomar_en_orden(c_origen, c_destino);
+        }
+        // Region critica: las dos cuentas
+        if (b->saldos[origen].valor >= cantidad) {
+            b->saldos[origen].valor -= cantidad;
+            b->saldos[destino].valor += cantidad;
+        } else {
+            d->rechazos++;
+        }
+        if (c_destino != c_origen) pthread_mutex_unlock(c_destino);
+        pthread_mutex_unlock(c_origen);
+        d->transferencias++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Llena la distribución acumulada de Zipf con parámetro z para n cuentas.
+ */
+void zipf_acumulada(double *acumulada, int n, double z) {
+    double suma = 0;
+    for (int k = 0; k < n; k++) {
+        suma += 1.0 / pow((double)k + 1.0, z);
+        acumulada[k] = suma;
+    }
+    for (int k = 0; k < n; k++) {
+        acumulada[k] /= suma;
+    }
+    acumulada[n - 1] = 1.0;
+}
+
+/**
+ * @brief Corre una medición y escribe su fila CSV.
+ * @return int 0 si todo salió bien, -1 si no hubo memoria o no se crearon los hilos
+ */
+int medir(int num_cuentas, double z, int por_cuenta, long franjas, int intento, int num_hilos,
+          long duracion_ms) {
+    pthread_t hilos[MAX_HILOS];
+    ArgHilo args[MAX_HILOS];
+    Banco b;
+
+    memset(&b, 0, sizeof(b));
+    b.num_cuentas = num_cuentas;
+    b.num_cerrojos = por_cuenta ? num_cuentas : (int)franjas;
+    b.intento = intento;
+    b.saldos = ranuras_reservar((size_t)num_cuentas, sizeof(RanuraSaldo));
+    b.cerrojos = ranuras_reservar((size_t)b.num_cerrojos, sizeof(RanuraMutex));
+    b.acumulada = malloc((size_t)num_cuentas * sizeof(double));
+    b.hilos = ranuras_reservar((size_t)num_hilos, sizeof(RanuraHilo));
+    if (!b.saldos || !b.cerrojos || !b.acumulada || !b.hilos) return -1;
+
+    for (int c = 0; c < num_cuentas; c++) {
+        b.saldos[c].valor = SALDO_INICIAL;
+    }
+    for (int c = 0; c < b.num_cerrojos; c++) {
+        pthread_mutex_init(&b.cerrojos[c].valor, NULL);
+    }
+    zipf_acumulada(b.acumulada, num_cuentas, z);
+    memset(b.hilos, 0, ranura_tam(sizeof(DatosHilo)) * (size_t)num_hilos);
+    atomic_init(&b.detener, 0);
+    pthread_barrier_init(&b.inicio, NULL, (unsigned)num_hilos + 1);
+
+    for (int i = 0; i < num_hilos; i++) {
+        args[i].b = &b;
+        args[i].id = i;
+        if (pthread_create(&hilos[i], NULL, trabajo, &args[i]) != 0) return -1;
+    }
+    pthread_barrier_wait(&b.inicio);
+    double t0 = ahora();
+    dormir_ms(duracion_ms);
+    atomic_store(&b.detener, 1);
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    double segundos = ahora() - t0;
+
+    uint64_t transferencias = 0, rechazos = 0, reintentos = 0;
+    for (int i = 0; i < num_hilos; i++) {
+        transferencias += b.hilos[i].valor.transferencias;
+        rechazos += b.hilos[i].valor.rechazos;
+        reintentos += b.hilos[i].valor.reintentos;
+    }
+    long total = 0;
+    int negativos = 0;
+    for (int c = 0; c < num_cuentas; c++) {
+        total += b.saldos[c].valor;
+        if (b.saldos[c].valor < 0) negativos++;
+    }
+    int correcto = (total == (long)num_cuentas * SALDO_INICIAL && negativos == 0);
+
+    printf("%s,%d,%s,%d,%.2f,%d,%.0f,%llu,%llu,%s\n", MODOS[por_cuenta], b.num_cerrojos,
+           ADQUISICIONES[intento], num_cuentas, z, num_hilos, (double)transferencias / segundos,
+           (unsigned long long)rechazos, (unsigned long long)reintentos, correcto ? "ok" : "ERROR");
+
+    pthread_barrier_destroy(&b.inicio);
+    for (int c = 0; c < b.num_cerrojos; c++) {
+        pthread_mutex_destroy(&b.cerrojos[c].valor);
+    }
+    free(b.saldos);
+    free(b.cerrojos);
+    free(b.acumulada);
+    free(b.hilos);
+    return 0;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-a cuentas] [-z zipf] [-m cerrojos] [-e franjas] [-t adquisicion] [-n hilos] [-d ms]\n"
+            "  -a L   lista de números de cuentas, de 2 a %d (por defecto 16,1024,65536)\n"
+            "  -z L   lista de parámetros de Zipf, de 0 a 5 (por defecto 0,0.99)\n"
+            "  -m L   cuenta: un cerrojo por cuenta; franjas: -e cerrojos (por defecto cuenta,franjas)\n"
+            "  -e N   cerrojos en modo franjas (por defecto %d)\n"
+            "  -t L   orden: por dirección; intento: trylock con espera (por defecto orden,intento)\n"
+            "  -n L   lista de números de hilos (por defecto 4)\n"
+            "  -d MS  duración de cada medición en milisegundos (por defecto %d)\n",
+            programa, MAX_CUENTAS, FRANJAS, DURACION_MS);
+}
+
+int main(int argc, char *argv[]) {
+    long cuentas[MAX_LISTA] = { 16, 1024, 65536 }, hilos[MAX_LISTA] = { 4 };
+    double zipfs[MAX_LISTA] = { 0, 0.99 };
+    int modos[MAX_LISTA] = { 1, 0 }, adquisiciones[MAX_LISTA] = { 0, 1 };
+    int num_cuentas = 3, num_zipfs = 2, num_modos = 2, num_adquisiciones = 2, num_hilos = 1;
+    long franjas = FRANJAS, duracion = DURACION_MS;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "a:z:m:e:t:n:d:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'a': valido = (num_cuentas = leer_lista(optarg, 2, MAX_CUENTAS, cuentas, MAX_LISTA)) > 0; break;
+            case 'z': valido = (num_zipfs = leer_lista_real(optarg, 0, 5, zipfs, MAX_LISTA)) > 0; break;
+            case 'm': valido = (num_modos = leer_lista_nombres(optarg, MODOS, modos, MAX_LISTA)) > 0; break;
+            case 'e': valido = leer_entero(optarg, 1, MAX_CUENTAS, &franjas) == 0; break;
+            case 't': valido = (num_adquisiciones = leer_lista_nombres(optarg, ADQUISICIONES, adquisiciones, MAX_LISTA)) > 0; break;
+            case 'n': valido = (num_hilos = leer_lista(optarg, 1, MAX_HILOS, hilos, MAX_LISTA)) > 0; break;
+            case 'd': valido = leer_entero(optarg, 1, 60000, &duracion) == 0; break;
+        }
+        if (!valido) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+
+    printf("# %ld CPU, %ld ms por medición\n", sysconf(_SC_NPROCESSORS_ONLN), duracion);
+    printf("cerrojos,num_cerrojos,adquisicion,cuentas,zipf,hilos,transferencias_s,rechazos,reintentos,verificacion\n");
+    for (int m = 0; m < num_modos; m++) {
+        for (int t = 0; t < num_adquisiciones; t++) {
+            for (int a = 0; a < num_cuentas; a++) {
+                for (int z = 0; z < num_zipfs; z++) {
+                    for (int h = 0; h < num_hilos; h++) {
+                        if (medir((int)cuentas[a], zipfs[z], modos[m], franjas, adquisiciones[t],
+                                  (int)hilos[h], duracion) != 0) {
+                            fprintf(stderr, "Error al asignar memoria o crear los hilos.\n");
+                            return 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
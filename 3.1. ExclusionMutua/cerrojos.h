@@ -0,0 +1,599 @@
+/**
+ * @file cerrojos.h
+ * @brief Interfaz comun para los cerrojos de exclusion mutua de esta carpeta.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Cada ejemplo de la carpeta protege su region critica con una primitiva distinta:
+ *      - filtro: el algoritmo de filtro de Ej1AlgoritmoFiltroV2.c
+ *      - filtro_c11: el mismo algoritmo con atomicos de C11 (Ej1AlgoritmoFiltroV3.c)
+ *      - torneo: arbol de cerrojos de Peterson para 2 hilos (Ej1AlgoritmoTorneo.c)
+ *      - tas:    atomic_flag_test_and_set, como Ej4AtomicFlag.c
+ *      - ttas:   test-and-test-and-set con espera exponencial (Ej4_1AtomicFlagTTAS.c)
+ *      - cas:    un atomic_int que pasa de 0 a 1 con compare_exchange (la primitiva
+ *                de Ej3AtomicInt.c usada como cerrojo)
+ *      - ticket: cerrojo de turnos, FIFO (Ej6_1CajeroCerrojos.c)
+ *      - mcs:    cola de Mellor-Crummey y Scott, FIFO y cada hilo espera en su propia
+ *                linea de cache (Ej6_1CajeroCerrojos.c)
+ *      - mutex:  pthread_mutex_t, como Ej5mutex.c
+ * Aqui todas tienen la misma forma, una TipoCerrojo, para que un programa (por ejemplo
+ * Ej7BenchCerrojos.c) las use sin saber cual es:
+ *
+ *      const TipoCerrojo *tipo = buscar_cerrojo("tas");
+ *      void *cerrojo = tipo->crear(num_hilos);
+ *      tipo->entrar(cerrojo, id);      // id en [0, num_hilos)
+ *      // region critica
+ *      tipo->salir(cerrojo, id);
+ *      tipo->destruir(cerrojo);
+ *
+ * El id del hilo hace falta porque los algoritmos de software (el filtro) guardan el
+ * estado de cada hilo. Cada cerrojo se reserva en su propia linea de cache
+ * (../Comun/ranura.h) para que no comparta linea con los datos que protege.
+ */
+
+#ifndef CERROJOS_H
+#define CERROJOS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "../Comun/ranura.h"
+#include "../Comun/opciones.h"
+
+/**
+ * @struct TipoCerrojo
+ * @brief Operaciones de un tipo de cerrojo.
+ */
+typedef struct {
+    const char *nombre;
+    void *(*crear)(int num_hilos);              ///< NULL si no hay memoria
+    void (*entrar)(void *cerrojo, int id);
+    void (*salir)(void *cerrojo, int id);
+    void (*destruir)(void *cerrojo);
+} TipoCerrojo;
+
+DEFINIR_RANURA(RanuraEntero, atomic_int);
+
+/**
+ * @brief Indica a la CPU que el hilo esta en espera activa.
+ *
+ * En x86 pause hace que el lazo no llene la tuberia de lecturas especulativas (que se
+ * descartan con costo al cambiar el valor) y cede recursos al otro hilo del nucleo
+ * (hyperthreading). En ARM la instruccion equivalente es yield.
+ */
+static inline void cerrojo_pausa(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ volatile("yield");
+#endif
+}
+
+/**
+ * @brief Reserva tam bytes en ceros, alineados a linea de cache.
+ */
+static inline void *cerrojo_reservar(size_t tam) {
+    void *p = ranuras_reservar(1, tam);
+    if (p) memset(p, 0, ranura_tam(tam));
+    return p;
+}
+
+// Algoritmo de filtro (Ej1AlgoritmoFiltroV2.c)
+
+/**
+ * @struct CerrojoFiltro
+ * @brief Estado del algoritmo de filtro para n hilos.
+ *
+ * Es el algoritmo tal como esta en Ej1AlgoritmoFiltroV2.c. La unica diferencia es que
+ * los arreglos son volatile: sin eso, con -O2 el compilador saca la lectura del while y
+ * el hilo se queda girando para siempre. volatile no impide que la CPU reordene la
+ * escritura de nivel[i] con las lecturas de compNivSup, asi que en varios nucleos la
+ * exclusion mutua puede fallar; Ej7BenchCerrojos.c lo detecta con su contador.
+ */
+typedef struct {
+    int n;
+    volatile int *nivel;            // Nivel en el que se encuentra cada hilo
+    volatile int *ultimo;           // Ultimo hilo que entro a cada nivel
+} CerrojoFiltro;
+
+static inline void *filtro_crear(int num_hilos) {
+    CerrojoFiltro *c = cerrojo_reservar(sizeof(CerrojoFiltro));
+    if (!c) return NULL;
+    c->n = num_hilos;
+    c->nivel = malloc(sizeof(int) * num_hilos);
+    c->ultimo = malloc(sizeof(int) * num_hilos);
+    if (!c->nivel || !c->ultimo) {
+        free((void *)c->nivel);
+        free((void *)c->ultimo);
+        free(c);
+        return NULL;
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        c->nivel[i] = -1;
+        c->ultimo[i] = -1;
+    }
+    return c;
+}
+
+/**
+ * @brief Comprobar si existe k != i, tal que nivel[k] >= l
+ */
+static inline int filtro_comp_niv_sup(CerrojoFiltro *c, int i, int l) {
+    for (int k = 0; k < c->n; k++) {
+        if (k != i && c->nivel[k] >= l) return 1;
+    }
+    return 0;
+}
+
+static inline void filtro_entrar(void *cerrojo, int i) {
+    CerrojoFiltro *c = cerrojo;
+    for (int l = 0; l < c->n - 1; l++) {
+        c->nivel[i] = l;
+        c->ultimo[l] = i;
+        while (c->ultimo[l] == i && filtro_comp_niv_sup(c, i, l));
+    }
+}
+
+static inline void filtro_salir(void *cerrojo, int i) {
+    ((CerrojoFiltro *)cerrojo)->nivel[i] = -1;
+}
+
+static inline void filtro_destruir(void *cerrojo) {
+    CerrojoFiltro *c = cerrojo;
+    free((void *)c->nivel);
+    free((void *)c->ultimo);
+    free(c);
+}
+
+// Algoritmo de filtro con atomicos de C11 (Ej1AlgoritmoFiltroV3.c)
+
+/**
+ * @struct CerrojoFiltroC11
+ * @brief Estado del algoritmo de filtro con el orden de memoria correcto.
+ *
+ * Lo que hace falta para que el filtro funcione en una CPU real es que, en cada nivel,
+ * las escrituras de nivel[i] y ultimo[l] sean visibles antes de las lecturas de los
+ * demas hilos (un orden escritura -> lectura, que x86 no respeta sin barrera):
+ *      - nivel[i] se escribe con orden relajado.
+ *      - ultimo[l] se escribe con un intercambio (atomic_exchange) acq_rel. Como es una
+ *        operacion de lectura-modificacion-escritura, los intercambios de los hilos que
+ *        llegan al nivel quedan en un orden total: el que intercambia despues lee el
+ *        valor del anterior y, por acquire/release, ve tambien su nivel. Es la unica
+ *        barrera por nivel (en x86, xchg ya es una barrera completa); no hace falta
+ *        atomic_thread_fence.
+ *      - Las lecturas del lazo son acquire, y salir escribe nivel[i] = -1 con release:
+ *        el siguiente hilo en entrar ve lo que se escribio en la region critica.
+ * Cada nivel[i] y cada ultimo[l] ocupa su propia linea de cache, para que la escritura
+ * de un hilo no invalide la linea que estan leyendo los demas, y el lazo de espera
+ * ejecuta cerrojo_pausa.
+ */
+typedef struct {
+    int n;
+    RanuraEntero *nivel;
+    RanuraEntero *ultimo;
+} CerrojoFiltroC11;
+
+static inline void *filtro_c11_crear(int num_hilos) {
+    CerrojoFiltroC11 *c = cerrojo_reservar(sizeof(CerrojoFiltroC11));
+    if (!c) return NULL;
+    c->n = num_hilos;
+    c->nivel = ranuras_reservar(num_hilos, sizeof(RanuraEntero));
+    c->ultimo = ranuras_reservar(num_hilos, sizeof(RanuraEntero));
+    if (!c->nivel || !c->ultimo) {
+        free(c->nivel);
+        free(c->ultimo);
+        free(c);
+        return NULL;
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        atomic_init(&c->nivel[i].valor, -1);
+        atomic_init(&c->ultimo[i].valor, -1);
+    }
+    return c;
+}
+
+static inline int filtro_c11_comp_niv_sup(CerrojoFiltroC11 *c, int i, int l) {
+    for (int k = 0; k < c->n; k++) {
+        if (k != i && atomic_load_explicit(&c->nivel[k].valor, memory_order_acquire) >= l) return 1;
+    }
+    return 0;
+}
+
+static inline void filtro_c11_entrar(void *cerrojo, int i) {
+    CerrojoFiltroC11 *c = cerrojo;
+    for (int l = 0; l < c->n - 1; l++) {
+        atomic_store_explicit(&c->nivel[i].valor, l, memory_order_relaxed);
+        atomic_exchange_explicit(&c->ultimo[l].valor, i, memory_order_acq_rel);
+        while (atomic_load_explicit(&c->ultimo[l].valor, memory_order_acquire) == i &&
+               filtro_c11_comp_niv_sup(c, i, l)) {
+            cerrojo_pausa();
+        }
+    }
+}
+
+static inline void filtro_c11_salir(void *cerrojo, int i) {
+    CerrojoFiltroC11 *c = cerrojo;
+    atomic_store_explicit(&c->nivel[i].valor, -1, memory_order_release);
+}
+
+static inline void filtro_c11_destruir(void *cerrojo) {
+    CerrojoFiltroC11 *c = cerrojo;
+    free(c->nivel);
+    free(c->ultimo);
+    free(c);
+}
+
+// Torneo de cerrojos de Peterson (Ej1AlgoritmoTorneo.c)
+
+/**
+ * @struct NodoTorneo
+ * @brief Cerrojo de Peterson para los dos hilos que llegan a un nodo del arbol.
+ */
+typedef struct {
+    atomic_int bandera[2];      ///< bandera[lado] = 1: el hilo que viene de ese lado quiere pasar
+    atomic_int victima;         ///< Lado que llego al ultimo; ese cede el paso
+} NodoTorneo;
+
+DEFINIR_RANURA(RanuraNodoTorneo, NodoTorneo);
+
+/**
+ * @struct CerrojoTorneo
+ * @brief Arbol binario de cerrojos de Peterson para n hilos.
+ *
+ * El filtro recorre n - 1 niveles y en cada uno revisa el nivel de los n hilos: O(n^2)
+ * lecturas compartidas por entrada aunque no haya nadie mas. El torneo acomoda los hilos
+ * en las hojas de un arbol binario completo con hojas = potencia de 2 >= n; cada nodo
+ * interno es un cerrojo de Peterson entre el ganador del subarbol izquierdo y el del
+ * derecho, y quien gana la raiz entra a la region critica. Son log2(hojas) nodos por
+ * entrada, cada uno con 3 variables.
+ *
+ * Los nodos van como un monticulo en un arreglo: la raiz es el 1, los hijos de k son
+ * 2k y 2k + 1, y el hilo i empieza en la hoja hojas + i. Cada nodo ocupa su propia linea
+ * de cache. Como en filtro_c11, la victima se escribe con atomic_exchange (acq_rel) para
+ * que el segundo en llegar vea la bandera del primero.
+ */
+typedef struct {
+    int hojas;
+    int niveles;                ///< log2(hojas)
+    RanuraNodoTorneo *nodos;    ///< nodos[1 .. hojas - 1]
+} CerrojoTorneo;
+
+static inline void *torneo_crear(int num_hilos) {
+    CerrojoTorneo *c = cerrojo_reservar(sizeof(CerrojoTorneo));
+    if (!c) return NULL;
+    c->hojas = 1;
+    c->niveles = 0;
+    while (c->hojas < num_hilos) {
+        c->hojas *= 2;
+        c->niveles++;
+    }
+    c->nodos = ranuras_reservar(c->hojas, sizeof(RanuraNodoTorneo));
+    if (!c->nodos) {
+        free(c);
+        return NULL;
+    }
+    for (int k = 0; k < c->hojas; k++) {
+        atomic_init(&c->nodos[k].valor.bandera[0], 0);
+        atomic_init(&c->nodos[k].valor.bandera[1], 0);
+        atomic_init(&c->nodos[k].valor.victima, 0);
+    }
+    return c;
+}
+
+static inline void torneo_entrar(void *cerrojo, int i) {
+    CerrojoTorneo *c = cerrojo;
+    // Sube de la hoja a la raiz ganando cada nodo del camino
+    for (int k = c->hojas + i; k > 1; k /= 2) {
+        NodoTorneo *nodo = &c->nodos[k / 2].valor;
+        int lado = k & 1;
+        atomic_store_explicit(&nodo->bandera[lado], 1, memory_order_relaxed);
+        atomic_exchange_explicit(&nodo->victima, lado, memory_order_acq_rel);
+        while (atomic_load_explicit(&nodo->bandera[1 - lado], memory_order_acquire) &&
+               atomic_load_explicit(&nodo->victima, memory_order_acquire) == lado) {
+            cerrojo_pausa();
+        }
+    }
+}
+
+static inline void torneo_salir(void *cerrojo, int i) {
+    CerrojoTorneo *c = cerrojo;
+    // Suelta los nodos de la raiz hacia la hoja, al reves de como los tomo
+    for (int nivel = c->niveles; nivel > 0; nivel--) {
+        int k = (c->hojas + i) >> (nivel - 1);
+        atomic_store_explicit(&c->nodos[k / 2].valor.bandera[k & 1], 0, memory_order_release);
+    }
+}
+
+static inline void torneo_destruir(void *cerrojo) {
+    CerrojoTorneo *c = cerrojo;
+    free(c->nodos);
+    free(c);
+}
+
+// atomic_flag: test-and-set (Ej4AtomicFlag.c)
+
+static inline void *tas_crear(int num_hilos) {
+    (void)num_hilos;
+    atomic_flag *f = cerrojo_reservar(sizeof(atomic_flag));
+    if (f) atomic_flag_clear(f);
+    return f;
+}
+
+static inline void tas_entrar(void *cerrojo, int id) {
+    (void)id;
+    while (atomic_flag_test_and_set((atomic_flag *)cerrojo)) {
+        // Espera activa mientras el cerrojo este en uso
+    }
+}
+
+static inline void tas_salir(void *cerrojo, int id) {
+    (void)id;
+    atomic_flag_clear((atomic_flag *)cerrojo);
+}
+
+// Test-and-test-and-set con espera exponencial (Ej4_1AtomicFlagTTAS.c)
+
+#define TTAS_ESPERA_MIN 4       // Pausas de la primera espera tras perder el cerrojo
+#define TTAS_ESPERA_MAX 256     // Tope de pausas; al llegar ahi el hilo cede la CPU
+
+/**
+ * @brief Toma un cerrojo test-and-test-and-set.
+ *
+ * tas_entrar hace atomic_flag_test_and_set en cada vuelta: cada intento es una escritura
+ * que pide la linea de cache en exclusiva, y con varios hilos girando la linea rebota
+ * entre nucleos sin parar (tambien le cuesta al que quiere soltar el cerrojo). Aqui:
+ *      1. Test: se espera con lecturas relajadas. Todos los hilos que esperan comparten la
+ *         linea en sus caches y no generan trafico hasta que el duenio la escribe.
+ *      2. Test-and-set: solo cuando el cerrojo parece libre se intenta el intercambio.
+ *      3. Si otro gano el intercambio, el hilo espera un numero aleatorio de pausas antes
+ *         de volver a intentar, y el limite se duplica en cada fallo hasta TTAS_ESPERA_MAX.
+ *         Asi los perdedores no se lanzan todos a la vez sobre el cerrojo la siguiente
+ *         vez que se libere. Con el tope alcanzado el hilo cede la CPU (sched_yield), lo
+ *         que ayuda cuando hay mas hilos que nucleos.
+ * atomic_flag no tiene una lectura sin escritura, por eso el cerrojo es un atomic_int.
+ */
+static inline void ttas_entrar(void *cerrojo, int id) {
+    atomic_int *ocupado = cerrojo;
+    unsigned espera = TTAS_ESPERA_MIN;
+    unsigned semilla = (unsigned)id * 2654435761u + 1;
+
+    for (;;) {
+        while (atomic_load_explicit(ocupado, memory_order_relaxed)) {
+            cerrojo_pausa();
+        }
+        if (!atomic_exchange_explicit(ocupado, 1, memory_order_acquire)) return;
+
+        semilla = semilla * 1103515245u + 12345u;
+        for (unsigned k = (semilla >> 16) % espera + 1; k > 0; k--) {
+            cerrojo_pausa();
+        }
+        if (espera < TTAS_ESPERA_MAX) {
+            espera *= 2;
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static inline void ttas_salir(void *cerrojo, int id) {
+    (void)id;
+    atomic_store_explicit((atomic_int *)cerrojo, 0, memory_order_release);
+}
+
+// atomic_int con compare_exchange (Ej3AtomicInt.c)
+
+static inline void *cas_crear(int num_hilos) {
+    (void)num_hilos;
+    atomic_int *a = cerrojo_reservar(sizeof(atomic_int));
+    if (a) atomic_init(a, 0);
+    return a;
+}
+
+static inline void cas_entrar(void *cerrojo, int id) {
+    (void)id;
+    int libre = 0;
+    // Si falla, compare_exchange deja en libre el valor que vio: hay que regresarlo a 0
+    while (!atomic_compare_exchange_weak((atomic_int *)cerrojo, &libre, 1)) {
+        libre = 0;
+    }
+}
+
+static inline void cas_salir(void *cerrojo, int id) {
+    (void)id;
+    atomic_store((atomic_int *)cerrojo, 0);
+}
+
+// Cerrojo de turnos (ticket lock)
+
+/**
+ * @struct CerrojoTurnos
+ * @brief Como la fila de una tortilleria: cada hilo toma un numero y espera a que lo llamen.
+ *
+ * Entrar es un atomic_fetch_add sobre siguiente, sin importar cuantos hilos esperen, y
+ * los hilos entran en el orden en que tomaron su numero (FIFO): nadie se queda sin
+ * entrar. Todos esperan leyendo turno, que solo escribe el duenio al salir; siguiente y
+ * turno van en lineas de cache distintas para que tomar numero no moleste al duenio.
+ * Mientras espera, el hilo hace tantas pausas como hilos tiene delante.
+ */
+typedef struct {
+    _Alignas(LINEA_CACHE) atomic_uint siguiente;   ///< Siguiente numero por repartir
+    _Alignas(LINEA_CACHE) atomic_uint turno;       ///< Numero del hilo que puede entrar
+} CerrojoTurnos;
+
+static inline void *ticket_crear(int num_hilos) {
+    (void)num_hilos;
+    CerrojoTurnos *c = cerrojo_reservar(sizeof(CerrojoTurnos));
+    if (!c) return NULL;
+    atomic_init(&c->siguiente, 0);
+    atomic_init(&c->turno, 0);
+    return c;
+}
+
+static inline void ticket_entrar(void *cerrojo, int id) {
+    (void)id;
+    CerrojoTurnos *c = cerrojo;
+    unsigned mio = atomic_fetch_add_explicit(&c->siguiente, 1, memory_order_relaxed);
+    unsigned turno;
+    while ((turno = atomic_load_explicit(&c->turno, memory_order_acquire)) != mio) {
+        for (unsigned k = mio - turno; k > 0; k--) {
+            cerrojo_pausa();
+        }
+    }
+}
+
+static inline void ticket_salir(void *cerrojo, int id) {
+    (void)id;
+    CerrojoTurnos *c = cerrojo;
+    // Solo el duenio escribe turno: basta leerlo y escribir el siguiente
+    unsigned turno = atomic_load_explicit(&c->turno, memory_order_relaxed);
+    atomic_store_explicit(&c->turno, turno + 1, memory_order_release);
+}
+
+// Cerrojo de cola MCS (Mellor-Crummey y Scott)
+
+/**
+ * @struct NodoMCS
+ * @brief Lugar de un hilo en la cola del cerrojo.
+ */
+typedef struct NodoMCS {
+    _Atomic(struct NodoMCS *) siguiente;    ///< Quien espera detras de este hilo
+    atomic_int esperando;                   ///< 1 mientras el de adelante no ceda el cerrojo
+} NodoMCS;
+
+DEFINIR_RANURA(RanuraNodoMCS, NodoMCS);
+
+/**
+ * @struct CerrojoMCS
+ * @brief Cola de hilos en espera, enlazada por sus nodos.
+ *
+ * Los hilos se forman en una lista: entrar es un atomic_exchange sobre cola para ponerse
+ * al final y, si habia alguien, enlazarse detras de el y esperar sobre el campo esperando
+ * del nodo propio. Al salir, el duenio pone en 0 el esperando del siguiente. Asi cada hilo
+ * gira sobre su propia linea de cache (la del ticket la comparten todos) y al soltar el
+ * cerrojo solo se invalida la linea del que sigue. El orden es FIFO, como en el ticket.
+ *
+ * El nodo de cada hilo se reserva con el cerrojo, uno por id y cada uno en su linea.
+ */
+typedef struct {
+    _Atomic(NodoMCS *) cola;    ///< Ultimo hilo de la fila, NULL si el cerrojo esta libre
+    RanuraNodoMCS *nodos;
+} CerrojoMCS;
+
+static inline void *mcs_crear(int num_hilos) {
+    CerrojoMCS *c = cerrojo_reservar(sizeof(CerrojoMCS));
+    if (!c) return NULL;
+    c->nodos = ranuras_reservar(num_hilos, sizeof(RanuraNodoMCS));
+    if (!c->nodos) {
+        free(c);
+        return NULL;
+    }
+    atomic_init(&c->cola, NULL);
+    return c;
+}
+
+static inline void mcs_entrar(void *cerrojo, int id) {
+    CerrojoMCS *c = cerrojo;
+    NodoMCS *yo = &c->nodos[id].valor;
+
+    atomic_store_explicit(&yo->siguiente, NULL, memory_order_relaxed);
+    atomic_store_explicit(&yo->esperando, 1, memory_order_relaxed);
+    NodoMCS *anterior = atomic_exchange_explicit(&c->cola, yo, memory_order_acq_rel);
+    if (anterior) {
+        atomic_store_explicit(&anterior->siguiente, yo, memory_order_release);
+        while (atomic_load_explicit(&yo->esperando, memory_order_acquire)) {
+            cerrojo_pausa();
+        }
+    }
+}
+
+static inline void mcs_salir(void *cerrojo, int id) {
+    CerrojoMCS *c = cerrojo;
+    NodoMCS *yo = &c->nodos[id].valor;
+    NodoMCS *siguiente = atomic_load_explicit(&yo->siguiente, memory_order_acquire);
+
+    if (!siguiente) {
+        // Nadie detras: si la cola sigue en este nodo, el cerrojo queda libre
+        NodoMCS *esperado = yo;
+        if (atomic_compare_exchange_strong_explicit(&c->cola, &esperado, NULL,
+                                                    memory_order_release, memory_order_relaxed)) {
+            return;
+        }
+        // Otro hilo ya hizo el intercambio pero aun no se enlaza detras de este
+        while (!(siguiente = atomic_load_explicit(&yo->siguiente, memory_order_acquire))) {
+            cerrojo_pausa();
+        }
+    }
+    atomic_store_explicit(&siguiente->esperando, 0, memory_order_release);
+}
+
+static inline void mcs_destruir(void *cerrojo) {
+    CerrojoMCS *c = cerrojo;
+    free(c->nodos);
+    free(c);
+}
+
+// pthread_mutex_t (Ej5mutex.c)
+
+static inline void *mutex_crear(int num_hilos) {
+    (void)num_hilos;
+    pthread_mutex_t *m = cerrojo_reservar(sizeof(pthread_mutex_t));
+    if (m) pthread_mutex_init(m, NULL);
+    return m;
+}
+
+static inline void mutex_entrar(void *cerrojo, int id) {
+    (void)id;
+    pthread_mutex_lock((pthread_mutex_t *)cerrojo);
+}
+
+static inline void mutex_salir(void *cerrojo, int id) {
+    (void)id;
+    pthread_mutex_unlock((pthread_mutex_t *)cerrojo);
+}
+
+static inline void mutex_destruir(void *cerrojo) {
+    pthread_mutex_destroy((pthread_mutex_t *)cerrojo);
+    free(cerrojo);
+}
+
+/** @brief Todos los cerrojos, terminados en uno con nombre NULL. */
+static const TipoCerrojo CERROJOS[] = {
+    { "filtro", filtro_crear, filtro_entrar, filtro_salir, filtro_destruir },
+    { "filtro_c11", filtro_c11_crear, filtro_c11_entrar, filtro_c11_salir, filtro_c11_destruir },
+    { "torneo", torneo_crear, torneo_entrar, torneo_salir, torneo_destruir },
+    { "tas",    tas_crear,    tas_entrar,    tas_salir,    free },
+    { "ttas",   cas_crear,    ttas_entrar,   ttas_salir,   free },
+    { "cas",    cas_crear,    cas_entrar,    cas_salir,    free },
+    { "ticket", ticket_crear, ticket_entrar, ticket_salir, free },
+    { "mcs",    mcs_crear,    mcs_entrar,    mcs_salir,    mcs_destruir },
+    { "mutex",  mutex_crear,  mutex_entrar,  mutex_salir,  mutex_destruir },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+/**
+ * @brief Busca un cerrojo por nombre.
+ * @return const TipoCerrojo* El cerrojo, o NULL si no existe
+ */
+static inline const TipoCerrojo *buscar_cerrojo(const char *nombre) {
+    for (const TipoCerrojo *t = CERROJOS; t->nombre; t++) {
+        if (strcmp(t->nombre, nombre) == 0) return t;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Convierte una lista de nombres de cerrojo ("ticket,mcs") a sus tipos.
+ * @param capacidad Elementos que caben en tipos
+ * @return int Numero de cerrojos leidos, o -1 si alguno no existe o no caben
+ */
+static inline int leer_cerrojos(const char *texto, const TipoCerrojo **tipos, int capacidad) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > capacidad) return -1;
+    for (int i = 0; i < l.n; i++) {
+        if ((tipos[i] = buscar_cerrojo(l.partes[i])) == NULL) return -1;
+    }
+    return l.n;
+}
+
+#endif // CERROJOS_H
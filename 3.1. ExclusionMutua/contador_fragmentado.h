@@ -0,0 +1,130 @@
+/**
+ * @file contador_fragmentado.h
+ * @brief Contador compartido repartido en un fragmento por hilo, con modo descuidado.
+ * @author Salvador Gonzalez Arellano
+ *
+ * En Ej3AtomicInt.c todos los hilos hacen atomic_fetch_add sobre el mismo contador. El
+ * resultado es correcto, pero cada incremento necesita la linea de cache del contador en
+ * exclusiva: la linea viaja de nucleo en nucleo en cada suma y agregar hilos no sube el
+ * numero de incrementos por segundo (suele bajarlo).
+ *
+ * Aqui cada hilo suma en su propio fragmento, en su propia linea de cache (../Comun/ranura.h),
+ * y nadie mas escribe ahi: la suma no necesita ni instruccion atomica de lectura-modificacion-
+ * escritura ni mover la linea. El costo pasa a la lectura, que recorre los fragmentos.
+ *
+ *      ContadorFragmentado *c = contador_crear(num_hilos, 0);
+ *      contador_sumar(c, id, 1);           // id en [0, num_hilos)
+ *      long total = contador_leer(c);
+ *      contador_destruir(c);
+ *
+ * Con umbral > 0 el contador es "descuidado" (sloppy counter): cada hilo acumula en su
+ * fragmento y, cuando llega a umbral, lo pasa al total global con un atomic_fetch_add.
+ * contador_leer_aprox lee solo el global, en O(1), y se queda corto a lo mas por
+ * num_hilos * (umbral - 1). Un hilo que termina llama contador_vaciar para pasar lo que
+ * le quede.
+ *
+ * contador_leer suma el global y todos los fragmentos. Es exacta cuando ningun hilo esta
+ * sumando (por ejemplo despues de pthread_join); mientras suman, cada fragmento se lee en
+ * un momento distinto y el resultado es aproximado, pero nunca mayor que el valor real:
+ * contador_vaciar pone el fragmento en 0 antes de pasarlo al global (ver abajo).
+ */
+
+#ifndef CONTADOR_FRAGMENTADO_H
+#define CONTADOR_FRAGMENTADO_H
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "../Comun/ranura.h"
+
+DEFINIR_RANURA(RanuraFragmento, atomic_long);
+
+/**
+ * @struct ContadorFragmentado
+ * @brief Un fragmento por hilo y, en modo descuidado, un total global.
+ */
+typedef struct {
+    _Alignas(LINEA_CACHE) atomic_long global;   ///< Lo que los hilos ya pasaron (modo descuidado)
+    int num_hilos;
+    long umbral;                                ///< 0: sin global, solo fragmentos
+    RanuraFragmento *fragmentos;
+} ContadorFragmentado;
+
+/**
+ * @brief Crea un contador en 0 para num_hilos hilos.
+ * @param umbral 0 para sumar solo en los fragmentos; > 0 para el modo descuidado
+ * @return ContadorFragmentado* El contador, o NULL si no hay memoria
+ */
+static inline ContadorFragmentado *contador_crear(int num_hilos, long umbral) {
+    ContadorFragmentado *c = ranuras_reservar(1, sizeof(ContadorFragmentado));
+    if (!c) return NULL;
+    c->fragmentos = ranuras_reservar(num_hilos, sizeof(RanuraFragmento));
+    if (!c->fragmentos) {
+        free(c);
+        return NULL;
+    }
+    atomic_init(&c->global, 0);
+    c->num_hilos = num_hilos;
+    c->umbral = umbral;
+    for (int i = 0; i < num_hilos; i++) {
+        atomic_init(&c->fragmentos[i].valor, 0);
+    }
+    return c;
+}
+
+static inline void contador_destruir(ContadorFragmentado *c) {
+    free(c->fragmentos);
+    free(c);
+}
+
+/**
+ * @brief Pasa al global lo que el hilo id tiene en su fragmento.
+ *
+ * Primero pone el fragmento en 0 y despues suma al global, con release. Si fuera al
+ * reves, un contador_leer que leyera el global ya sumado y el fragmento aun sin vaciar
+ * contaria local dos veces. Asi, si contador_leer (que lee el global con acquire antes que
+ * los fragmentos) ve la suma, ve tambien el 0; en el peor caso no ve ninguna de las dos y
+ * se queda corto por local.
+ */
+static inline void contador_vaciar(ContadorFragmentado *c, int id) {
+    atomic_long *f = &c->fragmentos[id].valor;
+    long local = atomic_load_explicit(f, memory_order_relaxed);
+    atomic_store_explicit(f, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&c->global, local, memory_order_release);
+}
+
+/**
+ * @brief Suma d al contador desde el hilo id.
+ *
+ * Solo el hilo id escribe su fragmento, asi que basta una lectura y una escritura
+ * relajadas (en x86, un mov y un add normales) en lugar de atomic_fetch_add. Siguen siendo
+ * atomicas para que contador_leer pueda leer el fragmento mientras tanto.
+ */
+static inline void contador_sumar(ContadorFragmentado *c, int id, long d) {
+    atomic_long *f = &c->fragmentos[id].valor;
+    long local = atomic_load_explicit(f, memory_order_relaxed) + d;
+    atomic_store_explicit(f, local, memory_order_relaxed);
+    if (c->umbral > 0 && local >= c->umbral) contador_vaciar(c, id);
+}
+
+/**
+ * @brief Suma el global y todos los fragmentos: O(num_hilos).
+ */
+static inline long contador_leer(ContadorFragmentado *c) {
+    long total = atomic_load_explicit(&c->global, memory_order_acquire);
+    for (int i = 0; i < c->num_hilos; i++) {
+        total += atomic_load_explicit(&c->fragmentos[i].valor, memory_order_acquire);
+    }
+    return total;
+}
+
+/**
+ * @brief Lee solo el global: O(1), pero sin lo que los hilos aun no pasan.
+ *
+ * Sin modo descuidado no hay global y equivale a contador_leer.
+ */
+static inline long contador_leer_aprox(ContadorFragmentado *c) {
+    if (c->umbral == 0) return contador_leer(c);
+    return atomic_load_explicit(&c->global, memory_order_relaxed);
+}
+
+#endif // CONTADOR_FRAGMENTADO_H
@@ -0,0 +1,312 @@
+/**
+ * @file cuenta.h
+ * @brief Cuenta bancaria compartida sin un cerrojo por operacion: atomica (CAS),
+ *        combinada (flat combining) o delegada a un hilo servidor.
+ * @author Salvador Gonzalez Arellano
+ *
+ * En Ej2Cajero.c y Ej6CajeroMutex.c la region critica es solo revisar el saldo y
+ * actualizarlo. Eso cabe en una instruccion atomica, sin cerrojo:
+ *      - Depositar no tiene condicion: atomic_fetch_add.
+ *      - Retirar solo si alcanza: se lee el saldo, y si alcanza se intenta cambiarlo por
+ *        saldo - cantidad con compare_exchange. Si otro hilo lo cambio en medio, el
+ *        compare_exchange falla y deja en saldo el valor nuevo; se vuelve a revisar con el.
+ * Ningun hilo espera a otro: si un compare_exchange falla es porque otro hilo avanzo
+ * (lock-free). Y ningun hilo puede quedar a medias con la cuenta tomada.
+ *
+ *      CuentaAtomica cuenta;
+ *      cuenta_iniciar(&cuenta, 1000);
+ *      cuenta_depositar(&cuenta, 50);
+ *      if (!cuenta_retirar(&cuenta, 30)) printf("Saldo insuficiente\n");
+ *
+ * Las operaciones son relajadas: el saldo no publica otros datos, y cada operacion sobre
+ * una misma variable atomica ya tiene un orden total.
+ *
+ * Con mucha contencion, con cerrojo o con CAS, la linea de cache del saldo (y la del
+ * cerrojo) viaja de nucleo en nucleo en cada operacion. CuentaCombinada y CuentaServidor
+ * hacen que un solo hilo aplique las operaciones de todos, uno tras otro, con el saldo
+ * en su cache: los demas solo escriben su pedido en su propia linea y esperan ahi.
+ */
+
+#ifndef CUENTA_H
+#define CUENTA_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../Comun/ranura.h"
+#include "cerrojos.h"
+
+/**
+ * @struct CuentaAtomica
+ * @brief Saldo en su propia linea de cache.
+ */
+typedef struct {
+    _Alignas(LINEA_CACHE) atomic_long saldo;
+} CuentaAtomica;
+
+static inline void cuenta_iniciar(CuentaAtomica *c, long saldo) {
+    atomic_init(&c->saldo, saldo);
+}
+
+static inline long cuenta_saldo(CuentaAtomica *c) {
+    return atomic_load_explicit(&c->saldo, memory_order_relaxed);
+}
+
+static inline void cuenta_depositar(CuentaAtomica *c, long cantidad) {
+    atomic_fetch_add_explicit(&c->saldo, cantidad, memory_order_relaxed);
+}
+
+/**
+ * @brief Retira cantidad si el saldo alcanza.
+ * @return int 1 si se retiro, 0 si el saldo era insuficiente
+ */
+static inline int cuenta_retirar(CuentaAtomica *c, long cantidad) {
+    long saldo = atomic_load_explicit(&c->saldo, memory_order_relaxed);
+    do {
+        if (saldo < cantidad) return 0;
+    } while (!atomic_compare_exchange_weak_explicit(&c->saldo, &saldo, saldo - cantidad,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    return 1;
+}
+
+// Pedidos publicados por cada hilo (CuentaCombinada y CuentaServidor)
+
+#define CUENTA_PAUSAS_ANTES_DE_CEDER 256   // Vueltas de espera activa antes de sched_yield
+
+/**
+ * @brief Una vuelta de espera: pause, y cada CUENTA_PAUSAS_ANTES_DE_CEDER vueltas cede la
+ *        CPU, por si el hilo que debe avanzar (combinador o servidor) no esta corriendo
+ *        porque hay mas hilos que nucleos.
+ */
+static inline void cuenta_esperar(unsigned *vueltas) {
+    if (++*vueltas % CUENTA_PAUSAS_ANTES_DE_CEDER == 0) {
+        sched_yield();
+    } else {
+        cerrojo_pausa();
+    }
+}
+
+/**
+ * @struct PedidoCuenta
+ * @brief Una operacion que un hilo publica para que otro la aplique.
+ */
+typedef struct {
+    atomic_int pendiente;       ///< 1 desde que el duenio publica hasta que se aplica
+    int operacion;              ///< 0: retiro, 1: deposito
+    long cantidad;
+    int aceptada;               ///< Resultado, valido cuando pendiente vuelve a 0
+} PedidoCuenta;
+
+DEFINIR_RANURA(RanuraPedido, PedidoCuenta);
+
+/**
+ * @brief Aplica una operacion a un saldo que solo toca quien la llama.
+ * @return int 1 si se hizo, 0 si el retiro se rechazo
+ */
+static inline int cuenta_aplicar(long *saldo, int operacion, long cantidad) {
+    if (operacion == 1) {
+        *saldo += cantidad;
+        return 1;
+    }
+    if (*saldo < cantidad) return 0;
+    *saldo -= cantidad;
+    return 1;
+}
+
+/**
+ * @brief Aplica los pedidos pendientes de n hilos y avisa a cada duenio.
+ * @return int Pedidos aplicados
+ */
+static inline int cuenta_atender(long *saldo, RanuraPedido *pedidos, int n) {
+    int aplicados = 0;
+    for (int i = 0; i < n; i++) {
+        PedidoCuenta *p = &pedidos[i].valor;
+        if (atomic_load_explicit(&p->pendiente, memory_order_acquire)) {
+            p->aceptada = cuenta_aplicar(saldo, p->operacion, p->cantidad);
+            atomic_store_explicit(&p->pendiente, 0, memory_order_release);
+            aplicados++;
+        }
+    }
+    return aplicados;
+}
+
+/**
+ * @brief Publica una operacion en el pedido del hilo; release para que quien la aplique
+ *        vea operacion y cantidad.
+ */
+static inline void cuenta_publicar(PedidoCuenta *p, int operacion, long cantidad) {
+    p->operacion = operacion;
+    p->cantidad = cantidad;
+    atomic_store_explicit(&p->pendiente, 1, memory_order_release);
+}
+
+// Combinacion plana (flat combining)
+
+/**
+ * @struct CuentaCombinada
+ * @brief Saldo con un cerrojo cuyo duenio aplica los pedidos de todos (flat combining).
+ *
+ * Para operar, un hilo publica su pedido en su propia linea de cache y trata de tomar el
+ * cerrojo. Si lo toma se vuelve el combinador: recorre los pedidos de todos los hilos, los
+ * aplica en lote al saldo y suelta el cerrojo. Si no lo toma, espera sobre su propio
+ * pedido hasta que un combinador lo aplique (o hasta que el cerrojo se libere sin que lo
+ * hayan visto, y entonces lo intenta el). Un solo traspaso del cerrojo atiende muchas
+ * operaciones, y el saldo se queda en la cache del combinador.
+ *
+ * rondas y aplicados (solo los escribe el combinador) dan el tamanio promedio del lote.
+ */
+typedef struct {
+    _Alignas(LINEA_CACHE) atomic_int ocupada;   ///< Cerrojo del combinador
+    long saldo;                                 ///< Solo lo toca el combinador
+    uint64_t rondas;
+    uint64_t aplicados;
+    int num_hilos;
+    RanuraPedido *pedidos;                      ///< Uno por hilo, cada uno en su linea
+} CuentaCombinada;
+
+/**
+ * @return CuentaCombinada* La cuenta, o NULL si no hay memoria
+ */
+static inline CuentaCombinada *cuenta_combinada_crear(int num_hilos, long saldo) {
+    CuentaCombinada *c = ranuras_reservar(1, sizeof(CuentaCombinada));
+    if (!c) return NULL;
+    c->pedidos = ranuras_reservar(num_hilos, sizeof(RanuraPedido));
+    if (!c->pedidos) {
+        free(c);
+        return NULL;
+    }
+    atomic_init(&c->ocupada, 0);
+    c->saldo = saldo;
+    c->rondas = c->aplicados = 0;
+    c->num_hilos = num_hilos;
+    for (int i = 0; i < num_hilos; i++) {
+        atomic_init(&c->pedidos[i].valor.pendiente, 0);
+    }
+    return c;
+}
+
+static inline void cuenta_combinada_destruir(CuentaCombinada *c) {
+    free(c->pedidos);
+    free(c);
+}
+
+/**
+ * @brief Hace un retiro (operacion 0) o un deposito (operacion 1) desde el hilo id.
+ * @return int 1 si se hizo, 0 si el retiro se rechazo
+ */
+static inline int cuenta_combinada_operar(CuentaCombinada *c, int id, int operacion, long cantidad) {
+    PedidoCuenta *p = &c->pedidos[id].valor;
+    cuenta_publicar(p, operacion, cantidad);
+
+    unsigned vueltas = 0;
+    for (;;) {
+        if (!atomic_load_explicit(&c->ocupada, memory_order_relaxed) &&
+            !atomic_exchange_explicit(&c->ocupada, 1, memory_order_acquire)) {
+            // Combinador: el recorrido incluye el pedido propio
+            c->aplicados += (uint64_t)cuenta_atender(&c->saldo, c->pedidos, c->num_hilos);
+            c->rondas++;
+            atomic_store_explicit(&c->ocupada, 0, memory_order_release);
+            return p->aceptada;
+        }
+        while (atomic_load_explicit(&p->pendiente, memory_order_acquire)) {
+            if (!atomic_load_explicit(&c->ocupada, memory_order_relaxed)) break;
+            cuenta_esperar(&vueltas);
+        }
+        if (!atomic_load_explicit(&p->pendiente, memory_order_acquire)) return p->aceptada;
+    }
+}
+
+// Delegacion a un hilo servidor
+
+/**
+ * @struct CuentaServidor
+ * @brief Saldo que solo toca un hilo servidor dedicado.
+ *
+ * Como la combinacion plana, pero el combinador es siempre el mismo hilo, que no hace
+ * otra cosa que recorrer los pedidos: los clientes nunca toman un cerrojo ni tocan el
+ * saldo. A cambio, el servidor ocupa un nucleo completo aunque no haya pedidos (si hay
+ * mas hilos que nucleos, el servidor y los clientes ceden la CPU cada tanto al esperar).
+ */
+typedef struct {
+    long saldo;                     ///< Solo lo toca el servidor
+    uint64_t rondas;                ///< Recorridos que encontraron al menos un pedido
+    uint64_t aplicados;
+    int num_hilos;
+    RanuraPedido *pedidos;
+    atomic_int detener;
+    pthread_t hilo;
+} CuentaServidor;
+
+static inline void *cuenta_servidor_atender(void *arg) {
+    CuentaServidor *c = arg;
+    unsigned vueltas = 0;
+    while (!atomic_load_explicit(&c->detener, memory_order_relaxed)) {
+        int aplicados = cuenta_atender(&c->saldo, c->pedidos, c->num_hilos);
+        if (aplicados > 0) {
+            c->aplicados += (uint64_t)aplicados;
+            c->rondas++;
+        } else {
+            cuenta_esperar(&vueltas);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Crea la cuenta y arranca su hilo servidor.
+ * @return CuentaServidor* La cuenta, o NULL si no hay memoria o no se creo el hilo
+ */
+static inline CuentaServidor *cuenta_servidor_crear(int num_hilos, long saldo) {
+    CuentaServidor *c = ranuras_reservar(1, sizeof(CuentaServidor));
+    if (!c) return NULL;
+    c->pedidos = ranuras_reservar(num_hilos, sizeof(RanuraPedido));
+    if (!c->pedidos) {
+        free(c);
+        return NULL;
+    }
+    c->saldo = saldo;
+    c->rondas = c->aplicados = 0;
+    c->num_hilos = num_hilos;
+    for (int i = 0; i < num_hilos; i++) {
+        atomic_init(&c->pedidos[i].valor.pendiente, 0);
+    }
+    atomic_init(&c->detener, 0);
+    if (pthread_create(&c->hilo, NULL, cuenta_servidor_atender, c) != 0) {
+        free(c->pedidos);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+/**
+ * @brief Detiene el servidor (los clientes ya deben haber terminado) y libera la cuenta.
+ *        El saldo se puede leer entre cuenta_servidor_detener y cuenta_servidor_destruir.
+ */
+static inline void cuenta_servidor_detener(CuentaServidor *c) {
+    atomic_store_explicit(&c->detener, 1, memory_order_relaxed);
+    pthread_join(c->hilo, NULL);
+}
+
+static inline void cuenta_servidor_destruir(CuentaServidor *c) {
+    free(c->pedidos);
+    free(c);
+}
+
+/**
+ * @brief Hace un retiro (operacion 0) o un deposito (operacion 1) desde el hilo id.
+ * @return int 1 si se hizo, 0 si el retiro se rechazo
+ */
+static inline int cuenta_servidor_operar(CuentaServidor *c, int id, int operacion, long cantidad) {
+    PedidoCuenta *p = &c->pedidos[id].valor;
+    cuenta_publicar(p, operacion, cantidad);
+    unsigned vueltas = 0;
+    while (atomic_load_explicit(&p->pendiente, memory_order_acquire)) {
+        cuenta_esperar(&vueltas);
+    }
+    return p->aceptada;
+}
+
+#endif // CUENTA_H
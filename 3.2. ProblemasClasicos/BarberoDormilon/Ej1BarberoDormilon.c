@@ -9,6 +9,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_CLIENTES 10    // Número total de clientes
 #define NUM_ASIENTOS 3     // Número de asientos disponibles en la sala de espera
@@ -46,7 +47,7 @@ void* barbero(void* arg) {
 void* cliente(void* arg) {
     int id = *(int*)arg;
 
-    usleep(rand() % 2000000);   // Simula el tiempo en que llega el cliente
+    usleep(aleatorio_rango(aleatorio_hilo(), 2000000));   // Simula el tiempo en que llega el cliente
     pthread_mutex_lock(&sala_mutex); // Entra a la sala de espera (sección crítica)
     if (asientosLibres > 0) {
         asientosLibres--;       // Ocupa un asiento
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_FILOSOFOS 5
 #define NUM_CICLOS 50
@@ -29,7 +30,7 @@ void* filosofo(void* arg) {
     int der = (indice+1) % NUM_FILOSOFOS;
     for (int i = 0; i < NUM_CICLOS; i++) {
         printf("Filosofo %d esta pensando\n",indice);
-        tiempoDormir = 100000 + rand() % 400001;    // Aleatorio entre 0.1 y 0.5 segundos
+        tiempoDormir = 100000 + aleatorio_rango(aleatorio_hilo(), 400001);    // Aleatorio entre 0.1 y 0.5 segundos
         //usleep(tiempoDormir);
         sem_wait(&puerta);                          // Intenta acceder al comedor
         sem_wait(&tenedores[izq]);                  // Intenta topmar el tenedor izquierdo
@@ -37,7 +38,7 @@ void* filosofo(void* arg) {
         sem_wait(&tenedores[der]);                  // Intenta topmar el tenedor derecho
         printf("Filosofo %d toma el tenedor derecho\n",indice);
         printf("Filosofo %d esta comiendo\n",indice);
-        tiempoDormir = 100000 + rand() % 400001;    // Aleatorio entre 0.1 y 0.5 segundos
+        tiempoDormir = 100000 + aleatorio_rango(aleatorio_hilo(), 400001);    // Aleatorio entre 0.1 y 0.5 segundos
         //usleep(tiempoDormir);
         sem_post(&tenedores[izq]);                  // Libera el tenedor izquierdo
         printf("Filosofo %d deja el tenedor izquierdo\n",indice);
@@ -54,7 +55,7 @@ void* filosofo(void* arg) {
 int main() {
     pthread_t filosofos[NUM_FILOSOFOS];
     int indices[NUM_FILOSOFOS];
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
     
     // Inicializar semáforos
     for(int i=0; i<NUM_FILOSOFOS; i++){
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_FILOSOFOS 5
 #define NUM_CICLOS 50
@@ -90,11 +91,11 @@ void *filosofo(void *arg) {
 
     for (int i = 0; i < NUM_CICLOS; i++) {
         printf("Filosofo %d esta pensando\n",indice);
-        tiempoDormir = 100000 + rand() % 400001;    // Aleatorio entre 0.1 y 0.5 segundos
+        tiempoDormir = 100000 + aleatorio_rango(aleatorio_hilo(), 400001);    // Aleatorio entre 0.1 y 0.5 segundos
         usleep(tiempoDormir);
         tomar_tenedores(indice);                    // Intentar comer
         printf("Filosofo %d esta comiendo\n",indice);
-        tiempoDormir = 100000 + rand() % 400001;    // Aleatorio entre 0.1 y 0.5 segundos
+        tiempoDormir = 100000 + aleatorio_rango(aleatorio_hilo(), 400001);    // Aleatorio entre 0.1 y 0.5 segundos
         usleep(tiempoDormir);
         soltar_tenedores(indice);
     }
@@ -107,7 +108,7 @@ void *filosofo(void *arg) {
 int main() {
     pthread_t hilos[NUM_FILOSOFOS];
     int ids[NUM_FILOSOFOS];
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
 
     // Inicialización del mutex, semaforos y estados
     pthread_mutex_init(&mutex, NULL);
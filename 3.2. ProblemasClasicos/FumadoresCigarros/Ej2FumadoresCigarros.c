@@ -12,6 +12,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 sem_t fosforo;
 sem_t papel;
@@ -88,7 +89,7 @@ void* fumadorF(void* arg) {
  */
 void* agente(void* arg) {
     while (1) {
-        int r = rand() % 3;
+        int r = aleatorio_rango(aleatorio_hilo(), 3);
 
         switch (r) {
             case 0:
@@ -119,7 +120,7 @@ void* agente(void* arg) {
 int main() {
     pthread_t t_agente, t_fumadorT, t_fumadorP, t_fumadorF;
 
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
 
     // Inicialización de semáforos
     sem_init(&fosforo, 0, 0);
@@ -11,6 +11,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_LECTORES 15    // Número de hilos lectores
 #define NUM_ESCRITORES 5   // Número de hilos escritores
@@ -70,7 +71,7 @@ void permisoEscritura() {
 void* lector(void* arg) {
     int id = *(int*)arg;
 
-    usleep(200000 + rand() % 400001);   // Simula tiempo antes de intentar leer
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001));   // Simula tiempo antes de intentar leer
 
     pthread_mutex_lock(&estado_mutex);
     estado.la++;                        // Se registra como lector activo
@@ -103,7 +104,7 @@ void* lector(void* arg) {
 void* escritor(void* arg) {
     int id = *(int*)arg;
 
-    usleep(100000 + rand() % 500001);   // Simula tiempo antes de intentar escribir
+    usleep(100000 + aleatorio_rango(aleatorio_hilo(), 500001));   // Simula tiempo antes de intentar escribir
 
     pthread_mutex_lock(&estado_mutex);
     estado.ea++;                        // Se registra como escritor activo
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define TAM_BUFFER 5
 #define PRODUCCIONES 20
@@ -30,7 +31,7 @@ pthread_mutex_t mutexBuffer;    // Candado para la sección crítica
 void* productor(void* arg) {
     int producto;
     for (int i = 0; i < PRODUCCIONES; i++) {
-        producto = (rand() % 50) + 1;
+        producto = aleatorio_rango(aleatorio_hilo(), 50) + 1;
         sem_wait(&espacios_libres);         // Esperar un espacio libre
         pthread_mutex_lock(&mutexBuffer);   // Entrar a la sección crítica
         buffer[insercion] = producto;       // Insertar producto
@@ -68,7 +69,7 @@ void* consumidor(void* arg) {
  */
 int main() {
     pthread_t hProductor, hConsumidor;
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
     
     // Inicializar semáforos y mutex
     sem_init(&espacios_libres, 0, TAM_BUFFER);
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define TAM_BUFFER 5
 #define PRODUCCIONES 20
@@ -33,7 +34,7 @@ void* productor(void* arg) {
     int producto, indice, sigPos;
     indice = *(int *)arg;
     for (int i = 0; i < PRODUCCIONES; i++) {
-        producto = (rand() % 50) + 1;
+        producto = aleatorio_rango(aleatorio_hilo(), 50) + 1;
         sem_wait(&espacios_libres);                 // Esperar un espacio libre
         pthread_mutex_lock(&mutexProd);             // Entrar a la sección crítica de los productores
         sigPos = insercion;                         // Obtenemos la siguiente posicion a insertar
@@ -79,7 +80,7 @@ void* consumidor(void* arg) {
 int main() {
     pthread_t hProductores[N], hConsumidores[M];
     int indProd[N], indCons[M];
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
     
     // Inicializar semáforos y mutex
     sem_init(&espacios_libres, 0, TAM_BUFFER);
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_VEHICULOS_A 50
 #define NUM_VEHICULOS_B 50
@@ -32,7 +33,7 @@ sem_t semB; // Semáforo para vehículos del lado B
  */
 void* cruzarAB(void* arg) {
     int indice = *(int*)arg;
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
     // Solicita entrar
     pthread_mutex_lock(&mutex);
     if (puente.adentroB > 0) {
@@ -65,7 +66,7 @@ void* cruzarAB(void* arg) {
  */
 void* cruzarBA(void* arg) {
     int indice = *(int*)arg;
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
     // Solicita entrar
     pthread_mutex_lock(&mutex);
     if (puente.adentroA > 0) {
@@ -102,7 +103,7 @@ int main() {
     puente.esperandoB = 0;
     sem_init(&semA, 0, 0);
     sem_init(&semB, 0, 0);
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
     for (int i = 0; i < NUM_VEHICULOS_A; i++) {
         indicesA[i] = i;
         pthread_create(&vehiculosA[i], NULL, cruzarAB, &indicesA[i]);
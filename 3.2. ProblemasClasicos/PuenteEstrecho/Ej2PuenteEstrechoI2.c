@@ -11,6 +11,7 @@
 #include <pthread.h>
 #include <semaphore.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_VEHICULOS_A 50  // Número de vehículos del lado A
 #define NUM_VEHICULOS_B 50  // Número de vehículos del lado B
@@ -37,7 +38,7 @@ pthread_cond_t cond = PTHREAD_COND_INITIALIZER;    // Variable de condición par
 void* cruzarAB(void* arg) {
     int indice = *(int *)arg;
 
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
 
     // Esperar hasta que no haya vehículos del lado B en el puente
     pthread_mutex_lock(&mutex);
@@ -70,7 +71,7 @@ void* cruzarAB(void* arg) {
 void* cruzarBA(void* arg) {
     int indice = *(int *)arg;
 
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
 
     // Esperar hasta que no haya vehículos del lado A en el puente
     pthread_mutex_lock(&mutex);
@@ -104,7 +105,7 @@ int main() {
     // Inicializar los contadores del puente
     puente.adentroA = 0;
     puente.adentroB = 0;
-    srand(time(NULL)); // Semilla para valores aleatorios (espaciado entre hilos)
+    aleatorio_semilla_hilos(time(NULL)); // Semilla para valores aleatorios (espaciado entre hilos)
     // Crear hilos para vehículos del lado A
     for (int i = 0; i < NUM_VEHICULOS_A; i++) {
         indicesA[i] = i;
@@ -10,6 +10,7 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "../../Comun/aleatorio.h"
 
 #define NUM_VEHICULOS_A 50
 #define NUM_VEHICULOS_B 50
@@ -41,7 +42,7 @@ pthread_cond_t cond = PTHREAD_COND_INITIALIZER;     // Variable condición para
 void* cruzarAB(void* arg) {
     int indice = *(int *)arg;
 
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
 
     pthread_mutex_lock(&mutex);
     puente.esperandoA++;
@@ -89,7 +90,7 @@ void* cruzarAB(void* arg) {
 void* cruzarBA(void* arg) {
     int indice = *(int *)arg;
 
-    usleep(200000 + rand() % 400001); // tiempo que le tomara llegar al puente
+    usleep(200000 + aleatorio_rango(aleatorio_hilo(), 400001)); // tiempo que le tomara llegar al puente
 
     pthread_mutex_lock(&mutex);
     puente.esperandoB++;
@@ -141,7 +142,7 @@ int main() {
     puente.esperandoB = 0;
     puente.cruzadosTurno = 0;
     puente.turno = 1;
-    srand(time(NULL));
+    aleatorio_semilla_hilos(time(NULL));
 
     // Crear hilos del lado A
     for (int i = 0; i < NUM_VEHICULOS_A; i++) {
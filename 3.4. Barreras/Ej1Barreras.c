@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "../Comun/aleatorio.h"
 
 // Número de hilos a crear y sincronizar
 #define NUM_HILOS 4
@@ -34,7 +35,7 @@ void* trabajo(void* arg) {
     int id = *(int*)arg;
 
     printf("Hilo %d realizando trabajo previo a la barrera...\n", id);
-    sleep(rand() % 10);  // Simula trabajo con duración variable
+    sleep(aleatorio_rango(aleatorio_hilo(), 10));  // Simula trabajo con duración variable
 
     printf("Hilo %d esperando en la barrera...\n", id);
     pthread_barrier_wait(&barrera);  // Punto de sincronización
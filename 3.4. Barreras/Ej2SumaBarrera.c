@@ -3,86 +3,492 @@
  * @brief Ejemplo de suma de arreglo usando hilos POSIX y sincronización con barrera
  * @author Salvador Gonzalez Arellano
  *
- * El arreglo se divide en bloques y cada hilo calcula la suma parcial de su bloque.
- * Después de la sincronización con barrera, el hilo 0 suma todos los resultados parciales
- * y muestra la suma total.
+ * El arreglo se divide en bloques y cada hilo calcula la suma parcial de su bloque. Es un
+ * programa de un superpaso del ejecutor BSP (bsp.h): cada hilo deja su suma parcial en su
+ * ranura y, en la barrera, el hilo serial las combina (la reducción del programa). Las
+ * operaciones de suma (OperacionReduccion) y la división en bloques son las de
+ * ../Comun/reduccion.h, que también usa Ej4SumaN.c de la carpeta 2.2.
+ *
+ * Los bloques se calculan con reduccion_bloque: el residuo se reparte entre los primeros
+ * hilos, así que ningún elemento se salta (la versión anterior empezaba cada bloque en
+ * indice * paso + 1 y perdía el primer elemento de cada bloque salvo el del hilo 0).
+ *
+ * Con -t i32 el arreglo es de int32_t y se acumula en int64_t, así que sirve para miles de
+ * millones de elementos. Con -t f64 el arreglo es de double (todos valen 0.1) y se suma con
+ * la suma compensada de Kahan; el programa reporta el error relativo contra n / 10.
+ *
+ * Con -m inclusivo o -m exclusivo calcula la suma prefija (scan) del arreglo de enteros
+ * en un arreglo de int64_t. Es un programa de dos superpasos del ejecutor BSP (bsp.h):
+ *      1. Cada hilo suma su bloque y deja el resultado en su ranura.
+ *      2. Barrera. Cada hilo suma las sumas de los bloques anteriores al suyo para obtener
+ *         su desplazamiento y escribe las sumas prefijas de su bloque a partir de él.
+ * Dentro del bloque el scan se hace de 4 en 4 elementos en registros AVX2 (si se compila
+ * con -march=native en un procesador que lo tenga) o con un lazo escalar.
+ *
+ * Compilación:
+ *      gcc -O3 -march=native -o Ej2SumaBarrera Ej2SumaBarrera.c -lpthread -lm
+ *
+ * Ejecución:
+ *      ./Ej2SumaBarrera                      (1000 elementos, 4 hilos)
+ *      ./Ej2SumaBarrera -e 2G -n 16 -k 5     (2^31 elementos, 16 hilos, mejor de 5)
+ *      ./Ej2SumaBarrera -e 500M -t f64
+ *      ./Ej2SumaBarrera -e 1G -n 8 -m exclusivo
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
 #include <pthread.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "../Comun/reduccion.h"
+#include "../Comun/ranura.h"
+#include "bsp.h"
+#include "../Comun/medicion.h"
+
+#define NUM_HILOS 4             // Número de hilos por defecto
+#define TAM_ARREGLO 1000        // Tamaño del arreglo por defecto
+#define MAX_HILOS 1024          // Límite de -n
+#define CICLO_VALORES 1000      // arreglo[i] = i % CICLO_VALORES + 1
 
-#define NUM_HILOS 4             // Número de hilos
-#define TAM_ARREGLO 1000        // Tamaño total del arreglo
+enum Modo { MODO_SUMA, MODO_INCLUSIVO, MODO_EXCLUSIVO };
 
-int arreglo[TAM_ARREGLO];       // Arreglo de entrada
-int sumas_parciales[NUM_HILOS]; // Arreglo para guardar la suma de cada hilo
+/**
+ * @struct TrabajoSuma
+ * @brief Contexto del programa BSP de la suma.
+ */
+typedef struct {
+    const void *datos;
+    size_t n;
+    int num_hilos;
+    const OperacionReduccion *op;
+    void *parciales;            // Acumulador de cada hilo, una línea de caché por hilo
+} TrabajoSuma;
 
-pthread_barrier_t barrera;      // Barrera para sincronización de hilos
+/**
+ * @struct TrabajoScan
+ * @brief Contexto del programa BSP del scan.
+ */
+typedef struct {
+    const int32_t *entrada;
+    int64_t *salida;
+    size_t n;
+    int num_hilos;
+    int exclusivo;
+    RanuraI64 *sumas_bloque;    // Suma de cada bloque, una línea por hilo
+} TrabajoScan;
 
 /**
- * @brief Función que ejecuta cada hilo.
+ * @brief Convierte texto a un tamaño, aceptando los sufijos k, M y G (potencias de 2).
  *
- * Calcula la suma parcial de una sección del arreglo, la almacena en un arreglo global
- * y espera en la barrera. Después de la barrera, el hilo 0 imprime la suma total.
+ * @param texto Cadena a convertir (por ejemplo "1000", "64M", "2G")
+ * @param dest Donde se guarda el valor
+ * @return int 0 si el texto es válido y mayor que cero, -1 en otro caso
+ */
+int leer_tamano(const char *texto, size_t *dest) {
+    char *fin;
+    errno = 0;
+    unsigned long long valor = strtoull(texto, &fin, 10);
+    if (errno != 0 || fin == texto || texto[0] == '-') return -1;
+
+    int desplazamiento = 0;
+    if (*fin == 'k' || *fin == 'K') desplazamiento = 10;
+    else if (*fin == 'm' || *fin == 'M') desplazamiento = 20;
+    else if (*fin == 'g' || *fin == 'G') desplazamiento = 30;
+    if (desplazamiento) fin++;
+    if (*fin != '\0' || valor == 0 || valor > (SIZE_MAX >> desplazamiento)) return -1;
+
+    *dest = (size_t)valor << desplazamiento;
+    return 0;
+}
+
+/**
+ * @brief Llena el bloque [inicio, fin) del arreglo de enteros.
  *
- * @param arg Puntero a entero que representa el ID del hilo.
- * @return NULL
+ * Se llama desde recorrer_paralelo, así cada hilo toca primero las páginas que después
+ * va a sumar.
  */
-void* sumar_bloque(void* arg) {
-    int indice = *(int*)arg;
-    int paso = TAM_ARREGLO / NUM_HILOS;
-    int inicio =  (indice == 0) ? 0 : indice * paso + 1;
-    int fin = (indice == NUM_HILOS - 1) ? TAM_ARREGLO : (indice + 1) * paso;
+void llenar_i32(size_t inicio, size_t fin, void *contexto) {
+    int32_t *a = contexto;
+    for (size_t i = inicio; i < fin; i++) {
+        a[i] = (int32_t)(i % CICLO_VALORES + 1);
+    }
+}
 
-    int suma = 0;
-    for (int i = inicio; i < fin; i++) {
-        suma += arreglo[i];
+/**
+ * @brief Llena el bloque [inicio, fin) del arreglo de double con 0.1.
+ */
+void llenar_f64(size_t inicio, size_t fin, void *contexto) {
+    double *a = contexto;
+    for (size_t i = inicio; i < fin; i++) {
+        a[i] = 0.1;
     }
-    sumas_parciales[indice] = suma;
-    printf("Hilo %d: suma parcial [%d - %d] = %d\n", indice, inicio, fin, suma);
+}
 
-    // Sincronización con barrera
-    pthread_barrier_wait(&barrera);
+/**
+ * @brief Escribe en salida las sumas prefijas de entrada[inicio, fin) a partir de desplazamiento.
+ *
+ * Con AVX2 se cargan 4 enteros, se extienden a 64 bits y se calcula su scan en el registro
+ * con dos pasos de "desplazar un carril y sumar" (desplazamientos de 1 y de 2 carriles).
+ * Después se suma el acumulado de los grupos anteriores, que se difunde a los 4 carriles
+ * tomando el último carril del resultado.
+ *
+ * @param exclusivo 0 para el scan inclusivo (incluye entrada[i]), 1 para el exclusivo
+ */
+void scan_bloque(const int32_t *entrada, int64_t *salida, size_t inicio, size_t fin,
+                 int64_t desplazamiento, int exclusivo) {
+    size_t i = inicio;
+#ifdef __AVX2__
+    const __m256i cero = _mm256_setzero_si256();
+    __m256i acumulado = _mm256_set1_epi64x(desplazamiento);
+    for (; i + 4 <= fin; i += 4) {
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i *)&entrada[i]));
+        // [a, b, c, d] + [0, a, b, c] = [a, a+b, b+c, c+d]
+        __m256i t = _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), cero, 0x03);
+        __m256i s = _mm256_add_epi64(x, t);
+        // + [0, 0, a, a+b] = [a, a+b, a+b+c, a+b+c+d]
+        t = _mm256_blend_epi32(_mm256_permute4x64_epi64(s, _MM_SHUFFLE(1, 0, 0, 0)), cero, 0x0F);
+        s = _mm256_add_epi64(_mm256_add_epi64(s, t), acumulado);
+        _mm256_storeu_si256((__m256i *)&salida[i], exclusivo ? _mm256_sub_epi64(s, x) : s);
+        acumulado = _mm256_permute4x64_epi64(s, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    desplazamiento = _mm256_extract_epi64(acumulado, 0);
+#endif
+    for (; i < fin; i++) {
+        int64_t siguiente = desplazamiento + entrada[i];
+        salida[i] = exclusivo ? desplazamiento : siguiente;
+        desplazamiento = siguiente;
+    }
+}
+
+/**
+ * @brief Superpaso de cada hilo de la suma: reduce su bloque en su acumulador.
+ * @return BSP_CONTINUAR
+ */
+int superpaso_suma(int id, int superpaso, void *contexto) {
+    (void)superpaso;
+    TrabajoSuma *t = contexto;
+    void *mio = ranura_en(t->parciales, id, t->op->tam_acumulador);
+    size_t inicio, fin;
+    reduccion_bloque(t->n, t->num_hilos, id, &inicio, &fin);
+
+    t->op->identidad(mio);
+    t->op->acumular(t->datos, inicio, fin, mio);
+    return BSP_CONTINUAR;
+}
 
-    int suma_total = 0;
-    for (int i = 0; i < NUM_HILOS; i++) {
-        suma_total += sumas_parciales[i];
+/**
+ * @brief Reducción en la barrera: el hilo serial combina los acumuladores en el del hilo 0.
+ *
+ * Son num_hilos valores, así que combinarlos en un solo hilo cuesta una barrera más (la
+ * que pone bsp_ejecutar después de la reducción) en lugar de log2(num_hilos) rondas del
+ * árbol de reducir_paralelo.
+ *
+ * @return BSP_TERMINAR: la suma es un solo superpaso
+ */
+int combinar_sumas(int superpaso, void *contexto) {
+    (void)superpaso;
+    TrabajoSuma *t = contexto;
+    for (int j = 1; j < t->num_hilos; j++) {
+        t->op->combinar(t->parciales, ranura_en(t->parciales, j, t->op->tam_acumulador));
     }
-    printf("Suma total calculada por hilo %d: %d\n", indice, suma_total);
+    return BSP_TERMINAR;
+}
 
-    return NULL;
+/**
+ * @brief Reduce los n elementos de datos con op y num_hilos hilos como un programa BSP.
+ * @param resultado Donde se copia el acumulador final (op->tam_acumulador bytes)
+ * @return int 0 si todo salio bien, -1 si no se pudo reservar memoria
+ */
+int suma_paralela(const void *datos, size_t n, const OperacionReduccion *op, int num_hilos,
+                  void *resultado) {
+    if ((size_t)num_hilos > n) num_hilos = (int)n;
+    TrabajoSuma t = { datos, n, num_hilos, op, NULL };
+    t.parciales = ranuras_reservar(num_hilos, op->tam_acumulador);
+    if (!t.parciales) {
+        return -1;
+    }
+
+    ProgramaBsp programa = {
+        .num_hilos = num_hilos,
+        .max_superpasos = 1,
+        .superpaso = superpaso_suma,
+        .reducir = combinar_sumas,
+        .contexto = &t,
+    };
+    int superpasos = bsp_ejecutar(&programa);
+
+    memcpy(resultado, t.parciales, op->tam_acumulador);
+    free(t.parciales);
+    return (superpasos == 1) ? 0 : -1;
+}
+
+/**
+ * @brief Superpaso de cada hilo del scan.
+ *
+ * Superpaso 0: suma local del bloque, que queda en la ranura del hilo.
+ * Superpaso 1: cada hilo suma las ranuras de los bloques anteriores al suyo (su
+ * desplazamiento) y hace el scan de su bloque a partir de ahí. Son a lo más num_hilos
+ * lecturas por hilo, y así no hace falta una reducción con su barrera extra: el scan
+ * espera solo en la barrera entre los dos superpasos y en la del final.
+ *
+ * @return BSP_CONTINUAR
+ */
+int superpaso_scan(int id, int superpaso, void *contexto) {
+    TrabajoScan *t = contexto;
+    size_t inicio, fin;
+    reduccion_bloque(t->n, t->num_hilos, id, &inicio, &fin);
+
+    if (superpaso == 0) {
+        int64_t suma = 0;
+        reduccion_acumular_suma_i32(t->entrada, inicio, fin, &suma);
+        t->sumas_bloque[id].valor = suma;
+    } else {
+        int64_t desplazamiento = 0;
+        for (int j = 0; j < id; j++) {
+            desplazamiento += t->sumas_bloque[j].valor;
+        }
+        scan_bloque(t->entrada, t->salida, inicio, fin, desplazamiento, t->exclusivo);
+    }
+    return BSP_CONTINUAR;
+}
+
+/**
+ * @brief Calcula el scan de entrada en salida con num_hilos hilos, como un programa BSP de
+ *        dos superpasos (bsp.h) separados por la barrera.
+ * @return int 0 si todo salio bien, -1 si no se pudo reservar memoria
+ */
+int scan_paralelo(const int32_t *entrada, int64_t *salida, size_t n, int num_hilos, int exclusivo) {
+    if ((size_t)num_hilos > n) num_hilos = (int)n;
+    TrabajoScan t = { entrada, salida, n, num_hilos, exclusivo, NULL };
+    t.sumas_bloque = ranuras_reservar(num_hilos, sizeof(RanuraI64));
+    if (!t.sumas_bloque) {
+        return -1;
+    }
+
+    ProgramaBsp programa = {
+        .num_hilos = num_hilos,
+        .max_superpasos = 2,
+        .superpaso = superpaso_scan,
+        .contexto = &t,
+    };
+    int superpasos = bsp_ejecutar(&programa);
+
+    free(t.sumas_bloque);
+    return (superpasos == 2) ? 0 : -1;
+}
+
+/**
+ * @brief Compara salida contra un scan secuencial de entrada.
+ * @return size_t Índice del primer error, o n si todo coincide
+ */
+size_t verificar_scan(const int32_t *entrada, const int64_t *salida, size_t n, int exclusivo) {
+    int64_t acumulado = 0;
+    for (size_t i = 0; i < n; i++) {
+        int64_t siguiente = acumulado + entrada[i];
+        if (salida[i] != (exclusivo ? acumulado : siguiente)) return i;
+        acumulado = siguiente;
+    }
+    return n;
+}
+
+/**
+ * @brief Suma esperada de arreglo[i] = i % CICLO_VALORES + 1 para i en [0, n).
+ */
+int64_t suma_esperada_i32(size_t n) {
+    int64_t ciclos = (int64_t)(n / CICLO_VALORES), resto = (int64_t)(n % CICLO_VALORES);
+    return ciclos * (CICLO_VALORES * (CICLO_VALORES + 1) / 2) + resto * (resto + 1) / 2;
+}
+
+void uso(const char *programa) {
+    fprintf(stderr,
+            "Uso: %s [-e elementos] [-n hilos] [-t i32|f64] [-m modo] [-k repeticiones]\n"
+            "  -e N   elementos del arreglo, acepta sufijos k, M, G (por defecto %d)\n"
+            "  -n N   número de hilos, 1..%d (por defecto %d)\n"
+            "  -t T   tipo de los elementos: i32 o f64 (por defecto i32)\n"
+            "  -m M   suma, inclusivo o exclusivo (scan, solo i32) (por defecto suma)\n"
+            "  -k N   repeticiones; se reporta la más rápida (por defecto 1)\n",
+            programa, TAM_ARREGLO, MAX_HILOS, NUM_HILOS);
+}
+
+/**
+ * @brief Pone en cero el bloque [inicio, fin) del arreglo de salida del scan (first-touch).
+ */
+void limpiar_i64(size_t inicio, size_t fin, void *contexto) {
+    memset((int64_t *)contexto + inicio, 0, (fin - inicio) * sizeof(int64_t));
+}
+
+/**
+ * @brief Ejecuta el scan repeticiones veces, lo verifica y reporta el mejor tiempo.
+ * @return int Código de salida del programa.
+ */
+int ejecutar_scan(const int32_t *arreglo, size_t n, int num_hilos, int exclusivo, int repeticiones) {
+    if (n > SIZE_MAX / sizeof(int64_t)) {
+        fprintf(stderr, "El arreglo de salida no cabe en memoria.\n");
+        return 1;
+    }
+    int64_t *salida = malloc(n * sizeof(int64_t));
+    if (!salida) {
+        fprintf(stderr, "Error al asignar %zu bytes para la salida.\n", n * sizeof(int64_t));
+        return 1;
+    }
+    recorrer_paralelo(n, num_hilos, limpiar_i64, salida);
+
+    double mejor = INFINITY;
+    for (int k = 0; k < repeticiones; k++) {
+        double inicio = ahora();
+        int codigo = scan_paralelo(arreglo, salida, n, num_hilos, exclusivo);
+        double t = ahora() - inicio;
+        if (codigo != 0) {
+            fprintf(stderr, "Error al reservar memoria para el scan.\n");
+            free(salida);
+            return 1;
+        }
+        if (t < mejor) mejor = t;
+    }
+
+    size_t error = verificar_scan(arreglo, salida, n, exclusivo);
+    printf("Elementos: %zu (i32), hilos: %d, scan %s\n", n, num_hilos,
+           exclusivo ? "exclusivo" : "inclusivo");
+    printf("Último valor: %lld (suma total: %lld)\n", (long long)salida[n - 1],
+           (long long)suma_esperada_i32(n));
+    if (error == n) {
+        printf("Verificación: correcta\n");
+    } else {
+        printf("Verificación: ¡ERROR en el índice %zu!\n", error);
+    }
+    // Se lee la entrada dos veces (fase 1 y fase 2) y se escribe la salida una vez
+    printf("Tiempo: %.6f s, %.3f Gelementos/s, %.2f GB/s\n", mejor, n / mejor / 1e9,
+           n * (2 * sizeof(int32_t) + sizeof(int64_t)) / mejor / 1e9);
+
+    free(salida);
+    return error == n ? 0 : 1;
 }
 
 /**
  * @brief Función principal.
  *
- * Inicializa el arreglo, crea los hilos, espera su finalización y libera recursos.
+ * Lee las opciones, inicializa el arreglo en paralelo, lo suma con suma_paralela (o
+ * calcula su scan con scan_paralelo) y reporta el resultado, el tiempo y el rendimiento.
  *
  * @return int Código de salida del programa.
  */
-int main() {
-    pthread_t hilos[NUM_HILOS];
-    int ids[NUM_HILOS];
+int main(int argc, char *argv[]) {
+    size_t n = TAM_ARREGLO;
+    int num_hilos = NUM_HILOS, repeticiones = 1, usar_f64 = 0;
+    enum Modo modo = MODO_SUMA;
+    size_t temporal;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "e:n:t:m:k:")) != -1) {
+        switch (opcion) {
+            case 'e':
+                if (leer_tamano(optarg, &n) != 0) {
+                    fprintf(stderr, "Número de elementos inválido: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'n':
+                if (leer_tamano(optarg, &temporal) != 0 || temporal > MAX_HILOS) {
+                    fprintf(stderr, "Número de hilos inválido: %s (1..%d)\n", optarg, MAX_HILOS);
+                    return 1;
+                }
+                num_hilos = (int)temporal;
+                break;
+            case 't':
+                if (strcmp(optarg, "i32") == 0) usar_f64 = 0;
+                else if (strcmp(optarg, "f64") == 0) usar_f64 = 1;
+                else {
+                    fprintf(stderr, "Tipo inválido: %s (i32 o f64)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "suma") == 0) modo = MODO_SUMA;
+                else if (strcmp(optarg, "inclusivo") == 0) modo = MODO_INCLUSIVO;
+                else if (strcmp(optarg, "exclusivo") == 0) modo = MODO_EXCLUSIVO;
+                else {
+                    fprintf(stderr, "Modo inválido: %s (suma, inclusivo o exclusivo)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'k':
+                if (leer_tamano(optarg, &temporal) != 0 || temporal > 1000) {
+                    fprintf(stderr, "Repeticiones inválidas: %s (1..1000)\n", optarg);
+                    return 1;
+                }
+                repeticiones = (int)temporal;
+                break;
+            default:
+                uso(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (modo != MODO_SUMA && usar_f64) {
+        fprintf(stderr, "El scan solo está disponible para -t i32.\n");
+        return 1;
+    }
+
+    size_t tam_elemento = usar_f64 ? sizeof(double) : sizeof(int32_t);
+    if (n > SIZE_MAX / tam_elemento) {
+        fprintf(stderr, "El arreglo no cabe en memoria.\n");
+        return 1;
+    }
+    void *arreglo = malloc(n * tam_elemento);
+    if (!arreglo) {
+        fprintf(stderr, "Error al asignar %zu bytes para el arreglo.\n", n * tam_elemento);
+        return 1;
+    }
+    recorrer_paralelo(n, num_hilos, usar_f64 ? llenar_f64 : llenar_i32, arreglo);
 
-    // Inicializa el arreglo con valores de 1 a 16
-    for (int i = 0; i < TAM_ARREGLO; i++) {
-        arreglo[i] = i + 1;
+    if (modo != MODO_SUMA) {
+        int codigo = ejecutar_scan(arreglo, n, num_hilos, modo == MODO_EXCLUSIVO, repeticiones);
+        free(arreglo);
+        return codigo;
     }
 
-    pthread_barrier_init(&barrera, NULL, NUM_HILOS);
+    const OperacionReduccion *op = usar_f64 ? &REDUCCION_SUMA_F64 : &REDUCCION_SUMA_I32;
+    int64_t suma_entera = 0;
+    KahanF64 suma_kahan = {0};
+    double mejor = INFINITY;
 
-    // Crea los hilos
-    for (int i = 0; i < NUM_HILOS; i++) {
-        ids[i] = i;
-        pthread_create(&hilos[i], NULL, sumar_bloque, &ids[i]);
+    for (int k = 0; k < repeticiones; k++) {
+        double inicio = ahora();
+        int codigo = suma_paralela(arreglo, n, op, num_hilos,
+                                   usar_f64 ? (void *)&suma_kahan : (void *)&suma_entera);
+        double t = ahora() - inicio;
+        if (codigo != 0) {
+            fprintf(stderr, "Error al reservar memoria para la reducción.\n");
+            free(arreglo);
+            return 1;
+        }
+        if (t < mejor) mejor = t;
     }
 
-    // Espera a que todos los hilos terminen
-    for (int i = 0; i < NUM_HILOS; i++) {
-        pthread_join(hilos[i], NULL);
+    printf("Elementos: %zu (%s), hilos: %d\n", n, usar_f64 ? "f64" : "i32", num_hilos);
+    if (usar_f64) {
+        double suma = reduccion_kahan_valor(&suma_kahan);
+        double esperada = (double)((long double)n / 10);
+        printf("Suma total: %.6f (esperada: %.6f, error relativo: %.3e)\n",
+               suma, esperada, fabs(suma - esperada) / esperada);
+    } else {
+        int64_t esperada = suma_esperada_i32(n);
+        printf("Suma total: %lld (esperada: %lld)%s\n", (long long)suma_entera,
+               (long long)esperada, suma_entera == esperada ? "" : "  ¡NO COINCIDE!");
     }
+    printf("Tiempo: %.6f s, %.3f Gelementos/s, %.2f GB/s\n",
+           mejor, n / mejor / 1e9, n * tam_elemento / mejor / 1e9);
 
-    pthread_barrier_destroy(&barrera);
+    free(arreglo);
     return 0;
 }
@@ -1,22 +1,43 @@
 /**
  * @file Ej3FiltroImagen.c
- * @brief Ejemplo para aplicar un fiultro auna imagen usando hilos POSIX y sincronización con barrera
+ * @brief Ejemplo para aplicar un filtro a una imagen usando hilos POSIX y sincronización con barrera
  * @author Salvador Gonzalez Arellano
  *
- * Carga una imagen RGB (JPG o PNG) usando stb_image.h.
- * Aplica un filtro promedio 3x3 por canal (R, G, B) usando múltiples hilos.
- * Sincroniza las fases usando pthread_barrier_t.
- * Guarda el resultado como imagen PNG usando stb_image_write.h.
- * 
- * Para compilar el programa: 
- *      gcc -o Ej3FiltroImagen Ej3FiltroImagen.c -lpthread -lm
+ * Carga una imagen RGB (JPG, PNG o HDR) usando stb_image.h, en 8 bits, 16 bits o float.
+ * Aplica un filtro promedio de (2r+1)x(2r+1) por canal (R, G, B) usando múltiples hilos.
+ * Los nucleos del filtro para cada tipo de muestra estan en filtro.h.
+ * Sincroniza las fases usando pthread_barrier_t. En el modo con hilos el ciclo de
+ * iteraciones y la barrera los maneja el ejecutor BSP de bsp.h: el superpaso 0 prepara
+ * la franja de cada hilo y cada superpaso siguiente es una pasada del filtro.
+ * Con -m procesos los trabajadores son procesos creados con fork que comparten las
+ * imagenes por medio de mmap(MAP_SHARED) y se sincronizan con una barrera
+ * PTHREAD_PROCESS_SHARED que tambien vive en memoria compartida.
+ * En ambos modos cada trabajador inicializa su propia franja (first-touch) para que
+ * sus paginas queden en su nodo NUMA; con -a ademas se fija cada trabajador a un CPU
+ * y, si el equipo tiene varios nodos, se reporta cuantas paginas quedaron locales.
+ * Guarda el resultado (PNG, JPG, BMP, TGA o HDR) usando stb_image_write.h.
+ *
+ * Para compilar el programa:
+ *      gcc -O3 -march=native -o Ej3FiltroImagen Ej3FiltroImagen.c -lpthread -lm
  * Para ejecutarlo:
- *      ./Ej3FiltroImagen entrada.jpg salida.jpg 10
- *          - entrada.jpg, imagend e entrada, debe existir
- *          - salida.jpg nombre del archivo de salida (puede o no existir)
- *          - 10, numero de iteraciones del filtro
+ *      ./Ej3FiltroImagen [opciones] entrada.jpg salida.png
+ *          - entrada.jpg, imagen de entrada, debe existir
+ *          - salida.png nombre del archivo de salida (puede o no existir)
+ *      Opciones:
+ *          -i N    numero de iteraciones del filtro (por defecto 1)
+ *          -n N    numero de hilos o procesos (por defecto los nucleos en linea)
+ *          -m MODO hilos o procesos (por defecto hilos)
+ *          -a      fija cada trabajador a un CPU (pthread_setaffinity_np)
+ *          -r N    radio del kernel, 1 => 3x3, 2 => 5x5, ... (por defecto 1)
+ *          -t N    lado del bloque (tile) en pixeles, implica -v bloques (por defecto 0)
+ *          -v VAR  variante: escalar, bloques, vectorial o separable (por defecto escalar)
+ *          -p P    precision de las muestras: 8, 16 o f (float) (por defecto 8)
+ *          -f FMT  formato de salida: png, jpg, bmp, tga o hdr (por defecto segun la extension)
+ *      Por compatibilidad tambien se acepta la forma anterior:
+ *      ./Ej3FiltroImagen entrada.jpg salida.png 10
  */
 
+#define _GNU_SOURCE         // pthread_setaffinity_np, CPU_SET y syscall
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 
@@ -24,20 +45,40 @@
  * #include <...> — Para bibliotecas del sistema
  *  Le dice al compilador: "Busca este archivo solo en las rutas estándar del sistema"
  * #include "..." — Para archivos locales o personalizados
- *  Le dice al compilador: "Primero busca este archivo en el directorio actual, y si 
+ *  Le dice al compilador: "Primero busca este archivo en el directorio actual, y si
  *  no lo encuentra, usa las rutas estándar".
  */
 #include "stb_image.h"          // Biblioteca para cargar la imagen
 #include "stb_image_write.h"    // Biblioteca para escribir la imagen
+#include "filtro.h"             // Nucleos del filtro promedio por tipo de muestra
+#include "bsp.h"                // Ejecutor de superpasos para el modo con hilos
+#include "../Comun/opciones.h"   // leer_entero_int: strtol con validacion de rango
+#include "../Comun/medicion.h"   // ahora: reloj monotono
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
 
-#define NUM_HILOS 4 // Numero de hilos utilizados
+#define MAX_HILOS 1024  // Limite de hilos aceptado por la linea de comandos
+#define MAX_RADIO 64    // Limite del radio del kernel (129x129)
+#define MAX_ITERACIONES (INT_MAX - 1)  // max_superpasos = iteraciones + 1 debe caber en int
+#define MUESTRAS_NUMA 64    // Paginas que se revisan por franja y por imagen con move_pages
 
 // Variables globales para la imagen
-unsigned char *imagen;          // Imagen original cargada
-unsigned char *imagen_nueva;    // Imagen temporal donde se escribe el resultado
+void *imagen;                   // Imagen sobre la que se aplica el filtro
+void *imagen_nueva;             // Imagen temporal donde se escribe el resultado
+void *imagen_cargada;           // Imagen tal como la entrega stb_image
 
 int ancho, alto, canales;       // Dimensiones y canales de la imagen
 
@@ -47,144 +88,663 @@ int ancho, alto, canales;       // Dimensiones y canales de la imagen
  * Cada pasada suaviza un poco mas los bordes y transiciones de color.
  * Aumentar este valor es la forma mas directa de intensificar el filtro.
  */
-int iteraciones;
-
-pthread_barrier_t barrera;      // Barrera para sincronización entre hilos
-
-/**
- * @brief Aplica un filtro promedio 3x3 a un píxel RGB en la posición (i, j)
- * 
- * Se calcula por separado para cada canal (Rojo, Verde, Azul).
- * Se aplica sobre una vecindad de 3x3 (el píxel actual y sus vecinos inmediatos). 
- * Si quisieras un filtro más grande, podrías cambiar los límites a -2 a 2 para hacer un filtro de 5x5, o -3 a 3 para 7x7. 
- * Mayor vecindad ⇒ desenfoque más fuerte por iteracion. 
- * Aumenta el costo computacional.
- * 
- * @param i Fila del píxel
- * @param j Columna del píxel
- * @param canal Canal (0: R, 1: G, 2: B)
- * @return unsigned char Valor promedio del canal
- */
-unsigned char aplicar_filtro(int i, int j, int canal) {
-    int suma = 0;
-    int conteo = 0;
-
-    for (int di = -1; di <= 1; di++) {
-        for (int dj = -1; dj <= 1; dj++) {
-            int ni = i + di;
-            int nj = j + dj;
-            if (ni >= 0 && ni < alto && nj >= 0 && nj < ancho) {
-                int indice = (ni * ancho + nj) * canales + canal;
-                suma += imagen[indice];
-                conteo++;
+int iteraciones = 1;
+
+int num_hilos;                  // Numero de hilos (o procesos) que aplican el filtro
+int usar_procesos = 0;          // 1: los trabajadores son procesos creados con fork
+int fijar_cpu = 0;              // 1: cada trabajador se fija a un CPU
+int muestrear_numa = 0;         // 1: -a con varios nodos; se muestrean y reportan las paginas
+cpu_set_t cpus_permitidos;      // CPUs en los que se puede ejecutar el programa
+ParamsFiltro params = {         // Radio, bloque, precision y variante del filtro
+    .radio = 1,
+    .tam_bloque = 0,
+    .precision = FILTRO_U8,
+    .variante = FILTRO_ESCALAR
+};
+
+pthread_barrier_t *barrera;         // Barrera del modo con procesos (en memoria compartida)
+void **temporales;                  // Renglones temporales de cada hilo en el modo con hilos
+
+/**
+ * @struct MuestraNuma
+ * @brief Resultado del muestreo de paginas de la franja de un trabajador.
+ */
+typedef struct {
+    int cpu;            ///< CPU en el que corre el trabajador (-1 si no se sabe)
+    int nodo;           ///< Nodo NUMA de ese CPU
+    int locales;        ///< Paginas muestreadas que estan en su nodo
+    int remotas;        ///< Paginas muestreadas que estan en otro nodo
+} MuestraNuma;
+
+MuestraNuma *muestras;  // Una por trabajador, en memoria compartida para el modo procesos
+
+/**
+ * @brief Calcula la franja de filas [inicio, fin) que le toca al trabajador id.
+ *
+ * Divide la imagen por bloques horizontales (franjas de filas).
+ */
+void calcular_franja(int id, int *inicio, int *fin) {
+    int filas_por_hilo = alto / num_hilos;
+    *inicio = id * filas_por_hilo;
+    *fin = (id == num_hilos - 1) ? alto : *inicio + filas_por_hilo;
+}
+
+/**
+ * @brief Aplica todas las iteraciones del filtro a la franja del trabajador id.
+ *
+ * Lo usa el modo con procesos; el modo con hilos hace lo mismo con superpaso_filtro.
+ * En lugar de copiar imagen_nueva → imagen al terminar cada pasada, cada trabajador
+ * intercambia sus apuntadores de origen y destino. Todos hacen el mismo
+ * intercambio, por lo que basta una barrera por iteracion: nadie empieza a escribir
+ * la siguiente pasada hasta que todos terminaron de leer la actual.
+ *
+ * @param id Indice del trabajador
+ */
+void filtrar_iteraciones(int id) {
+    int inicio, fin;
+    calcular_franja(id, &inicio, &fin);
+    void *origen = imagen;
+    void *destino = imagen_nueva;
+
+    // Renglones de sumas propios del hilo (solo la variante vectorial los usa)
+    void *temporal = NULL;
+    size_t tam_temporal = filtro_tam_temporal(&params);
+    if (tam_temporal > 0 && (temporal = malloc(tam_temporal)) == NULL) {
+        fprintf(stderr, "Trabajador %d: sin memoria para el renglon temporal\n", id);
+        exit(1);
+    }
+
+    for (int iter = 0; iter < iteraciones; iter++) {
+        filtrar_franja(&params, origen, destino, inicio, fin, temporal);
+
+        // Sincronización: esperar a que todos terminen de escribir
+        pthread_barrier_wait(barrera);
+
+        // Lo que se acaba de escribir es la entrada de la siguiente iteracion
+        void *aux = origen;
+        origen = destino;
+        destino = aux;
+    }
+
+    free(temporal);
+}
+
+/**
+ * @brief Fija al trabajador id a uno de los CPUs permitidos.
+ *
+ * Se reparten en orden: el trabajador i va al i-esimo CPU del conjunto permitido
+ * (dando la vuelta si hay mas trabajadores que CPUs). Sin esto el planificador puede
+ * mover al hilo a otro socket despues de que toco sus paginas, y todos sus accesos
+ * pasarian a ser remotos.
+ *
+ * @param id Indice del trabajador
+ */
+void fijar_a_cpu(int id) {
+    int total = CPU_COUNT(&cpus_permitidos);
+    int objetivo = id % total;
+
+    for (int cpu = 0, visto = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &cpus_permitidos)) continue;
+        if (visto++ == objetivo) {
+            cpu_set_t conjunto;
+            CPU_ZERO(&conjunto);
+            CPU_SET(cpu, &conjunto);
+            int error = pthread_setaffinity_np(pthread_self(), sizeof(conjunto), &conjunto);
+            if (error != 0) {
+                fprintf(stderr, "Trabajador %d: no se pudo fijar al CPU %d: %s\n", id, cpu, strerror(error));
             }
+            return;
         }
     }
-    return (unsigned char)(suma / conteo);
 }
 
 /**
- * @brief Función que ejecuta cada hilo para aplicar el filtro a una región de la imagen.
- * 
- * Divide la imagen por bloques horizontales.
- * 
- * @param arg Puntero al ID del hilo
- * @return NULL 
+ * @brief Cuenta cuantas paginas de un rango estan en el nodo indicado.
+ *
+ * move_pages con nodes = NULL no mueve nada: solo escribe en status el nodo en el
+ * que esta cada pagina. Se revisan a lo mas MUESTRAS_NUMA paginas repartidas en el
+ * rango. Se usa la llamada al sistema directamente para no depender de libnuma.
+ *
+ * @param inicio Inicio del rango
+ * @param bytes Longitud del rango
+ * @param nodo Nodo considerado local
+ * @param m Donde se acumulan las paginas locales y remotas
  */
-void* hilo_filtro(void* arg) {
-    int id = *(int*)arg;
-    int filas_por_hilo = alto / NUM_HILOS;
-    int inicio = id * filas_por_hilo;
-    int fin = (id == NUM_HILOS - 1) ? alto : inicio + filas_por_hilo;
+void muestrear_paginas(const char *inicio, size_t bytes, int nodo, MuestraNuma *m) {
+    long tam_pagina = sysconf(_SC_PAGESIZE);
+    size_t paginas = (bytes + tam_pagina - 1) / tam_pagina;
+    if (paginas == 0) return;
+    size_t paso = (paginas > MUESTRAS_NUMA) ? paginas / MUESTRAS_NUMA : 1;
+    void *direcciones[MUESTRAS_NUMA];
+    int estado[MUESTRAS_NUMA];
+    int n = 0;
 
-    for (int iter = 0; iter < iteraciones; iter++) {
-        for (int i = inicio; i < fin; i++) {
-            for (int j = 0; j < ancho; j++) {
-                for (int c = 0; c < 3; c++) { // Solo R, G, B (ignora canal 4 si hay)
-                    int indice = (i * ancho + j) * canales + c;
-                    imagen_nueva[indice] = aplicar_filtro(i, j, c);
-                }
-            }
+    for (size_t k = 0; k < paginas && n < MUESTRAS_NUMA; k += paso) {
+        direcciones[n++] = (void *)(((uintptr_t)(inicio + k * tam_pagina)) & ~(uintptr_t)(tam_pagina - 1));
+    }
+    if (syscall(SYS_move_pages, 0, (unsigned long)n, direcciones, NULL, estado, 0) != 0) {
+        return;
+    }
+    for (int k = 0; k < n; k++) {
+        if (estado[k] < 0) continue;    // Pagina no presente u otro error
+        if (estado[k] == nodo) m->locales++;
+        else m->remotas++;
+    }
+}
+
+/**
+ * @brief Prepara la franja del trabajador id antes de filtrar.
+ *
+ * Las paginas de un mmap anonimo no existen fisicamente hasta que alguien las toca,
+ * y Linux las coloca en el nodo NUMA del CPU que las toco primero (first-touch).
+ * Por eso cada trabajador copia su propia franja de la imagen cargada a imagen
+ * y pone en cero su franja de imagen_nueva antes de empezar: asi las filas que
+ * mas va a escribir quedan en la memoria local de su nodo.
+ * Antes de filtrar hay que esperar a que todos terminen, porque el filtro tambien lee
+ * las filas vecinas de las otras franjas y estas deben estar copiadas.
+ *
+ * @param id Indice del trabajador
+ */
+void preparar_franja(int id) {
+    int inicio, fin;
+    calcular_franja(id, &inicio, &fin);
+    size_t tam_fila = (size_t)ancho * canales * tam_muestra(params.precision);
+    size_t desde = (size_t)inicio * tam_fila;
+    size_t bytes = (size_t)(fin - inicio) * tam_fila;
+
+    if (fijar_cpu) {
+        fijar_a_cpu(id);
+    }
+
+    memcpy((char *)imagen + desde, (char *)imagen_cargada + desde, bytes);
+    memset((char *)imagen_nueva + desde, 0, bytes);
+
+    // getcpu y move_pages caen en el tiempo medido; solo se hacen si se va a reportar
+    if (!muestrear_numa) return;
+    unsigned int cpu, nodo;
+    MuestraNuma *m = &muestras[id];
+    m->cpu = -1;
+    if (syscall(SYS_getcpu, &cpu, &nodo, NULL) == 0) {
+        m->cpu = (int)cpu;
+        m->nodo = (int)nodo;
+        muestrear_paginas((char *)imagen + desde, bytes, m->nodo, m);
+        muestrear_paginas((char *)imagen_nueva + desde, bytes, m->nodo, m);
+    }
+}
+
+/**
+ * @brief Superpaso BSP de cada hilo en el modo con hilos.
+ *
+ * El superpaso 0 prepara la franja (first-touch) y reserva el renglon temporal del hilo.
+ * El superpaso s >= 1 es la pasada s del filtro: las pasadas impares leen imagen y
+ * escriben imagen_nueva, y las pares al reves. Es el mismo intercambio de apuntadores
+ * que hace filtrar_iteraciones, pero calculado a partir del numero de superpaso. La
+ * barrera entre superpasos la pone bsp_ejecutar.
+ *
+ * @param id Indice del hilo
+ * @param superpaso Numero de superpaso
+ * @param contexto No se usa: el filtro trabaja sobre variables globales
+ * @return BSP_CONTINUAR
+ */
+int superpaso_filtro(int id, int superpaso, void *contexto) {
+    (void)contexto;
+    int inicio, fin;
+    calcular_franja(id, &inicio, &fin);
+
+    if (superpaso == 0) {
+        preparar_franja(id);
+        size_t tam_temporal = filtro_tam_temporal(&params);
+        if (tam_temporal > 0 && (temporales[id] = malloc(tam_temporal)) == NULL) {
+            fprintf(stderr, "Hilo %d: sin memoria para el renglon temporal\n", id);
+            exit(1);
         }
+        return BSP_CONTINUAR;
+    }
 
-        // Sincronización: esperar a que todos terminen de escribir
-        pthread_barrier_wait(&barrera);
-
-        // Copiar imagen_nueva → imagen para la siguiente iteración
-        for (int i = inicio; i < fin; i++) {
-            for (int j = 0; j < ancho; j++) {
-                for (int c = 0; c < 3; c++) {
-                    int indice = (i * ancho + j) * canales + c;
-                    imagen[indice] = imagen_nueva[indice];
-                }
-            }
+    void *origen = (superpaso % 2 == 1) ? imagen : imagen_nueva;
+    void *destino = (superpaso % 2 == 1) ? imagen_nueva : imagen;
+    filtrar_franja(&params, origen, destino, inicio, fin, temporales[id]);
+    return BSP_CONTINUAR;
+}
+
+/**
+ * @brief Reserva memoria anonima sin tocarla.
+ *
+ * Con compartida = 1 la region se comparte con los hijos de fork (MAP_SHARED);
+ * con compartida = 0 es privada del proceso, pero compartida por sus hilos.
+ * A diferencia de malloc + memset, ninguna pagina se asigna fisicamente aqui: cada
+ * una queda en el nodo de quien la toque primero.
+ *
+ * @param tam Bytes a reservar
+ * @param compartida 1 para MAP_SHARED, 0 para MAP_PRIVATE
+ * @return void* Inicio de la region, o NULL si falla
+ */
+void *mapear_memoria(size_t tam, int compartida) {
+    int banderas = (compartida ? MAP_SHARED : MAP_PRIVATE) | MAP_ANONYMOUS;
+    void *region = mmap(NULL, tam, PROT_READ | PROT_WRITE, banderas, -1, 0);
+    return (region == MAP_FAILED) ? NULL : region;
+}
+
+/**
+ * @brief Cuenta los nodos NUMA en linea leyendo /sys/devices/system/node/online.
+ * @return int Numero de nodos (1 si no se puede determinar)
+ */
+int contar_nodos_numa(void) {
+    FILE *f = fopen("/sys/devices/system/node/online", "r");
+    if (!f) return 1;
+
+    // El formato es una lista de rangos, por ejemplo "0-1" o "0,2-3"
+    int nodos = 0, a, b;
+    char separador;
+    while (fscanf(f, "%d", &a) == 1) {
+        b = a;
+        if (fscanf(f, "%c", &separador) == 1 && separador == '-') {
+            if (fscanf(f, "%d", &b) != 1) break;
+            if (fscanf(f, "%c", &separador) != 1) separador = '\n';
         }
+        nodos += b - a + 1;
+        if (separador != ',') break;
+    }
+    fclose(f);
+    return (nodos > 0) ? nodos : 1;
+}
 
-        pthread_barrier_wait(&barrera); // Esperar antes de siguiente iteración
+/**
+ * @brief Imprime el resumen del muestreo de paginas por trabajador.
+ */
+void reportar_numa(void) {
+    int locales = 0, remotas = 0;
+
+    printf("Muestreo NUMA (move_pages, %d nodos):\n", contar_nodos_numa());
+    for (int i = 0; i < num_hilos; i++) {
+        MuestraNuma *m = &muestras[i];
+        if (m->cpu < 0) continue;
+        printf("  Trabajador %d: CPU %d, nodo %d, paginas locales %d, remotas %d\n",
+               i, m->cpu, m->nodo, m->locales, m->remotas);
+        locales += m->locales;
+        remotas += m->remotas;
     }
+    if (locales + remotas > 0) {
+        printf("  Total: %d locales, %d remotas (%.1f%% locales)\n",
+               locales, remotas, 100.0 * locales / (locales + remotas));
+    }
+}
 
-    return NULL;
+/**
+ * @brief Ejecuta el filtro con hilos como un programa BSP de iteraciones + 1 superpasos.
+ * @return int 0 si todo salio bien
+ */
+int ejecutar_hilos(void) {
+    temporales = calloc(num_hilos, sizeof(void *));
+    if (!temporales) {
+        fprintf(stderr, "Error al asignar memoria para los hilos.\n");
+        return -1;
+    }
+
+    ProgramaBsp programa = {
+        .num_hilos = num_hilos,
+        .max_superpasos = iteraciones + 1,
+        .superpaso = superpaso_filtro,
+    };
+    int superpasos = bsp_ejecutar(&programa);
+
+    for (int i = 0; i < num_hilos; i++) {
+        free(temporales[i]);
+    }
+    free(temporales);
+    return (superpasos == iteraciones + 1) ? 0 : -1;
+}
+
+/**
+ * @brief Termina con SIGKILL a los hijos que siguen vivos.
+ *
+ * Un hijo que falla (o que nunca se creo) no llega a la barrera, y los demas se
+ * quedarian esperandolo para siempre: hay que matarlos para que wait regrese.
+ *
+ * @param pids Pids de los hijos; 0 en los que ya se recogieron
+ * @param n Numero de hijos creados
+ */
+void terminar_hijos(const pid_t *pids, int n) {
+    for (int i = 0; i < n; i++) {
+        if (pids[i] > 0) kill(pids[i], SIGKILL);
+    }
+}
+
+/**
+ * @brief Crea los procesos trabajadores con fork y espera a que terminen.
+ *
+ * Los hijos heredan los apuntadores imagen, imagen_nueva y barrera; como apuntan a
+ * regiones MAP_SHARED, lo que escribe un hijo lo ven los demas y el padre.
+ * Si fork falla a la mitad, o un hijo termina con error, el padre mata a los demas
+ * hijos, que si no se quedarian bloqueados en la barrera.
+ *
+ * @return int 0 si todos los hijos terminaron bien
+ */
+int ejecutar_procesos(void) {
+    int codigo = 0;
+    int creados = 0;
+    pid_t *pids = calloc(num_hilos, sizeof(pid_t));
+    if (!pids) {
+        fprintf(stderr, "Error al asignar memoria para los procesos.\n");
+        return -1;
+    }
+
+    fflush(stdout); // Evita que los hijos dupliquen lo que haya en el buffer de salida
+    for (int i = 0; i < num_hilos; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            codigo = -1;
+            terminar_hijos(pids, creados);
+            break;
+        }
+        if (pid == 0) {
+            preparar_franja(i);
+            pthread_barrier_wait(barrera);
+            filtrar_iteraciones(i);
+            _exit(0);
+        }
+        pids[creados++] = pid;
+    }
+
+    int estado;
+    pid_t pid;
+    while ((pid = wait(&estado)) > 0) {
+        for (int i = 0; i < creados; i++) {
+            if (pids[i] == pid) pids[i] = 0;
+        }
+        if (!WIFEXITED(estado) || WEXITSTATUS(estado) != 0) {
+            if (codigo == 0) terminar_hijos(pids, creados);
+            codigo = -1;
+        }
+    }
+    free(pids);
+    return codigo;
+}
+
+/**
+ * @brief Determina el formato de salida a partir de la extension del archivo.
+ * @param nombre Nombre del archivo de salida
+ * @return const char* Extension sin el punto, o "png" si no tiene una conocida
+ */
+const char *formato_por_extension(const char *nombre) {
+    const char *punto = strrchr(nombre, '.');
+    if (punto != NULL) {
+        punto++;
+        if (strcasecmp(punto, "jpg") == 0 || strcasecmp(punto, "jpeg") == 0) return "jpg";
+        if (strcasecmp(punto, "bmp") == 0) return "bmp";
+        if (strcasecmp(punto, "tga") == 0) return "tga";
+        if (strcasecmp(punto, "hdr") == 0) return "hdr";
+    }
+    return "png";
+}
+
+/**
+ * @brief Guarda la imagen en el formato indicado.
+ *
+ * stb_image_write solo escribe 8 bits por canal (PNG, JPG, BMP, TGA) o float (HDR),
+ * asi que las muestras se convierten al escribir:
+ *      - 16 bits → 8 bits redondeando (v * 255 / 65535)
+ *      - float (lineal) → 8 bits aplicando la gamma inversa de stbi_loadf (1/2.2)
+ *      - 8 o 16 bits → float en [0, 1] para HDR (stbi_write_hdr espera valores lineales)
+ *
+ * @param nombre Nombre del archivo de salida
+ * @param formato png, jpg, bmp, tga o hdr
+ * @param datos Muestras de la imagen con la precision de params
+ * @return int Distinto de cero si se guardo correctamente
+ */
+int guardar_imagen(const char *nombre, const char *formato, const void *datos) {
+    size_t n = (size_t)ancho * alto * canales;
+    int hdr = (strcmp(formato, "hdr") == 0);
+    int ok;
+
+    if (hdr && params.precision == FILTRO_F32) {
+        return stbi_write_hdr(nombre, ancho, alto, canales, datos);
+    }
+    if (!hdr && params.precision == FILTRO_U8) {
+        if (strcmp(formato, "jpg") == 0) return stbi_write_jpg(nombre, ancho, alto, canales, datos, 95);
+        if (strcmp(formato, "bmp") == 0) return stbi_write_bmp(nombre, ancho, alto, canales, datos);
+        if (strcmp(formato, "tga") == 0) return stbi_write_tga(nombre, ancho, alto, canales, datos);
+        return stbi_write_png(nombre, ancho, alto, canales, datos, ancho * canales);
+    }
+
+    if (hdr) {
+        // 8 o 16 bits → float lineal
+        float *convertida = malloc(n * sizeof(float));
+        if (!convertida) return 0;
+        for (size_t k = 0; k < n; k++) {
+            convertida[k] = (params.precision == FILTRO_U16)
+                ? ((const uint16_t *)datos)[k] / 65535.0f
+                : powf(((const uint8_t *)datos)[k] / 255.0f, 2.2f);
+        }
+        ok = stbi_write_hdr(nombre, ancho, alto, canales, convertida);
+        free(convertida);
+        return ok;
+    }
+
+    // 16 bits o float → 8 bits
+    unsigned char *convertida = malloc(n);
+    if (!convertida) return 0;
+    for (size_t k = 0; k < n; k++) {
+        if (params.precision == FILTRO_U16) {
+            convertida[k] = (unsigned char)((((const uint16_t *)datos)[k] * 255u + 32767u) / 65535u);
+        } else {
+            float v = powf(((const float *)datos)[k], 1.0f / 2.2f) * 255.0f + 0.5f;
+            convertida[k] = (unsigned char)(v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v));
+        }
+    }
+    ParamsFiltro original = params;
+    params.precision = FILTRO_U8;
+    ok = guardar_imagen(nombre, formato, convertida);
+    params = original;
+    free(convertida);
+    return ok;
+}
+
+/**
+ * @brief Muestra la forma de uso del programa.
+ * @param programa Nombre del ejecutable (argv[0])
+ */
+void uso(const char *programa) {
+    fprintf(stderr, "Uso: %s [-i iteraciones] [-n hilos] [-m hilos|procesos] [-a] [-r radio] [-t bloque] [-v escalar|bloques|vectorial|separable]\n", programa);
+    fprintf(stderr, "        [-p 8|16|f] [-f png|jpg|bmp|tga|hdr] entrada.jpg salida.png\n");
+    fprintf(stderr, "     %s entrada.jpg salida.png 5\n", programa);
 }
 
 /**
  * @brief Función principal.
- * 
- * Carga la imagen de entrada, lanza los hilos para procesarla y guarda el resultado.
- * 
+ *
+ * Lee y valida las opciones, carga la imagen de entrada con la precision pedida,
+ * lanza los hilos para procesarla, reporta el rendimiento y guarda el resultado.
+ *
  * @param argc Número de argumentos
- * @param argv Argumentos de línea de comandos: [entrada] [salida]
+ * @param argv Argumentos de línea de comandos: [opciones] [entrada] [salida]
  * @return int Código de salida
  */
 int main(int argc, char *argv[]) {
-    if (argc < 4) {
-        printf("Uso: %s entrada.jpg salida.png 5\n", argv[0]);
-        return 1;
+    const char *formato = NULL;
+    const char *nombres_variante[] = {"escalar", "bloques", "vectorial", "separable"};
+    const char *nombres_precision[] = {"8 bits", "16 bits", "float"};
+    int variante_explicita = 0;
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    num_hilos = (nucleos > 0 && nucleos <= MAX_HILOS) ? (int)nucleos : 4;
+
+    int opcion;
+    while ((opcion = getopt(argc, argv, "i:n:m:ar:t:v:p:f:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'i': valido = leer_entero_int(optarg, "iteraciones", 0, MAX_ITERACIONES, &iteraciones); break;
+            case 'n': valido = leer_entero_int(optarg, "hilos", 1, MAX_HILOS, &num_hilos); break;
+            case 'a': fijar_cpu = 1; break;
+            case 'm':
+                if (strcmp(optarg, "hilos") == 0) usar_procesos = 0;
+                else if (strcmp(optarg, "procesos") == 0) usar_procesos = 1;
+                else {
+                    fprintf(stderr, "Modo no soportado: %s\n", optarg);
+                    valido = -1;
+                }
+                break;
+            case 'r': valido = leer_entero_int(optarg, "radio", 1, MAX_RADIO, &params.radio); break;
+            case 't': valido = leer_entero_int(optarg, "bloque", 0, INT_MAX, &params.tam_bloque); break;
+            case 'v':
+                variante_explicita = 1;
+                if (strcmp(optarg, "escalar") == 0) params.variante = FILTRO_ESCALAR;
+                else if (strcmp(optarg, "bloques") == 0) params.variante = FILTRO_BLOQUES;
+                else if (strcmp(optarg, "vectorial") == 0) params.variante = FILTRO_VECTORIAL;
+                else if (strcmp(optarg, "separable") == 0) params.variante = FILTRO_SEPARABLE;
+                else {
+                    fprintf(stderr, "Variante no soportada: %s\n", optarg);
+                    valido = -1;
+                }
+                break;
+            case 'p':
+                if (strcmp(optarg, "8") == 0) params.precision = FILTRO_U8;
+                else if (strcmp(optarg, "16") == 0) params.precision = FILTRO_U16;
+                else if (strcmp(optarg, "f") == 0) params.precision = FILTRO_F32;
+                else {
+                    fprintf(stderr, "Precision no soportada: %s\n", optarg);
+                    valido = -1;
+                }
+                break;
+            case 'f':
+                formato = optarg;
+                if (strcmp(formato, "png") != 0 && strcmp(formato, "jpg") != 0 &&
+                    strcmp(formato, "bmp") != 0 && strcmp(formato, "tga") != 0 &&
+                    strcmp(formato, "hdr") != 0) {
+                    fprintf(stderr, "Formato de salida no soportado: %s\n", formato);
+                    valido = -1;
+                }
+                break;
+            default: valido = -1;
+        }
+        if (valido != 0) {
+            uso(argv[0]);
+            return 1;
+        }
+    }
+    // Un tamaño de bloque sin variante explicita significa recorrer por bloques
+    if (params.tam_bloque > 0 && !variante_explicita) {
+        params.variante = FILTRO_BLOQUES;
     }
 
-    iteraciones = (int) *argv[3];
+    int posicionales = argc - optind;
+    if (posicionales == 3) {
+        // Forma anterior: entrada salida iteraciones
+        if (leer_entero_int(argv[optind + 2], "iteraciones", 0, MAX_ITERACIONES, &iteraciones) != 0) {
+            uso(argv[0]);
+            return 1;
+        }
+    } else if (posicionales != 2) {
+        uso(argv[0]);
+        return 1;
+    }
+    const char *entrada = argv[optind];
+    const char *salida = argv[optind + 1];
+    if (formato == NULL) {
+        formato = formato_por_extension(salida);
+    }
 
     // Cargar imagen forzando a RGB (3 canales) al final del archivo una explicacion detallada
-    imagen = stbi_load(argv[1], &ancho, &alto, &canales, 3);
+    switch (params.precision) {
+        case FILTRO_U16: imagen = stbi_load_16(entrada, &ancho, &alto, &canales, 3); break;
+        case FILTRO_F32: imagen = stbi_loadf(entrada, &ancho, &alto, &canales, 3); break;
+        default:         imagen = stbi_load(entrada, &ancho, &alto, &canales, 3); break;
+    }
     if (!imagen) {
-        fprintf(stderr, "Error al cargar la imagen: %s\n", argv[1]);
+        fprintf(stderr, "Error al cargar la imagen %s: %s\n", entrada, stbi_failure_reason());
         return 1;
     }
 
     canales = 3; // Aseguramos que trabajamos con RGB
-    imagen_nueva = malloc(ancho * alto * canales);
-    if (!imagen_nueva) {
-        fprintf(stderr, "Error al asignar memoria para imagen nueva.\n");
-        stbi_image_free(imagen);
+    params.ancho = ancho;
+    params.alto = alto;
+    params.canales = canales;
+    // No tiene caso tener mas hilos que filas, los sobrantes no tendrian trabajo
+    if (num_hilos > alto) {
+        num_hilos = alto;
+    }
+
+    // Las imagenes se reservan sin tocar para que cada trabajador toque primero su franja;
+    // en el modo con procesos ademas deben estar en memoria compartida con los hijos
+    size_t tam_imagen = (size_t)ancho * alto * canales * tam_muestra(params.precision);
+    imagen_cargada = imagen;
+    imagen = mapear_memoria(tam_imagen, usar_procesos);
+    imagen_nueva = mapear_memoria(tam_imagen, usar_procesos);
+    muestras = mapear_memoria(sizeof(MuestraNuma) * num_hilos, usar_procesos);
+    if (!imagen || !imagen_nueva || !muestras) {
+        fprintf(stderr, "Error al asignar memoria para las imagenes.\n");
+        stbi_image_free(imagen_cargada);
         return 1;
     }
+    sched_getaffinity(0, sizeof(cpus_permitidos), &cpus_permitidos);
+    // Solo tiene sentido hablar de paginas locales y remotas con varios nodos
+    muestrear_numa = fijar_cpu && contar_nodos_numa() > 1;
 
-    pthread_barrier_init(&barrera, NULL, NUM_HILOS);
+    if (usar_procesos) {
+        barrera = mapear_memoria(sizeof(pthread_barrier_t), 1);
+        if (!barrera) {
+            fprintf(stderr, "Error al crear la memoria compartida.\n");
+            stbi_image_free(imagen_cargada);
+            return 1;
+        }
+        pthread_barrierattr_t atributos;
+        pthread_barrierattr_init(&atributos);
+        pthread_barrierattr_setpshared(&atributos, PTHREAD_PROCESS_SHARED);
+        pthread_barrier_init(barrera, &atributos, num_hilos);
+        pthread_barrierattr_destroy(&atributos);
+    }
+
+    printf("Imagen %dx%d (%s), %d iteraciones, %d %s, kernel %dx%d, variante %s",
+           ancho, alto, nombres_precision[params.precision], iteraciones, num_hilos,
+           usar_procesos ? "procesos" : "hilos",
+           2 * params.radio + 1, 2 * params.radio + 1, nombres_variante[params.variante]);
+    if (params.variante == FILTRO_BLOQUES) {
+        printf(" (bloque %d)", params.tam_bloque);
+    }
+    printf("\n");
+
+    double t_inicio = ahora();
 
-    pthread_t hilos[NUM_HILOS];
-    int ids[NUM_HILOS];
+    int codigo = usar_procesos ? ejecutar_procesos() : ejecutar_hilos();
 
-    for (int i = 0; i < NUM_HILOS; i++) {
-        ids[i] = i;
-        pthread_create(&hilos[i], NULL, hilo_filtro, &ids[i]);
+    double segundos = ahora() - t_inicio;
+    if (usar_procesos) {
+        pthread_barrier_destroy(barrera);
+    }
+    if (codigo != 0) {
+        fprintf(stderr, "Algun trabajador termino con error.\n");
+        return 1;
     }
 
-    for (int i = 0; i < NUM_HILOS; i++) {
-        pthread_join(hilos[i], NULL);
+    if (segundos > 0 && iteraciones > 0) {
+        printf("Tiempo: %.3f s, %.1f megapixeles/s\n", segundos,
+               (double)ancho * alto * iteraciones / segundos / 1e6);
     }
 
-    pthread_barrier_destroy(&barrera);
+    if (muestrear_numa) {
+        reportar_numa();
+    }
+
+    // Tras un numero impar de pasadas el resultado quedo en imagen_nueva
+    const void *resultado = (iteraciones % 2 == 1) ? imagen_nueva : imagen;
 
     // Guardar imagen resultante
-    if (!stbi_write_png(argv[2], ancho, alto, canales, imagen, ancho * canales)) {
+    if (!guardar_imagen(salida, formato, resultado)) {
         fprintf(stderr, "Error al guardar la imagen.\n");
+        codigo = 1;
     } else {
-        printf("Imagen guardada en %s\n", argv[2]);
+        printf("Imagen guardada en %s (%s)\n", salida, formato);
     }
 
-    free(imagen_nueva);
-    stbi_image_free(imagen);
+    munmap(imagen, tam_imagen);
+    munmap(imagen_nueva, tam_imagen);
+    munmap(muestras, sizeof(MuestraNuma) * num_hilos);
+    if (usar_procesos) {
+        munmap(barrera, sizeof(pthread_barrier_t));
+    }
+    stbi_image_free(imagen_cargada);
 
-    return 0;
+    return codigo;
 }
 
 /**
@@ -0,0 +1,343 @@
+/**
+ * @file Ej4BenchFiltro.c
+ * @brief Banco de pruebas del filtro promedio con imagenes sinteticas y salida CSV.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Genera imagenes sinteticas reproducibles de 1, 12, 50 y 200 megapixeles (relacion 4:3)
+ * y ejecuta cada variante del filtro de filtro.h (escalar, vectorial, bloques y separable)
+ * con distintos numeros de hilos. Por cada corrida imprime una linea CSV con:
+ *      - megapixeles/s procesados (pixeles * iteraciones / segundos)
+ *      - bytes por pixel que cargan y guardan los nucleos (modelo por variante) y los GB/s
+ *        que eso representa
+ *      - aceleracion respecto a la misma variante con el primer numero de hilos de la lista
+ *      - una suma de verificacion (FNV-1a) de la imagen resultante; en 8 y 16 bits todas
+ *        las variantes deben dar la misma, si no es asi hay un error en algun nucleo
+ *
+ * Cada hilo genera su propia franja de la imagen (first-touch) y despues se mide solo
+ * el tiempo de las iteraciones, entre dos barreras.
+ *
+ * Para compilar el programa:
+ *      gcc -O3 -march=native -o Ej4BenchFiltro Ej4BenchFiltro.c -lpthread -lm
+ * Para ejecutarlo:
+ *      ./Ej4BenchFiltro > resultados.csv
+ *      ./Ej4BenchFiltro -s 1,12 -n 1,2,4 -v vectorial,separable -p 16 -r 2 -i 3
+ *      Opciones:
+ *          -s LISTA    tamaños en megapixeles (por defecto 1,12,50,200)
+ *          -n LISTA    numeros de hilos (por defecto 1,2,4,... hasta los nucleos en linea)
+ *          -v LISTA    variantes (por defecto escalar,vectorial,bloques,separable)
+ *          -p P        precision: 8, 16 o f (por defecto 8)
+ *          -r N        radio del kernel (por defecto 1)
+ *          -i N        iteraciones por corrida (por defecto 3)
+ *          -t N        lado del bloque para la variante bloques (por defecto 64)
+ *          -k N        repeticiones por corrida, se reporta la mas rapida (por defecto 1)
+ */
+
+#include "filtro.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#define MAX_LISTA 32        // Elementos maximos en cada lista de la linea de comandos
+#define MAX_HILOS 1024      // Limite de hilos aceptado por la linea de comandos
+#define CANALES 3           // Las imagenes sinteticas son RGB
+
+// Estado de la corrida en curso, compartido por todos los hilos
+ParamsFiltro params;
+void *imagen;                   // Imagen de entrada de cada pasada
+void *imagen_nueva;             // Imagen de salida de cada pasada
+int num_hilos;
+int iteraciones = 3;
+pthread_barrier_t barrera;
+double t_inicio, t_fin;             // Los escribe el hilo 0
+
+/**
+ * @brief Valor sintetico reproducible del canal c del pixel (x, y).
+ *
+ * Mezcla un degradado (que el filtro conserva) con ruido de una funcion hash (que el
+ * filtro suaviza), asi el resultado no es trivial y no depende de un archivo.
+ */
+static inline uint32_t valor_sintetico(uint32_t x, uint32_t y, uint32_t c) {
+    uint32_t h = x * 73856093u ^ y * 19349663u ^ c * 83492791u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return ((x + 2 * y + 85 * c) * 64 + (h & 0x3FFF)) & 0xFFFF;  // 16 bits
+}
+
+/**
+ * @brief Genera las filas [inicio, fin) de la imagen sintetica en la precision de params.
+ */
+void generar_franja(void *destino, int inicio, int fin) {
+    for (int i = inicio; i < fin; i++) {
+        for (int j = 0; j < params.ancho; j++) {
+            for (int c = 0; c < CANALES; c++) {
+                size_t k = ((size_t)i * params.ancho + j) * CANALES + c;
+                uint32_t v = valor_sintetico(j, i, c);
+                switch (params.precision) {
+                    case FILTRO_U8:  ((uint8_t *)destino)[k] = (uint8_t)(v >> 8); break;
+                    case FILTRO_U16: ((uint16_t *)destino)[k] = (uint16_t)v; break;
+                    case FILTRO_F32: ((float *)destino)[k] = v / 65535.0f; break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Trabajo de cada hilo: genera su franja, espera a todos y aplica las iteraciones.
+ * @param arg Puntero al ID del hilo
+ * @return NULL
+ */
+void *hilo_bench(void *arg) {
+    int id = *(int *)arg;
+    int filas_por_hilo = params.alto / num_hilos;
+    int inicio = id * filas_por_hilo;
+    int fin = (id == num_hilos - 1) ? params.alto : inicio + filas_por_hilo;
+    void *origen = imagen;
+    void *destino = imagen_nueva;
+
+    void *temporal = NULL;
+    size_t tam_temporal = filtro_tam_temporal(&params);
+    if (tam_temporal > 0 && (temporal = malloc(tam_temporal)) == NULL) {
+        fprintf(stderr, "Hilo %d: sin memoria para el renglon temporal\n", id);
+        exit(1);
+    }
+
+    // First-touch: cada hilo crea su franja de entrada y toca su franja de salida
+    generar_franja(origen, inicio, fin);
+    size_t tam_fila = (size_t)params.ancho * CANALES * tam_muestra(params.precision);
+    memset((char *)destino + (size_t)inicio * tam_fila, 0, (size_t)(fin - inicio) * tam_fila);
+
+    pthread_barrier_wait(&barrera);
+    if (id == 0) t_inicio = ahora();
+
+    for (int iter = 0; iter < iteraciones; iter++) {
+        filtrar_franja(&params, origen, destino, inicio, fin, temporal);
+        pthread_barrier_wait(&barrera);
+        void *aux = origen;
+        origen = destino;
+        destino = aux;
+    }
+
+    if (id == 0) t_fin = ahora();
+    free(temporal);
+    return NULL;
+}
+
+/**
+ * @brief Suma de verificacion FNV-1a de 64 bits de una imagen.
+ */
+uint64_t suma_verificacion(const void *datos, size_t bytes) {
+    const unsigned char *b = datos;
+    uint64_t h = 1469598103934665603ull;
+    for (size_t k = 0; k < bytes; k++) {
+        h ^= b[k];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * @brief Ejecuta una corrida completa con los parametros actuales.
+ *
+ * Las imagenes se reservan con mmap en cada corrida y no se tocan aqui: como la
+ * franja de cada hilo cambia con el numero de hilos, cada corrida debe volver a
+ * hacer el first-touch con su propio reparto.
+ *
+ * @param segundos Donde se guarda el tiempo de las iteraciones
+ * @param verificacion Donde se guarda la suma de verificacion del resultado
+ * @return int 0 si la corrida se realizo, -1 si no hubo memoria
+ */
+int ejecutar_corrida(double *segundos, uint64_t *verificacion) {
+    pthread_t hilos[MAX_HILOS];
+    int ids[MAX_HILOS];
+    size_t tam_imagen = (size_t)params.ancho * params.alto * CANALES * tam_muestra(params.precision);
+
+    imagen = mmap(NULL, tam_imagen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    imagen_nueva = mmap(NULL, tam_imagen, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (imagen == MAP_FAILED || imagen_nueva == MAP_FAILED) {
+        if (imagen != MAP_FAILED) munmap(imagen, tam_imagen);
+        if (imagen_nueva != MAP_FAILED) munmap(imagen_nueva, tam_imagen);
+        return -1;
+    }
+
+    pthread_barrier_init(&barrera, NULL, num_hilos);
+    for (int i = 0; i < num_hilos; i++) {
+        ids[i] = i;
+        if (pthread_create(&hilos[i], NULL, hilo_bench, &ids[i]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    pthread_barrier_destroy(&barrera);
+
+    // Tras un numero impar de pasadas el resultado quedo en imagen_nueva
+    const void *resultado = (iteraciones % 2 == 1) ? imagen_nueva : imagen;
+    *verificacion = suma_verificacion(resultado, tam_imagen);
+    *segundos = t_fin - t_inicio;
+
+    munmap(imagen, tam_imagen);
+    munmap(imagen_nueva, tam_imagen);
+    return 0;
+}
+
+/**
+ * @brief Modelo de bytes que cargan y guardan los nucleos por pixel de salida y pasada.
+ *
+ * s = bytes por muestra, a = bytes del acumulador, v = bytes del acumulador vertical del
+ * separable (double en float), w = 2r+1, c = canales.
+ *      - escalar/bloques: lee w*w muestras y escribe una, por canal.
+ *      - vectorial: lee w filas de entrada, escribe y relee el renglon vertical w veces,
+ *        escribe y relee el horizontal y escribe la salida.
+ *      - separable: lee w muestras para la suma horizontal, escribe el anillo, lee la fila
+ *        que entra y la que sale, actualiza el acumulador y escribe la salida.
+ */
+double bytes_por_pixel(const ParamsFiltro *p) {
+    double s = (double)tam_muestra(p->precision);
+    double a = (p->precision == FILTRO_F32) ? sizeof(float) : sizeof(int32_t);
+    double v = (p->precision == FILTRO_F32) ? sizeof(double) : a;
+    double w = 2 * p->radio + 1;
+    double c = p->canales;
+
+    switch (p->variante) {
+        case FILTRO_VECTORIAL: return c * (w * s + a + w * a + a + a + s);
+        case FILTRO_SEPARABLE: return c * (w * s + a + 2 * a + 2 * v + v + s);
+        default:               return c * (w * w * s + s);
+    }
+}
+
+/**
+ * @brief Convierte una lista de nombres de variante a valores de Variante.
+ * @return int Numero de variantes leidas, o -1 si alguna no existe
+ */
+int leer_variantes(const char *texto, const char *nombres[], int *valores) {
+    char copia[256];
+    int n = 0;
+    strncpy(copia, texto, sizeof(copia) - 1);
+    copia[sizeof(copia) - 1] = '\0';
+
+    for (char *parte = strtok(copia, ","); parte != NULL; parte = strtok(NULL, ",")) {
+        int encontrada = -1;
+        for (int v = 0; v <= FILTRO_SEPARABLE; v++) {
+            if (strcmp(parte, nombres[v]) == 0) encontrada = v;
+        }
+        if (encontrada < 0 || n == MAX_LISTA) {
+            fprintf(stderr, "Variante no soportada: %s\n", parte);
+            return -1;
+        }
+        valores[n++] = encontrada;
+    }
+    return (n > 0) ? n : -1;
+}
+
+/**
+ * @brief Función principal: lee las listas de la linea de comandos y recorre todas las
+ *        combinaciones de tamaño, variante y numero de hilos.
+ * @return int Código de salida
+ */
+int main(int argc, char *argv[]) {
+    const char *nombres_variante[] = {"escalar", "bloques", "vectorial", "separable"};
+    const char *nombres_precision[] = {"8", "16", "f"};
+    int tamanos[MAX_LISTA] = {1, 12, 50, 200}, num_tamanos = 4;
+    int hilos[MAX_LISTA], num_listas_hilos = 0;
+    int variantes[MAX_LISTA] = {FILTRO_ESCALAR, FILTRO_VECTORIAL, FILTRO_BLOQUES, FILTRO_SEPARABLE};
+    int num_variantes = 4;
+    int repeticiones = 1;
+
+    params.canales = CANALES;
+    params.radio = 1;
+    params.tam_bloque = 64;
+    params.precision = FILTRO_U8;
+
+    // Por defecto: potencias de 2 hasta los nucleos en linea, y los nucleos mismos
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nucleos < 1) nucleos = 1;
+    if (nucleos > MAX_HILOS) nucleos = MAX_HILOS;
+    for (int h = 1; h < nucleos && num_listas_hilos < MAX_LISTA - 1; h *= 2) {
+        hilos[num_listas_hilos++] = h;
+    }
+    hilos[num_listas_hilos++] = (int)nucleos;
+
+    int opcion;
+    while ((opcion = getopt(argc, argv, "s:n:v:p:r:i:t:k:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 's': valido = num_tamanos = leer_lista_int(optarg, "tamaño", 1, 2000, tamanos, MAX_LISTA); break;
+            case 'n': valido = num_listas_hilos = leer_lista_int(optarg, "hilos", 1, MAX_HILOS, hilos, MAX_LISTA); break;
+            case 'v': valido = num_variantes = leer_variantes(optarg, nombres_variante, variantes); break;
+            case 'p':
+                if (strcmp(optarg, "8") == 0) params.precision = FILTRO_U8;
+                else if (strcmp(optarg, "16") == 0) params.precision = FILTRO_U16;
+                else if (strcmp(optarg, "f") == 0) params.precision = FILTRO_F32;
+                else valido = -1;
+                break;
+            case 'r': valido = leer_entero_int(optarg, "radio", 1, 64, &params.radio); break;
+            case 'i': valido = leer_entero_int(optarg, "iteraciones", 1, INT_MAX, &iteraciones); break;
+            case 't': valido = leer_entero_int(optarg, "bloque", 1, INT_MAX, &params.tam_bloque); break;
+            case 'k': valido = leer_entero_int(optarg, "repeticiones", 1, 1000, &repeticiones); break;
+            default: valido = -1;
+        }
+        if (valido < 0) {
+            fprintf(stderr, "Uso: %s [-s 1,12,50,200] [-n 1,2,4] [-v escalar,vectorial,bloques,separable]\n"
+                            "        [-p 8|16|f] [-r radio] [-i iteraciones] [-t bloque] [-k repeticiones]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("megapixeles,ancho,alto,precision,variante,radio,hilos,iteraciones,segundos,"
+           "mp_s,bytes_por_pixel,gb_s,aceleracion,verificacion\n");
+
+    for (int t = 0; t < num_tamanos; t++) {
+        // Relacion 4:3: ancho * alto = megapixeles * 10^6
+        double pixeles = tamanos[t] * 1e6;
+        params.ancho = (int)llround(sqrt(pixeles * 4.0 / 3.0));
+        params.alto = (int)llround(pixeles / params.ancho);
+        int sin_memoria = 0;
+
+        for (int v = 0; v < num_variantes && !sin_memoria; v++) {
+            params.variante = variantes[v];
+            double base = 0;
+
+            for (int h = 0; h < num_listas_hilos && !sin_memoria; h++) {
+                num_hilos = (hilos[h] > params.alto) ? params.alto : hilos[h];
+                fprintf(stderr, "%d MP, %s, %d hilos...\n", tamanos[t], nombres_variante[params.variante], num_hilos);
+
+                double mejor = 0, s;
+                uint64_t verificacion = 0;
+                for (int k = 0; k < repeticiones && !sin_memoria; k++) {
+                    if (ejecutar_corrida(&s, &verificacion) != 0) {
+                        fprintf(stderr, "Sin memoria para %d megapixeles, se omite\n", tamanos[t]);
+                        sin_memoria = 1;
+                    } else if (k == 0 || s < mejor) {
+                        mejor = s;
+                    }
+                }
+                if (sin_memoria) break;
+                if (h == 0) base = mejor;
+
+                double mp_s = (double)params.ancho * params.alto * iteraciones / mejor / 1e6;
+                double bpp = bytes_por_pixel(&params);
+                printf("%d,%d,%d,%s,%s,%d,%d,%d,%.6f,%.2f,%.1f,%.2f,%.3f,%016llx\n",
+                       tamanos[t], params.ancho, params.alto, nombres_precision[params.precision],
+                       nombres_variante[params.variante], params.radio, num_hilos, iteraciones,
+                       mejor, mp_s, bpp, mp_s * 1e6 * bpp / 1e9, base / mejor,
+                       (unsigned long long)verificacion);
+                fflush(stdout);
+            }
+        }
+    }
+
+    return 0;
+}
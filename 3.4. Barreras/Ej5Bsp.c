@@ -0,0 +1,262 @@
+/**
+ * @file Ej5Bsp.c
+ * @brief Ejemplo del ejecutor BSP de bsp.h: superpasos separados por barreras, con
+ *        reduccion en la barrera y terminacion anticipada.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Generaliza Ej1Barreras.c. Alli cada hilo trabaja un tiempo aleatorio y todos se
+ * encuentran una sola vez en la barrera. Aqui eso se repite superpaso tras superpaso:
+ *      1. Cada hilo "trabaja" un tiempo aleatorio y produce un valor aleatorio, que deja
+ *         en su ranura (una linea de cache por hilo, ../Comun/ranura.h).
+ *      2. Barrera. El hilo que recibe PTHREAD_BARRIER_SERIAL_THREAD suma los valores de
+ *         todos (reduccion) y reporta el total acumulado y cuanto espero cada hilo.
+ *      3. Si el total alcanzo el objetivo, la reduccion devuelve BSP_TERMINAR y todos
+ *         los hilos terminan; si no, empieza otro superpaso.
+ *
+ * Con -t T cada superpaso se divide en T trozos. La duracion de cada trozo depende solo
+ * del superpaso y del numero de trozo, y en cada superpaso los trozos de un hilo elegido
+ * al azar tardan 4 veces mas: ese hilo es el rezagado que todos esperan en la barrera.
+ * El programa ejecuta la simulacion dos veces, con reparto estatico y con robo de
+ * trabajo (bsp.h), y compara cuanto tiempo pasaron los hilos ociosos en la barrera.
+ *
+ * Compilación:
+ *      gcc -O2 -o Ej5Bsp Ej5Bsp.c -lpthread
+ *
+ * Ejecución:
+ *      ./Ej5Bsp -n 4 -s 10 -o 200 -d 100
+ *      ./Ej5Bsp -n 4 -s 10 -o 100000 -t 64 -d 20
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "bsp.h"
+#include "../Comun/ranura.h"
+#include "../Comun/opciones.h"
+#include "../Comun/medicion.h"
+
+#define NUM_HILOS 4         // Número de hilos por defecto
+#define MAX_HILOS 256
+#define FACTOR_REZAGADO 4   // Cuántas veces más tardan los trozos del hilo rezagado
+
+/**
+ * @struct EstadoHilo
+ * @brief Lo que deja cada hilo al final de su superpaso.
+ */
+typedef struct {
+    int valor;                  // Valor producido en el superpaso
+    double fin_trabajo;         // Momento en que llego a la barrera
+    unsigned int semilla;       // Semilla propia para rand_r
+} EstadoHilo;
+
+DEFINIR_RANURA(RanuraHilo, EstadoHilo);
+
+/**
+ * @struct Simulacion
+ * @brief Contexto del programa BSP.
+ */
+typedef struct {
+    int num_hilos;
+    int duracion_max_ms;        // Cada superpaso dura entre 0 y esto por hilo
+    long objetivo;              // Se termina cuando el total llega a este valor
+    long total;                 // Lo actualiza la reduccion
+    long num_trozos;            // Trozos por superpaso (0: un superpaso por hilo)
+    int silencioso;             // 1 para no imprimir cada superpaso
+    double inicio_superpaso;    // Momento en que empezo el superpaso actual
+    RanuraHilo *hilos;          // Resultado de cada hilo en el superpaso
+} Simulacion;
+
+/**
+ * @brief Superpaso de cada hilo: trabajo simulado de duracion variable.
+ */
+int trabajo(int id, int superpaso, void *contexto) {
+    Simulacion *sim = contexto;
+    (void)superpaso;
+    EstadoHilo *mio = &sim->hilos[id].valor;
+
+    int ms = (sim->duracion_max_ms > 0) ? rand_r(&mio->semilla) % (sim->duracion_max_ms + 1) : 0;
+    usleep(ms * 1000);
+    mio->valor = rand_r(&mio->semilla) % 10;
+    mio->fin_trabajo = ahora();
+    return BSP_CONTINUAR;
+}
+
+/**
+ * @brief Mezcla dos enteros en 64 bits pseudoaleatorios (paso final de splitmix64).
+ *
+ * Así la duración y el valor de un trozo no dependen del hilo que lo ejecute, y las
+ * dos corridas de la comparación hacen exactamente el mismo trabajo.
+ */
+uint64_t mezclar(uint64_t a, uint64_t b) {
+    uint64_t z = a * 0x9E3779B97F4A7C15ULL + b + 0x632BE59BD9B4E019ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Trozo k del superpaso: trabajo simulado cuya duración depende de (superpaso, k).
+ */
+int trabajo_trozo(int id, int superpaso, long k, void *contexto) {
+    Simulacion *sim = contexto;
+    uint64_t h = mezclar((uint64_t)superpaso, (uint64_t)k);
+    long ms = (sim->duracion_max_ms > 0) ? (long)(h % (sim->duracion_max_ms + 1)) : 0;
+
+    // El dueño original de los trozos del rezagado no cambia aunque otro hilo los robe
+    int rezagado = (int)(mezclar((uint64_t)superpaso, ~0ULL) % sim->num_hilos);
+    long inicio, fin;
+    bsp_rango_trozos(sim->num_trozos, sim->num_hilos, rezagado, &inicio, &fin);
+    if (k >= inicio && k < fin) ms *= FACTOR_REZAGADO;
+
+    usleep(ms * 1000);
+    EstadoHilo *mio = &sim->hilos[id].valor;
+    mio->valor += (int)((h >> 32) % 10);
+    mio->fin_trabajo = ahora();
+    return BSP_CONTINUAR;
+}
+
+/**
+ * @brief Reduccion en la barrera: suma los valores y decide si se termina.
+ */
+int reducir(int superpaso, void *contexto) {
+    Simulacion *sim = contexto;
+    double fin = ahora(), mas_lento = sim->inicio_superpaso;
+    int suma = 0;
+
+    for (int i = 0; i < sim->num_hilos; i++) {
+        EstadoHilo *h = &sim->hilos[i].valor;
+        suma += h->valor;
+        if (h->fin_trabajo > mas_lento) mas_lento = h->fin_trabajo;
+    }
+    sim->total += suma;
+
+    // Tiempo ocioso: lo que cada hilo espero en la barrera al más lento
+    double ocioso = 0;
+    for (int i = 0; i < sim->num_hilos; i++) {
+        ocioso += mas_lento - sim->hilos[i].valor.fin_trabajo;
+        sim->hilos[i].valor.valor = 0;     // Los trozos suman sobre el valor del hilo
+    }
+    if (!sim->silencioso) {
+        printf("Superpaso %d: suma %d, total %ld, duración %.3f s, espera media en la barrera %.3f s\n",
+               superpaso, suma, sim->total, fin - sim->inicio_superpaso, ocioso / sim->num_hilos);
+    }
+
+    sim->inicio_superpaso = ahora();
+    return (sim->total >= sim->objetivo) ? BSP_TERMINAR : BSP_CONTINUAR;
+}
+
+/**
+ * @brief Ejecuta la simulación por trozos con o sin robo y reporta el tiempo ocioso.
+ * @return double Segundos que los hilos pasaron en total esperando en la barrera, o -1
+ */
+double ejecutar_trozos(Simulacion *sim, int max_superpasos, int robar) {
+    EstadisticasBsp *est = calloc(sim->num_hilos, sizeof(EstadisticasBsp));
+    if (!est) return -1;
+    for (int i = 0; i < sim->num_hilos; i++) {
+        sim->hilos[i].valor.valor = 0;
+    }
+    sim->total = 0;
+
+    ProgramaBsp programa = {
+        .num_hilos = sim->num_hilos,
+        .max_superpasos = max_superpasos,
+        .reducir = reducir,
+        .contexto = sim,
+        .trozo = trabajo_trozo,
+        .num_trozos = sim->num_trozos,
+        .robar = robar,
+        .estadisticas = est,
+    };
+    double inicio = ahora();
+    sim->inicio_superpaso = inicio;
+    int superpasos = bsp_ejecutar(&programa);
+    double segundos = ahora() - inicio;
+    if (superpasos < 0) {
+        free(est);
+        return -1;
+    }
+
+    double espera = 0, trabajo = 0;
+    long robados = 0;
+    for (int i = 0; i < sim->num_hilos; i++) {
+        espera += est[i].espera;
+        trabajo += est[i].trabajo;
+        robados += est[i].robados;
+    }
+    printf("%s %3d superpasos, total %ld, %.3f s, espera en la barrera %.3f s (%.1f%% del tiempo de los hilos), %ld trozos robados\n",
+           robar ? "robo:    " : "estático:", superpasos, sim->total, segundos, espera,
+           100.0 * espera / (espera + trabajo), robados);
+    free(est);
+    return espera;
+}
+
+int main(int argc, char *argv[]) {
+    long num_hilos = NUM_HILOS, max_superpasos = 10, objetivo = 100, duracion = 100, trozos = 0;
+    int opcion;
+
+    while ((opcion = getopt(argc, argv, "n:s:o:d:t:")) != -1) {
+        int valido = 0;
+        switch (opcion) {
+            case 'n': valido = leer_entero(optarg, 1, MAX_HILOS, &num_hilos) == 0; break;
+            case 's': valido = leer_entero(optarg, 0, 1000000, &max_superpasos) == 0; break;
+            case 'o': valido = leer_entero(optarg, 1, 1L << 40, &objetivo) == 0; break;
+            case 'd': valido = leer_entero(optarg, 0, 10000, &duracion) == 0; break;
+            case 't': valido = leer_entero(optarg, 0, 1L << 30, &trozos) == 0; break;
+        }
+        if (!valido) {
+            fprintf(stderr, "Uso: %s [-n hilos] [-s max_superpasos (0 = sin límite)] [-o objetivo] "
+                            "[-d duración_max_ms] [-t trozos]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Simulacion sim = { (int)num_hilos, (int)duracion, objetivo, 0, trozos, trozos > 0, 0, NULL };
+    sim.hilos = ranuras_reservar(num_hilos, sizeof(RanuraHilo));
+    if (!sim.hilos) {
+        fprintf(stderr, "Error al asignar memoria para los hilos.\n");
+        return 1;
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        sim.hilos[i].valor.semilla = (unsigned int)time(NULL) ^ (unsigned int)(i * 2654435761u);
+    }
+
+    if (trozos > 0) {
+        // Mismo trabajo dos veces: reparto estático y con robo de trozos
+        printf("%ld hilos, %ld trozos por superpaso, un rezagado %dx más lento por superpaso\n",
+               num_hilos, trozos, FACTOR_REZAGADO);
+        double estatico = ejecutar_trozos(&sim, (int)max_superpasos, 0);
+        double robo = ejecutar_trozos(&sim, (int)max_superpasos, 1);
+        free(sim.hilos);
+        if (estatico < 0 || robo < 0) {
+            fprintf(stderr, "Error al asignar memoria para el ejecutor BSP.\n");
+            return 1;
+        }
+        if (estatico > 0) {
+            printf("Tiempo ocioso en la barrera recuperado con robo: %.1f%%\n", 100.0 * (1 - robo / estatico));
+        }
+        return 0;
+    }
+
+    ProgramaBsp programa = {
+        .num_hilos = (int)num_hilos,
+        .max_superpasos = (int)max_superpasos,
+        .superpaso = trabajo,
+        .reducir = reducir,
+        .contexto = &sim,
+    };
+    sim.inicio_superpaso = ahora();
+    int superpasos = bsp_ejecutar(&programa);
+    if (superpasos < 0) {
+        fprintf(stderr, "Error al asignar memoria para el ejecutor BSP.\n");
+        return 1;
+    }
+
+    printf("%d superpasos, total %ld (objetivo %ld)%s\n", superpasos, sim.total, objetivo,
+           sim.total >= objetivo ? ": terminación anticipada" : "");
+    free(sim.hilos);
+    return 0;
+}
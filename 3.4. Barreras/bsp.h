@@ -0,0 +1,285 @@
+/**
+ * @file bsp.h
+ * @brief Ejecutor de programas BSP (bulk synchronous parallel) con hilos POSIX y barreras.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Un programa BSP es una sucesion de superpasos. En cada superpaso todos los hilos
+ * ejecutan la misma funcion sobre su parte de los datos y al final esperan en una barrera;
+ * nadie empieza el superpaso s + 1 hasta que todos terminaron el s.
+ *
+ * Quien use el ejecutor solo escribe la funcion del superpaso:
+ *
+ *      int mi_superpaso(int id, int superpaso, void *contexto);
+ *
+ * y la registra en un ProgramaBsp. bsp_ejecutar crea los hilos, hace el ciclo de
+ * superpasos, maneja la barrera y espera a que todos terminen. El ProgramaBsp se llena
+ * con inicializadores designados (.num_hilos = ..., .superpaso = ...): los campos que
+ * no se nombran quedan en cero y agregar campos no recorre los valores de nadie.
+ *
+ * Reduccion opcional: si el programa tiene una funcion reducir, despues de la barrera
+ * la ejecuta un solo hilo, el que recibe PTHREAD_BARRIER_SERIAL_THREAD de
+ * pthread_barrier_wait. Puede combinar los resultados parciales del superpaso (por
+ * ejemplo, sumar lo que dejo cada hilo en su ranura). Una segunda barrera hace que los
+ * demas hilos vean su resultado antes de continuar.
+ *
+ * Terminacion anticipada: si algun hilo devuelve BSP_TERMINAR desde su superpaso, o
+ * reducir devuelve BSP_TERMINAR, todos los hilos salen despues de esa barrera.
+ * Los votos se guardan en 3 casillas rotativas; asi basta una barrera por superpaso
+ * cuando no hay reduccion (la casilla del superpaso s + 2 se limpia despues de la
+ * barrera s, cuando ya nadie la lee y nadie la puede escribir todavia).
+ *
+ * Superpasos por trozos y robo de trabajo: en lugar de superpaso, el programa puede
+ * registrar una funcion trozo y un numero de trozos por superpaso. Cada hilo empieza
+ * con un rango contiguo de trozos y los toma uno por uno con un contador atomico propio.
+ * Con robar = 1, el hilo que termina su rango no se queda esperando en la barrera:
+ * recorre los contadores de los demas hilos y toma los trozos que les quedan. Asi el
+ * tiempo del superpaso ya no lo fija el hilo mas lento (el rezagado) sino el trabajo
+ * total repartido entre todos. Los contadores son dos juegos, uno para los superpasos
+ * pares y otro para los impares: cada hilo prepara su contador del superpaso s + 1
+ * durante el superpaso s, cuando nadie lo usa.
+ *
+ * Si el programa tiene un arreglo de EstadisticasBsp, cada hilo acumula ahi cuanto
+ * tiempo trabajo, cuanto espero en la barrera y cuantos trozos hizo y robo.
+ */
+
+#ifndef BSP_H
+#define BSP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "../Comun/ranura.h"
+#include "../Comun/medicion.h"
+
+#define BSP_CONTINUAR 0     ///< El hilo (o la reduccion) quiere otro superpaso
+#define BSP_TERMINAR 1      ///< Terminar despues de la barrera de este superpaso
+
+/**
+ * @brief Funcion de un superpaso.
+ * @param id Indice del hilo, 0..num_hilos-1
+ * @param superpaso Numero de superpaso, empezando en 0
+ * @param contexto Datos del programa
+ * @return BSP_CONTINUAR o BSP_TERMINAR
+ */
+typedef int (*SuperpasoBsp)(int id, int superpaso, void *contexto);
+
+/**
+ * @brief Reduccion que ejecuta un solo hilo despues de la barrera de cada superpaso.
+ * @return BSP_CONTINUAR o BSP_TERMINAR
+ */
+typedef int (*ReduccionBsp)(int superpaso, void *contexto);
+
+/**
+ * @brief Procesa el trozo numero trozo (0..num_trozos-1) de un superpaso.
+ * @param id Hilo que lo ejecuta (puede no ser el dueño si lo robo)
+ * @return BSP_CONTINUAR o BSP_TERMINAR
+ */
+typedef int (*TrozoBsp)(int id, int superpaso, long trozo, void *contexto);
+
+/**
+ * @struct EstadisticasBsp
+ * @brief Lo que acumula cada hilo a lo largo de una ejecucion.
+ */
+typedef struct {
+    double trabajo;             ///< Segundos en superpasos (incluye buscar trozos para robar)
+    double espera;              ///< Segundos bloqueado en la barrera
+    long trozos;                ///< Trozos ejecutados, propios y robados
+    long robados;               ///< Trozos tomados del rango de otro hilo
+} EstadisticasBsp;
+
+/**
+ * @struct ProgramaBsp
+ * @brief Describe un programa BSP.
+ */
+typedef struct {
+    int num_hilos;              ///< Hilos que ejecutan cada superpaso
+    int max_superpasos;         ///< Limite de superpasos (<= 0: hasta que alguien termine)
+    SuperpasoBsp superpaso;     ///< Trabajo de cada hilo en cada superpaso
+    ReduccionBsp reducir;       ///< Reduccion en la barrera, o NULL
+    void *contexto;             ///< Se pasa tal cual a superpaso, reducir y trozo
+    TrozoBsp trozo;             ///< Si no es NULL, cada superpaso son num_trozos llamadas a trozo
+    long num_trozos;            ///< Trozos por superpaso
+    int robar;                  ///< 1 para robar trozos de los demas antes de la barrera
+    EstadisticasBsp *estadisticas; ///< num_hilos estadisticas, o NULL
+} ProgramaBsp;
+
+DEFINIR_RANURA(ContadorBsp, atomic_long);
+
+/**
+ * @struct EstadoBsp
+ * @brief Estado compartido por los hilos de una ejecucion.
+ */
+typedef struct {
+    const ProgramaBsp *programa;
+    pthread_barrier_t barrera;
+    atomic_int votos[3];        ///< votos[s % 3] != 0 si alguien pidio terminar en el superpaso s
+    int superpasos;             ///< Superpasos completados (lo escribe el hilo serial)
+    ContadorBsp *siguiente[2];  ///< Siguiente trozo de cada hilo, para superpasos pares e impares
+} EstadoBsp;
+
+/**
+ * @struct HiloBsp
+ * @brief Argumento de cada hilo.
+ */
+typedef struct {
+    EstadoBsp *estado;
+    int id;
+} HiloBsp;
+
+/**
+ * @brief Rango inicial de trozos [inicio, fin) del hilo id.
+ */
+static inline void bsp_rango_trozos(long num_trozos, int num_hilos, int id, long *inicio, long *fin) {
+    long base = num_trozos / num_hilos, resto = num_trozos % num_hilos;
+    *inicio = base * id + (id < resto ? id : resto);
+    *fin = *inicio + base + (id < resto ? 1 : 0);
+}
+
+/**
+ * @brief Ejecuta los trozos del rango del hilo victima que sigan libres.
+ * @return BSP_TERMINAR si algun trozo lo pidio
+ */
+static inline int bsp_vaciar_rango(EstadoBsp *e, int id, int victima, int s, EstadisticasBsp *est) {
+    const ProgramaBsp *p = e->programa;
+    long inicio, fin, k;
+    int voto = BSP_CONTINUAR;
+    bsp_rango_trozos(p->num_trozos, p->num_hilos, victima, &inicio, &fin);
+
+    atomic_long *siguiente = &e->siguiente[s % 2][victima].valor;
+    while ((k = atomic_fetch_add_explicit(siguiente, 1, memory_order_relaxed)) < fin) {
+        voto |= p->trozo(id, s, k, p->contexto);
+        est->trozos++;
+        if (victima != id) est->robados++;
+    }
+    return voto;
+}
+
+/**
+ * @brief Superpaso por trozos: primero los propios y, con robo, despues los de los demas.
+ */
+static inline int bsp_superpaso_trozos(EstadoBsp *e, int id, int s, EstadisticasBsp *est) {
+    const ProgramaBsp *p = e->programa;
+    long inicio, fin;
+
+    // Nadie usa el contador del siguiente superpaso hasta que pase la barrera de este
+    bsp_rango_trozos(p->num_trozos, p->num_hilos, id, &inicio, &fin);
+    atomic_store_explicit(&e->siguiente[(s + 1) % 2][id].valor, inicio, memory_order_relaxed);
+
+    int voto = bsp_vaciar_rango(e, id, id, s, est);
+    if (p->robar) {
+        for (int d = 1; d < p->num_hilos; d++) {
+            voto |= bsp_vaciar_rango(e, id, (id + d) % p->num_hilos, s, est);
+        }
+    }
+    return voto;
+}
+
+/**
+ * @brief Espera en la barrera y suma el tiempo bloqueado a las estadisticas.
+ * @return int 1 si este hilo recibio PTHREAD_BARRIER_SERIAL_THREAD
+ */
+static inline int bsp_esperar(EstadoBsp *e, EstadisticasBsp *est) {
+    double t = e->programa->estadisticas ? ahora() : 0;
+    int serial = (pthread_barrier_wait(&e->barrera) == PTHREAD_BARRIER_SERIAL_THREAD);
+    if (e->programa->estadisticas) est->espera += ahora() - t;
+    return serial;
+}
+
+static inline void *bsp_hilo(void *arg) {
+    HiloBsp *h = arg;
+    EstadoBsp *e = h->estado;
+    const ProgramaBsp *p = e->programa;
+    EstadisticasBsp est = { 0, 0, 0, 0 };   // Local para no compartir lineas de cache
+
+    for (int s = 0; p->max_superpasos <= 0 || s < p->max_superpasos; s++) {
+        double t = p->estadisticas ? ahora() : 0;
+        int voto = p->trozo ? bsp_superpaso_trozos(e, h->id, s, &est)
+                            : p->superpaso(h->id, s, p->contexto);
+        if (p->estadisticas) est.trabajo += ahora() - t;
+        if (voto != BSP_CONTINUAR) {
+            atomic_store_explicit(&e->votos[s % 3], 1, memory_order_relaxed);
+        }
+
+        // Sincronización: fin del superpaso
+        int serial = bsp_esperar(e, &est);
+
+        if (p->reducir) {
+            if (serial && p->reducir(s, p->contexto) != BSP_CONTINUAR) {
+                atomic_store_explicit(&e->votos[s % 3], 1, memory_order_relaxed);
+            }
+            // Los demas esperan el resultado de la reduccion
+            bsp_esperar(e, &est);
+        }
+        if (serial) {
+            e->superpasos = s + 1;
+            atomic_store_explicit(&e->votos[(s + 2) % 3], 0, memory_order_relaxed);
+        }
+        if (atomic_load_explicit(&e->votos[s % 3], memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (p->estadisticas) {
+        p->estadisticas[h->id] = est;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Ejecuta el programa BSP y espera a que terminen todos sus hilos.
+ *
+ * @param programa Programa a ejecutar
+ * @return int Numero de superpasos completados, o -1 si no se pudo reservar memoria
+ */
+static inline int bsp_ejecutar(const ProgramaBsp *programa) {
+    int n = programa->num_hilos;
+    EstadoBsp e;
+    e.programa = programa;
+    e.superpasos = 0;
+    for (int i = 0; i < 3; i++) {
+        atomic_init(&e.votos[i], 0);
+    }
+
+    pthread_t *hilos = malloc(sizeof(pthread_t) * n);
+    HiloBsp *args = malloc(sizeof(HiloBsp) * n);
+    e.siguiente[0] = ranuras_reservar(n, sizeof(ContadorBsp));
+    e.siguiente[1] = ranuras_reservar(n, sizeof(ContadorBsp));
+    if (!hilos || !args || !e.siguiente[0] || !e.siguiente[1]) {
+        free(hilos);
+        free(args);
+        free(e.siguiente[0]);
+        free(e.siguiente[1]);
+        return -1;
+    }
+    // Contadores del superpaso 0; los del 1 los prepara cada hilo durante el 0
+    for (int i = 0; i < n; i++) {
+        long inicio, fin;
+        bsp_rango_trozos(programa->num_trozos, n, i, &inicio, &fin);
+        atomic_init(&e.siguiente[0][i].valor, inicio);
+        atomic_init(&e.siguiente[1][i].valor, inicio);
+    }
+
+    pthread_barrier_init(&e.barrera, NULL, n);
+    for (int i = 0; i < n; i++) {
+        args[i].estado = &e;
+        args[i].id = i;
+        if (pthread_create(&hilos[i], NULL, bsp_hilo, &args[i]) != 0) {
+            // Sin todos los hilos la barrera nunca se completaria
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    pthread_barrier_destroy(&e.barrera);
+
+    free(hilos);
+    free(args);
+    free(e.siguiente[0]);
+    free(e.siguiente[1]);
+    return e.superpasos;
+}
+
+#endif // BSP_H
@@ -0,0 +1,351 @@
+/**
+ * @file filtro.h
+ * @brief Nucleos del filtro promedio (caja) para imagenes de 8 bits, 16 bits y flotantes.
+ * @author Salvador Gonzalez Arellano
+ *
+ * En C no hay plantillas, asi que los nucleos se escriben una sola vez dentro de la
+ * macro DEFINIR_FILTRO y se instancian para cada tipo de muestra:
+ *      - FILTRO_U8  : unsigned char (stbi_load), suma en int32_t
+ *      - FILTRO_U16 : unsigned short (stbi_load_16), suma en int32_t
+ *      - FILTRO_F32 : float (stbi_loadf), suma en float
+ *
+ * Para los tipos enteros el promedio se redondea al entero mas cercano en lugar de
+ * truncar (suma / conteo), asi las iteraciones repetidas no van oscureciendo la imagen.
+ *
+ * Variantes de recorrido:
+ *      - FILTRO_ESCALAR   : un pixel a la vez, suma toda su vecindad.
+ *      - FILTRO_BLOQUES   : igual que el escalar, pero recorre la franja en bloques
+ *                           (tiles) de tam_bloque x tam_bloque.
+ *      - FILTRO_VECTORIAL : primero suma las filas de la vecindad en un renglon temporal
+ *                           y despues suma horizontalmente. Ambos lazos recorren memoria
+ *                           contigua sin dependencias, por lo que el compilador los
+ *                           convierte en instrucciones SIMD (SSE, AVX2 o AVX-512 segun
+ *                           -march) para cada tipo de muestra.
+ *      - FILTRO_SEPARABLE : el promedio de caja es separable: se suma cada fila de la
+ *                           entrada horizontalmente una sola vez y se guarda en un anillo
+ *                           de 2r+1 renglones; la suma vertical se mantiene corrida,
+ *                           sumando el renglon que entra y restando el que sale. El costo
+ *                           por pixel pasa de O(r^2) a O(r) + O(1). En float la suma
+ *                           vertical se lleva en double (ver DEFINIR_FILTRO_SEPARABLE).
+ *
+ * Para obtener las versiones SIMD se recomienda compilar con: -O3 -march=native
+ */
+
+#ifndef FILTRO_H
+#define FILTRO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Tipo de muestra con el que se almacena cada canal de la imagen.
+ */
+typedef enum {
+    FILTRO_U8,      ///< 8 bits por canal (0-255)
+    FILTRO_U16,     ///< 16 bits por canal (0-65535)
+    FILTRO_F32      ///< float por canal, lineal (HDR)
+} Precision;
+
+/**
+ * @brief Forma en que se recorre la imagen para aplicar el filtro.
+ */
+typedef enum {
+    FILTRO_ESCALAR,
+    FILTRO_BLOQUES,
+    FILTRO_VECTORIAL,
+    FILTRO_SEPARABLE
+} Variante;
+
+/**
+ * @struct ParamsFiltro
+ * @brief Descripcion de la imagen y del filtro que comparten todos los hilos.
+ */
+typedef struct {
+    int ancho;              ///< Pixeles por fila
+    int alto;               ///< Numero de filas
+    int canales;            ///< Muestras por pixel
+    int radio;              ///< La vecindad es de (2*radio+1)x(2*radio+1)
+    int tam_bloque;         ///< Lado del bloque para FILTRO_BLOQUES
+    Precision precision;    ///< Tipo de cada muestra
+    Variante variante;      ///< Recorrido a utilizar
+} ParamsFiltro;
+
+/**
+ * @brief Bytes que ocupa una muestra de la precision indicada.
+ */
+static inline size_t tam_muestra(Precision precision) {
+    switch (precision) {
+        case FILTRO_U16: return sizeof(uint16_t);
+        case FILTRO_F32: return sizeof(float);
+        default:         return sizeof(uint8_t);
+    }
+}
+
+/**
+ * @brief Bytes de memoria temporal que necesita cada hilo para la variante elegida.
+ *
+ * La variante vectorial usa dos renglones de sumas (vertical y horizontal); la
+ * separable usa el acumulador vertical (en double para float) mas el anillo de 2r+1
+ * sumas horizontales.
+ */
+static inline size_t filtro_tam_temporal(const ParamsFiltro *p) {
+    size_t renglon = (size_t)p->ancho * p->canales;
+    size_t tam_suma = (p->precision == FILTRO_F32) ? sizeof(float) : sizeof(int32_t);
+    size_t tam_vertical = (p->precision == FILTRO_F32) ? sizeof(double) : sizeof(int32_t);
+
+    switch (p->variante) {
+        case FILTRO_VECTORIAL: return 2 * renglon * tam_suma;
+        case FILTRO_SEPARABLE: return renglon * tam_vertical + (size_t)(2 * p->radio + 1) * renglon * tam_suma;
+        default:               return 0;
+    }
+}
+
+/** Redondeo al entero mas cercano para los tipos enteros. */
+#define FILTRO_PROMEDIO_ENTERO(T, suma, conteo) ((T)(((suma) + (conteo) / 2) / (conteo)))
+/** Division en punto flotante, equivalente al redondeo anterior pero vectorizable. */
+#define FILTRO_PROMEDIO_VECT_ENTERO(T, suma, conteo) ((T)((double)(suma) / (conteo) + 0.5))
+/** Para flotantes no hay redondeo que hacer. */
+#define FILTRO_PROMEDIO_FLOTANTE(T, suma, conteo) ((T)((suma) / (float)(conteo)))
+
+/**
+ * @brief Genera los nucleos escalar/bloques y vectorial para un tipo de muestra.
+ *
+ * @param SUF Sufijo de los nombres de las funciones generadas
+ * @param T Tipo de la muestra
+ * @param TS Tipo del acumulador
+ * @param PROM Macro de promedio para el nucleo escalar
+ * @param PROM_V Macro de promedio para el nucleo vectorial
+ */
+#define DEFINIR_FILTRO(SUF, T, TS, PROM, PROM_V)                                               \
+                                                                                               \
+/* Promedio de la vecindad del pixel (i, j) en el canal c */                                   \
+static inline T filtro_pixel_##SUF(const ParamsFiltro *p, const T *origen, int i, int j, int c) { \
+    int r = p->radio;                                                                          \
+    int fila_ini = (i - r < 0) ? 0 : i - r;                                                    \
+    int fila_fin = (i + r >= p->alto) ? p->alto - 1 : i + r;                                   \
+    int col_ini = (j - r < 0) ? 0 : j - r;                                                     \
+    int col_fin = (j + r >= p->ancho) ? p->ancho - 1 : j + r;                                  \
+    TS suma = 0;                                                                               \
+    int conteo = (fila_fin - fila_ini + 1) * (col_fin - col_ini + 1);                          \
+    for (int ni = fila_ini; ni <= fila_fin; ni++) {                                            \
+        const T *fila = origen + (size_t)ni * p->ancho * p->canales;                           \
+        for (int nj = col_ini; nj <= col_fin; nj++) {                                          \
+            suma += fila[nj * p->canales + c];                                                 \
+        }                                                                                      \
+    }                                                                                          \
+    return PROM(T, suma, conteo);                                                              \
+}                                                                                              \
+                                                                                               \
+/* Recorre las filas [fila_ini, fila_fin) en bloques de bloque x bloque (0 = filas completas) */ \
+static void filtro_escalar_##SUF(const ParamsFiltro *p, const T *origen, T *destino,           \
+                                 int fila_ini, int fila_fin, int bloque) {                     \
+    int bloque_filas = (bloque > 0) ? bloque : (fila_fin - fila_ini);                          \
+    int bloque_cols = (bloque > 0) ? bloque : p->ancho;                                        \
+    if (bloque_filas <= 0) return;                                                             \
+    for (int bi = fila_ini; bi < fila_fin; bi += bloque_filas) {                               \
+        int bi_fin = (bi + bloque_filas < fila_fin) ? bi + bloque_filas : fila_fin;            \
+        for (int bj = 0; bj < p->ancho; bj += bloque_cols) {                                   \
+            int bj_fin = (bj + bloque_cols < p->ancho) ? bj + bloque_cols : p->ancho;          \
+            for (int i = bi; i < bi_fin; i++) {                                                \
+                for (int j = bj; j < bj_fin; j++) {                                            \
+                    for (int c = 0; c < p->canales; c++) {                                     \
+                        size_t indice = ((size_t)i * p->ancho + j) * p->canales + c;           \
+                        destino[indice] = filtro_pixel_##SUF(p, origen, i, j, c);              \
+                    }                                                                          \
+                }                                                                              \
+            }                                                                                  \
+        }                                                                                      \
+    }                                                                                          \
+}                                                                                              \
+                                                                                               \
+/* Suma vertical en un renglon y luego horizontal; ambos lazos son vectorizables */            \
+static void filtro_vectorial_##SUF(const ParamsFiltro *p, const T *restrict origen,            \
+                                   T *restrict destino, int fila_ini, int fila_fin,            \
+                                   TS *restrict vertical, TS *restrict horizontal) {           \
+    const int r = p->radio, c = p->canales;                                                    \
+    const int n = p->ancho * c;                 /* muestras por renglon */                     \
+    const int izq = (r < p->ancho) ? r : p->ancho;                                             \
+    const int der = (p->ancho - r > izq) ? p->ancho - r : izq;  /* columnas interiores */      \
+    for (int i = fila_ini; i < fila_fin; i++) {                                                \
+        int ri = (i - r < 0) ? 0 : i - r;                                                      \
+        int rf = (i + r >= p->alto) ? p->alto - 1 : i + r;                                     \
+        int filas = rf - ri + 1;                                                               \
+        /* 1. Suma vertical de las filas de la vecindad */                                     \
+        const T *fila = origen + (size_t)ri * n;                                               \
+        for (int k = 0; k < n; k++) vertical[k] = fila[k];                                     \
+        for (int ni = ri + 1; ni <= rf; ni++) {                                                \
+            fila = origen + (size_t)ni * n;                                                    \
+            _Pragma("GCC ivdep")                                                               \
+            for (int k = 0; k < n; k++) vertical[k] += fila[k];                                \
+        }                                                                                      \
+        /* 2. Suma horizontal de las columnas interiores, desplazando por canales */           \
+        for (int k = izq * c; k < der * c; k++) horizontal[k] = vertical[k - r * c];           \
+        for (int d = -r + 1; d <= r; d++) {                                                    \
+            const TS *desplazado = vertical + d * c;                                           \
+            _Pragma("GCC ivdep")                                                               \
+            for (int k = izq * c; k < der * c; k++) horizontal[k] += desplazado[k];            \
+        }                                                                                      \
+        /* 3. Promedio: en el interior el conteo es constante */                               \
+        T *salida = destino + (size_t)i * n;                                                   \
+        const int conteo = filas * (2 * r + 1);                                                \
+        _Pragma("GCC ivdep")                                                                   \
+        for (int k = izq * c; k < der * c; k++) salida[k] = PROM_V(T, horizontal[k], conteo);  \
+        /* 4. Bordes izquierdo y derecho: conteo variable, se calculan aparte */               \
+        for (int j = 0; j < p->ancho; j++) {                                                   \
+            if (j == izq) {                                                                    \
+                j = der;                                                                       \
+                if (j >= p->ancho) break;                                                      \
+            }                                                                                  \
+            int ci = (j - r < 0) ? 0 : j - r;                                                  \
+            int cf = (j + r >= p->ancho) ? p->ancho - 1 : j + r;                               \
+            for (int canal = 0; canal < c; canal++) {                                          \
+                TS suma = 0;                                                                   \
+                for (int nj = ci; nj <= cf; nj++) suma += vertical[nj * c + canal];            \
+                salida[j * c + canal] = PROM(T, suma, filas * (cf - ci + 1));                  \
+            }                                                                                  \
+        }                                                                                      \
+    }                                                                                          \
+}
+
+/**
+ * @brief Genera el nucleo separable para un tipo de muestra.
+ *
+ * Mismos parametros que DEFINIR_FILTRO mas TV, el tipo del acumulador vertical. Para
+ * los tipos enteros la suma corrida es exacta y el resultado es identico al del nucleo
+ * escalar. En float no: cada fila que entra y sale deja su error de redondeo, que crece
+ * con la altura de la franja, y en imagenes HDR, al salir de la ventana una fila muy
+ * brillante, la resta cancela casi todos los bits de las filas tenues que quedan (con
+ * float se llega a errores mayores que el propio valor). Por eso f32 acumula en double:
+ * el error queda muy por debajo del redondeo final a float.
+ */
+#define DEFINIR_FILTRO_SEPARABLE(SUF, T, TS, TV, PROM, PROM_V)                                     \
+                                                                                               \
+/* Suma horizontal (sin dividir) de la fila de entrada en el renglon h */                     \
+static inline void filtro_suma_fila_##SUF(const ParamsFiltro *p, const T *restrict fila,      \
+                                          TS *restrict h, int izq, int der) {                  \
+    const int r = p->radio, c = p->canales;                                                    \
+    for (int k = izq * c; k < der * c; k++) h[k] = fila[k - r * c];                            \
+    for (int d = -r + 1; d <= r; d++) {                                                        \
+        const T *desplazado = fila + d * c;                                                    \
+        _Pragma("GCC ivdep")                                                                   \
+        for (int k = izq * c; k < der * c; k++) h[k] += desplazado[k];                         \
+    }                                                                                          \
+    for (int j = 0; j < p->ancho; j++) {                                                       \
+        if (j == izq) {                                                                        \
+            j = der;                                                                           \
+            if (j >= p->ancho) break;                                                          \
+        }                                                                                      \
+        int ci = (j - r < 0) ? 0 : j - r;                                                      \
+        int cf = (j + r >= p->ancho) ? p->ancho - 1 : j + r;                                   \
+        for (int canal = 0; canal < c; canal++) {                                              \
+            TS suma = 0;                                                                       \
+            for (int nj = ci; nj <= cf; nj++) suma += fila[nj * c + canal];                    \
+            h[j * c + canal] = suma;                                                           \
+        }                                                                                      \
+    }                                                                                          \
+}                                                                                              \
+                                                                                               \
+static void filtro_separable_##SUF(const ParamsFiltro *p, const T *restrict origen,            \
+                                   T *restrict destino, int fila_ini, int fila_fin,            \
+                                   TS *restrict anillo, TV *restrict vertical) {               \
+    const int r = p->radio, c = p->canales, ventana = 2 * r + 1;                               \
+    const int n = p->ancho * c;                                                                \
+    const int izq = (r < p->ancho) ? r : p->ancho;                                             \
+    const int der = (p->ancho - r > izq) ? p->ancho - r : izq;                                 \
+    if (fila_ini >= fila_fin) return;                                                          \
+    /* Ventana inicial: filas [fila_ini - r, fila_ini + r] que existan */                      \
+    for (int k = 0; k < n; k++) vertical[k] = 0;                                               \
+    int ri = (fila_ini - r < 0) ? 0 : fila_ini - r;                                            \
+    int rf = (fila_ini + r >= p->alto) ? p->alto - 1 : fila_ini + r;                           \
+    for (int ni = ri; ni <= rf; ni++) {                                                        \
+        TS *h = anillo + (size_t)(ni % ventana) * n;                                           \
+        filtro_suma_fila_##SUF(p, origen + (size_t)ni * n, h, izq, der);                       \
+        _Pragma("GCC ivdep")                                                                   \
+        for (int k = 0; k < n; k++) vertical[k] += h[k];                                       \
+    }                                                                                          \
+    for (int i = fila_ini; i < fila_fin; i++) {                                                \
+        if (i > fila_ini) {                                                                    \
+            /* Sale la fila i-r-1 y entra la fila i+r (comparten lugar en el anillo) */        \
+            int sale = i - r - 1, entra = i + r;                                               \
+            if (sale >= 0) {                                                                   \
+                const TS *h = anillo + (size_t)(sale % ventana) * n;                           \
+                _Pragma("GCC ivdep")                                                           \
+                for (int k = 0; k < n; k++) vertical[k] -= h[k];                               \
+            }                                                                                  \
+            if (entra < p->alto) {                                                             \
+                TS *h = anillo + (size_t)(entra % ventana) * n;                                \
+                filtro_suma_fila_##SUF(p, origen + (size_t)entra * n, h, izq, der);            \
+                _Pragma("GCC ivdep")                                                           \
+                for (int k = 0; k < n; k++) vertical[k] += h[k];                               \
+            }                                                                                  \
+        }                                                                                      \
+        int filas = ((i + r >= p->alto) ? p->alto - 1 : i + r) - ((i - r < 0) ? 0 : i - r) + 1; \
+        T *salida = destino + (size_t)i * n;                                                   \
+        const int conteo = filas * ventana;                                                    \
+        _Pragma("GCC ivdep")                                                                   \
+        for (int k = izq * c; k < der * c; k++) salida[k] = PROM_V(T, vertical[k], conteo);    \
+        for (int j = 0; j < p->ancho; j++) {                                                   \
+            if (j == izq) {                                                                    \
+                j = der;                                                                       \
+                if (j >= p->ancho) break;                                                      \
+            }                                                                                  \
+            int ci = (j - r < 0) ? 0 : j - r;                                                  \
+            int cf = (j + r >= p->ancho) ? p->ancho - 1 : j + r;                               \
+            for (int canal = 0; canal < c; canal++) {                                          \
+                salida[j * c + canal] = PROM(T, vertical[j * c + canal], filas * (cf - ci + 1)); \
+            }                                                                                  \
+        }                                                                                      \
+    }                                                                                          \
+}
+
+DEFINIR_FILTRO(u8, uint8_t, int32_t, FILTRO_PROMEDIO_ENTERO, FILTRO_PROMEDIO_VECT_ENTERO)
+DEFINIR_FILTRO(u16, uint16_t, int32_t, FILTRO_PROMEDIO_ENTERO, FILTRO_PROMEDIO_VECT_ENTERO)
+DEFINIR_FILTRO(f32, float, float, FILTRO_PROMEDIO_FLOTANTE, FILTRO_PROMEDIO_FLOTANTE)
+DEFINIR_FILTRO_SEPARABLE(u8, uint8_t, int32_t, int32_t, FILTRO_PROMEDIO_ENTERO, FILTRO_PROMEDIO_VECT_ENTERO)
+DEFINIR_FILTRO_SEPARABLE(u16, uint16_t, int32_t, int32_t, FILTRO_PROMEDIO_ENTERO, FILTRO_PROMEDIO_VECT_ENTERO)
+DEFINIR_FILTRO_SEPARABLE(f32, float, float, double, FILTRO_PROMEDIO_FLOTANTE, FILTRO_PROMEDIO_FLOTANTE)
+
+/**
+ * @brief Elige el nucleo de la variante pedida para un tipo de muestra.
+ */
+#define FILTRO_DESPACHAR(SUF, T, TS, TV)                                                           \
+    switch (p->variante) {                                                                     \
+        case FILTRO_VECTORIAL:                                                                 \
+            filtro_vectorial_##SUF(p, (const T *)origen, (T *)destino, fila_ini, fila_fin,     \
+                                   (TS *)temporal, (TS *)temporal + renglon);                  \
+            break;                                                                             \
+        case FILTRO_SEPARABLE:                                                                 \
+            /* El acumulador vertical va primero: asi el double queda alineado */              \
+            filtro_separable_##SUF(p, (const T *)origen, (T *)destino, fila_ini, fila_fin,     \
+                                   (TS *)((TV *)temporal + renglon), (TV *)temporal);          \
+            break;                                                                             \
+        default:                                                                               \
+            filtro_escalar_##SUF(p, (const T *)origen, (T *)destino, fila_ini, fila_fin, bloque); \
+    }
+
+/**
+ * @brief Aplica una pasada del filtro a las filas [fila_ini, fila_fin) de la imagen.
+ *
+ * Lee siempre de origen y escribe en destino, por lo que varios hilos pueden procesar
+ * franjas distintas al mismo tiempo sin sincronizarse entre ellos.
+ *
+ * @param p Parametros de la imagen y del filtro
+ * @param origen Imagen de entrada (completa)
+ * @param destino Imagen de salida (completa)
+ * @param fila_ini Primera fila a procesar
+ * @param fila_fin Fila siguiente a la ultima a procesar
+ * @param temporal Memoria de filtro_tam_temporal(p) bytes, propia de cada hilo
+ */
+static inline void filtrar_franja(const ParamsFiltro *p, const void *origen, void *destino,
+                                  int fila_ini, int fila_fin, void *temporal) {
+    size_t renglon = (size_t)p->ancho * p->canales;
+    int bloque = (p->variante == FILTRO_BLOQUES) ? p->tam_bloque : 0;
+
+    switch (p->precision) {
+        case FILTRO_U8:  FILTRO_DESPACHAR(u8, uint8_t, int32_t, int32_t);   break;
+        case FILTRO_U16: FILTRO_DESPACHAR(u16, uint16_t, int32_t, int32_t); break;
+        case FILTRO_F32: FILTRO_DESPACHAR(f32, float, float, double);       break;
+    }
+}
+
+#endif // FILTRO_H
@@ -0,0 +1,148 @@
+/**
+ * @file aleatorio.h
+ * @brief Generador de numeros aleatorios por hilo: xoshiro256** sembrado con splitmix64.
+ * @author Salvador Gonzalez Arellano
+ *
+ * rand() guarda su estado en una variable global y glibc lo protege con un cerrojo: si
+ * varios hilos llaman rand() a la vez se forman en ese cerrojo y la linea de cache del
+ * estado viaja entre nucleos en cada llamada. Es una region critica escondida que cambia
+ * los resultados de cualquier medicion de cerrojos (ver "3.1. ExclusionMutua/Ej10Aleatorio.c").
+ * rand_r no tiene cerrojo, pero su estado es de 32 bits y glibc solo da 31 bits por llamada.
+ *
+ * Aqui cada hilo tiene su propio estado de 256 bits (xoshiro256**, de Blackman y Vigna):
+ * generar es un punado de sumas, corrimientos y una multiplicacion, sin memoria compartida.
+ * El estado se siembra con splitmix64 a partir de una semilla y un numero de flujo (por
+ * ejemplo el indice del hilo), asi dos hilos con la misma semilla dan secuencias distintas.
+ *
+ * Con estado explicito:
+ *
+ *      Aleatorio rng;
+ *      aleatorio_sembrar(&rng, time(NULL), id);
+ *      int operacion = aleatorio_rango(&rng, 2);           // 0 o 1
+ *      double u = aleatorio_real(&rng);                    // [0, 1)
+ *
+ * O como reemplazo directo de srand/rand, con un estado _Thread_local por hilo:
+ *
+ *      aleatorio_semilla_hilos(time(NULL));                // en lugar de srand(time(NULL))
+ *      usleep(100000 + aleatorio_rango(aleatorio_hilo(), 400001));   // rand() % 400001
+ *
+ * Cada hilo siembra su estado la primera vez que llama aleatorio_hilo, con la semilla de
+ * aleatorio_semilla_hilos y un flujo distinto por hilo.
+ */
+
+#ifndef ALEATORIO_H
+#define ALEATORIO_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/**
+ * @struct Aleatorio
+ * @brief Estado de xoshiro256**; no debe ser todo ceros (aleatorio_sembrar lo evita).
+ */
+typedef struct {
+    uint64_t s[4];
+} Aleatorio;
+
+/**
+ * @brief Mezcla final de splitmix64: cambia casi la mitad de los bits de salida por cada
+ *        bit de entrada.
+ */
+static inline uint64_t aleatorio_mezclar(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Siguiente valor de splitmix64 (avanza x).
+ */
+static inline uint64_t splitmix64(uint64_t *x) {
+    *x += 0x9E3779B97F4A7C15ULL;
+    return aleatorio_mezclar(*x);
+}
+
+/**
+ * @brief Siembra el estado con una semilla y un numero de flujo (el indice del hilo).
+ */
+static inline void aleatorio_sembrar(Aleatorio *a, uint64_t semilla, uint64_t flujo) {
+    uint64_t x = semilla ^ aleatorio_mezclar(flujo * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL);
+    for (int i = 0; i < 4; i++) {
+        a->s[i] = splitmix64(&x);
+    }
+    if ((a->s[0] | a->s[1] | a->s[2] | a->s[3]) == 0) a->s[0] = 1;
+}
+
+static inline uint64_t aleatorio_rotar(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Siguiente valor de 64 bits de xoshiro256**.
+ */
+static inline uint64_t aleatorio_u64(Aleatorio *a) {
+    uint64_t *s = a->s;
+    uint64_t resultado = aleatorio_rotar(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = aleatorio_rotar(s[3], 45);
+    return resultado;
+}
+
+/**
+ * @brief Entero uniforme en [0, n), n > 0.
+ *
+ * rand() % n favorece a los valores chicos cuando n no divide a RAND_MAX + 1. Aqui se
+ * multiplica un valor de 32 bits por n y se toma la parte alta (metodo de Lemire); los
+ * pocos valores que causarian sesgo se descartan y se genera otro.
+ */
+static inline uint32_t aleatorio_rango(Aleatorio *a, uint32_t n) {
+    uint64_t m = (aleatorio_u64(a) >> 32) * (uint64_t)n;
+    if ((uint32_t)m < n) {
+        uint32_t umbral = (uint32_t)(-n) % n;
+        while ((uint32_t)m < umbral) {
+            m = (aleatorio_u64(a) >> 32) * (uint64_t)n;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/**
+ * @brief Real uniforme en [0, 1) con 53 bits.
+ */
+static inline double aleatorio_real(Aleatorio *a) {
+    return (double)(aleatorio_u64(a) >> 11) * 0x1.0p-53;
+}
+
+// Estado por hilo para reemplazar srand/rand
+
+static uint64_t aleatorio_semilla_global = 0x853C49E6748FEA9BULL;
+static atomic_uint_fast64_t aleatorio_flujos;           // Siguiente flujo por repartir
+static _Thread_local Aleatorio aleatorio_estado_hilo;
+static _Thread_local int aleatorio_hilo_sembrado;
+
+/**
+ * @brief Fija la semilla de los hilos que aun no usan aleatorio_hilo (como srand).
+ */
+static inline void aleatorio_semilla_hilos(uint64_t semilla) {
+    aleatorio_semilla_global = semilla;
+}
+
+/**
+ * @brief Estado del hilo que llama; se siembra la primera vez con un flujo propio.
+ */
+static inline Aleatorio *aleatorio_hilo(void) {
+    if (!aleatorio_hilo_sembrado) {
+        uint64_t flujo = atomic_fetch_add_explicit(&aleatorio_flujos, 1, memory_order_relaxed);
+        aleatorio_sembrar(&aleatorio_estado_hilo, aleatorio_semilla_global, flujo);
+        aleatorio_hilo_sembrado = 1;
+    }
+    return &aleatorio_estado_hilo;
+}
+
+#endif // ALEATORIO_H
@@ -0,0 +1,63 @@
+/**
+ * @file medicion.h
+ * @brief Reloj monotono y trabajo sintetico para los programas que miden rendimiento.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Los tiempos se toman con CLOCK_MONOTONIC, que no salta si alguien cambia la hora del
+ * sistema (CLOCK_REALTIME si). ahora() da segundos en un double, comodo para reportar;
+ * ahora_ns() da nanosegundos enteros, para medir esperas cortas sin perder precision.
+ *
+ * dormir_ms(ms) detiene al hilo principal mientras los trabajadores corren durante la
+ * ventana de una medicion; si una senal interrumpe nanosleep, sigue con lo que falta.
+ *
+ * trabajar(x, unidades) simula trabajo de duracion controlada, dentro o fuera de una
+ * region critica, sin tocar memoria compartida.
+ */
+
+#ifndef MEDICION_H
+#define MEDICION_H
+
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+ * @brief Segundos desde un punto fijo (solo sirve para restar dos lecturas).
+ */
+static inline double ahora(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Nanosegundos desde un punto fijo (solo sirve para restar dos lecturas).
+ */
+static inline uint64_t ahora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/**
+ * @brief Duerme ms milisegundos completos aunque llegue una senal.
+ */
+static inline void dormir_ms(long ms) {
+    struct timespec falta = { ms / 1000, (ms % 1000) * 1000000L };
+    while (nanosleep(&falta, &falta) != 0 && errno == EINTR) {
+    }
+}
+
+/**
+ * @brief Hace unidades pasos de un generador congruencial; el asm vacio impide que el
+ *        compilador calcule el resultado de antemano o quite el lazo.
+ */
+static inline uint64_t trabajar(uint64_t x, long unidades) {
+    for (long k = 0; k < unidades; k++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        __asm__ volatile("" : "+r"(x));
+    }
+    return x;
+}
+
+#endif // MEDICION_H
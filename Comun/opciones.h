@@ -0,0 +1,184 @@
+/**
+ * @file opciones.h
+ * @brief Lectura validada de los argumentos de la linea de comandos: enteros, reales y
+ *        listas separadas por comas.
+ * @author Salvador Gonzalez Arellano
+ *
+ * atoi("8x") devuelve 8 y atoi("abc") devuelve 0 sin avisar. Aqui cada valor se
+ * convierte con strtol o strtod y se rechaza si sobra texto, si se desborda o si queda
+ * fuera del rango pedido, para que el programa muestre su uso en lugar de medir otra cosa.
+ *
+ *      long hilos;
+ *      if (leer_entero(optarg, 1, MAX_HILOS, &hilos) != 0) { uso(argv[0]); return 1; }
+ *
+ *      long lista[MAX_LISTA];
+ *      int n = leer_lista("1,2,4,8", 1, MAX_HILOS, lista, MAX_LISTA);     // n = 4
+ *
+ * Para listas de nombres (cerrojos, metodos) partir_lista separa el texto en partes y
+ * cada programa interpreta las suyas.
+ *
+ * leer_entero_int y leer_lista_int guardan en int (radio, iteraciones, listas de hilos) y,
+ * si reciben el nombre del parametro, escriben por que se rechazo el valor:
+ *
+ *      if (leer_entero_int(optarg, "radio", 1, MAX_RADIO, &radio) != 0) ...
+ *      // radio debe estar entre 1 y 64 (se recibio 100)
+ */
+
+#ifndef OPCIONES_H
+#define OPCIONES_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define OPCIONES_TAM_TEXTO 256      // Longitud maxima de una lista
+#define OPCIONES_MAX_PARTES 64      // Elementos maximos de una lista
+
+/**
+ * @struct ListaTexto
+ * @brief Una lista separada por comas partida en sus elementos.
+ */
+typedef struct {
+    char texto[OPCIONES_TAM_TEXTO];         ///< Copia del texto; las partes apuntan aqui
+    char *partes[OPCIONES_MAX_PARTES];
+    int n;
+} ListaTexto;
+
+/**
+ * @brief Convierte texto a entero y verifica que este en [minimo, maximo].
+ * @return int 0 si el valor es valido, -1 en otro caso
+ */
+static inline int leer_entero(const char *texto, long minimo, long maximo, long *dest) {
+    char *fin;
+    errno = 0;
+    long valor = strtol(texto, &fin, 10);
+    if (errno != 0 || fin == texto || *fin != '\0' || valor < minimo || valor > maximo) {
+        return -1;
+    }
+    *dest = valor;
+    return 0;
+}
+
+/**
+ * @brief Como leer_entero, pero guarda en un int; [minimo, maximo] debe caber en int.
+ * @param nombre Nombre del parametro para el mensaje de error, o NULL para no escribir nada
+ * @return int 0 si el valor es valido, -1 en otro caso
+ */
+static inline int leer_entero_int(const char *texto, const char *nombre, long minimo, long maximo,
+                                  int *dest) {
+    char *fin;
+    errno = 0;
+    long valor = strtol(texto, &fin, 10);
+    if (errno != 0 || fin == texto || *fin != '\0') {
+        if (nombre) fprintf(stderr, "Valor invalido para %s: '%s'\n", nombre, texto);
+        return -1;
+    }
+    if (valor < minimo || valor > maximo) {
+        if (nombre) {
+            fprintf(stderr, "%s debe estar entre %ld y %ld (se recibio %ld)\n", nombre, minimo, maximo, valor);
+        }
+        return -1;
+    }
+    *dest = (int)valor;
+    return 0;
+}
+
+/**
+ * @brief Convierte texto a real y verifica que este en [minimo, maximo].
+ * @return int 0 si el valor es valido, -1 en otro caso
+ */
+static inline int leer_real(const char *texto, double minimo, double maximo, double *dest) {
+    char *fin;
+    errno = 0;
+    double valor = strtod(texto, &fin);
+    if (errno != 0 || fin == texto || *fin != '\0' || !(valor >= minimo && valor <= maximo)) {
+        return -1;
+    }
+    *dest = valor;
+    return 0;
+}
+
+/**
+ * @brief Parte una lista separada por comas ("1,2,4"); las comas repetidas se ignoran.
+ * @return int Numero de partes, o -1 si no hay ninguna, son demasiadas o el texto es
+ *         demasiado largo
+ */
+static inline int partir_lista(const char *texto, ListaTexto *l) {
+    if (strlen(texto) >= sizeof(l->texto)) return -1;
+    strcpy(l->texto, texto);
+
+    l->n = 0;
+    for (char *parte = strtok(l->texto, ","); parte != NULL; parte = strtok(NULL, ",")) {
+        if (l->n == OPCIONES_MAX_PARTES) return -1;
+        l->partes[l->n++] = parte;
+    }
+    return (l->n > 0) ? l->n : -1;
+}
+
+/**
+ * @brief Convierte una lista de enteros ("1,2,4") a valores en [minimo, maximo].
+ * @param capacidad Elementos que caben en valores
+ * @return int Numero de elementos leidos, o -1 si alguno es invalido o no caben
+ */
+static inline int leer_lista(const char *texto, long minimo, long maximo, long *valores, int capacidad) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > capacidad) return -1;
+    for (int i = 0; i < l.n; i++) {
+        if (leer_entero(l.partes[i], minimo, maximo, &valores[i]) != 0) return -1;
+    }
+    return l.n;
+}
+
+/**
+ * @brief Como leer_lista, pero guarda en int y con el mensaje de leer_entero_int.
+ * @param nombre Nombre del parametro para el mensaje de error, o NULL para no escribir nada
+ * @return int Numero de elementos leidos, o -1 si alguno es invalido o no caben
+ */
+static inline int leer_lista_int(const char *texto, const char *nombre, long minimo, long maximo,
+                                 int *valores, int capacidad) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > capacidad) {
+        if (nombre) fprintf(stderr, "Lista invalida para %s: '%s' (hasta %d valores)\n", nombre, texto, capacidad);
+        return -1;
+    }
+    for (int i = 0; i < l.n; i++) {
+        if (leer_entero_int(l.partes[i], nombre, minimo, maximo, &valores[i]) != 0) return -1;
+    }
+    return l.n;
+}
+
+/**
+ * @brief Convierte una lista de reales ("0,0.99") a valores en [minimo, maximo].
+ * @return int Numero de elementos leidos, o -1 si alguno es invalido o no caben
+ */
+static inline int leer_lista_real(const char *texto, double minimo, double maximo, double *valores,
+                                  int capacidad) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > capacidad) return -1;
+    for (int i = 0; i < l.n; i++) {
+        if (leer_real(l.partes[i], minimo, maximo, &valores[i]) != 0) return -1;
+    }
+    return l.n;
+}
+
+/**
+ * @brief Convierte una lista de nombres ("orden,intento") a su indice en nombres.
+ * @param nombres Nombres validos, terminados en NULL
+ * @return int Numero de elementos leidos, o -1 si alguno no esta en nombres o no caben
+ */
+static inline int leer_lista_nombres(const char *texto, const char *const *nombres, int *valores,
+                                     int capacidad) {
+    ListaTexto l;
+    if (partir_lista(texto, &l) < 0 || l.n > capacidad) return -1;
+    for (int i = 0; i < l.n; i++) {
+        valores[i] = -1;
+        for (int k = 0; nombres[k] != NULL; k++) {
+            if (strcmp(l.partes[i], nombres[k]) == 0) valores[i] = k;
+        }
+        if (valores[i] < 0) return -1;
+    }
+    return l.n;
+}
+
+#endif // OPCIONES_H
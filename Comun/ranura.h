@@ -0,0 +1,74 @@
+/**
+ * @file ranura.h
+ * @brief Ranuras por hilo alineadas a linea de cache, para evitar el falso compartido.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Un arreglo como int parciales[NUM_HILOS] guarda los resultados de varios hilos en la
+ * misma linea de cache (64 bytes caben 16 int). Si cada hilo escribe varias veces su
+ * propia posicion, los nucleos se roban la linea unos a otros aunque no compartan ningun
+ * dato: es el falso compartido (false sharing). El programa
+ * "2.2. Hilos/Ej7FalsoCompartido.c" mide cuanto cuesta.
+ *
+ * Una ranura ocupa y empieza en una linea de cache propia:
+ *
+ *      DEFINIR_RANURA(RanuraContador, long);    // typedef de la ranura
+ *      RanuraContador contadores[NUM_HILOS];     // contadores[i].valor es del hilo i
+ *
+ * Para arreglos dinamicos, ranuras_reservar devuelve memoria alineada y ranura_en
+ * calcula la direccion de la ranura i cuando el tamano solo se conoce en ejecucion.
+ *
+ * LINEA_CACHE vale 64 bytes (x86-64 y la mayoria de ARM). En Intel el prefetcher trae
+ * las lineas por pares, asi que se puede compilar con -DLINEA_CACHE=128 para separar
+ * tambien las lineas vecinas.
+ */
+
+#ifndef RANURA_H
+#define RANURA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef LINEA_CACHE
+#define LINEA_CACHE 64
+#endif
+
+/**
+ * @brief Define el tipo Nombre: una ranura con un campo valor de tipo T.
+ *
+ * _Alignas hace que cada ranura empiece en una linea de cache, y como el tamano de una
+ * estructura es multiplo de su alineacion, tambien la ocupa completa (relleno incluido).
+ */
+#define DEFINIR_RANURA(Nombre, T) \
+    typedef struct { _Alignas(LINEA_CACHE) T valor; } Nombre
+
+DEFINIR_RANURA(RanuraI64, int64_t);
+DEFINIR_RANURA(RanuraF64, double);
+
+/**
+ * @brief Bytes que ocupa una ranura de tam bytes: tam redondeado a lineas de cache.
+ */
+static inline size_t ranura_tam(size_t tam) {
+    return (tam + LINEA_CACHE - 1) / LINEA_CACHE * LINEA_CACHE;
+}
+
+/**
+ * @brief Reserva n ranuras de tam bytes cada una, alineadas a linea de cache.
+ *
+ * @return Apuntador a liberar con free(), o NULL si no hay memoria
+ */
+static inline void *ranuras_reservar(size_t n, size_t tam) {
+    size_t paso = ranura_tam(tam);
+    if (n == 0) n = 1;
+    if (paso != 0 && n > SIZE_MAX / paso) return NULL;
+    return aligned_alloc(LINEA_CACHE, n * paso);
+}
+
+/**
+ * @brief Direccion de la ranura i en un arreglo de ranuras_reservar(n, tam).
+ */
+static inline void *ranura_en(void *base, size_t i, size_t tam) {
+    return (unsigned char *)base + i * ranura_tam(tam);
+}
+
+#endif // RANURA_H
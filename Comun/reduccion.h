@@ -0,0 +1,364 @@
+/**
+ * @file reduccion.h
+ * @brief Reduccion paralela generica con hilos POSIX y combinacion en arbol.
+ * @author Salvador Gonzalez Arellano
+ *
+ * Generaliza el patron de Ej2SumaBarrera.c y Ej4SumaN.c: dividir n elementos en bloques,
+ * que cada hilo reduzca su bloque y despues combinar los resultados parciales.
+ *
+ * Una operacion se describe con OperacionReduccion:
+ *      - identidad: deja el acumulador en el valor neutro (0 para la suma, +inf para min)
+ *      - acumular:  reduce los elementos [inicio, fin) sobre el acumulador
+ *      - combinar:  junta el acumulador de otro hilo en el propio; debe ser asociativa
+ *
+ * acumular recibe el arreglo completo y un rango, no un apuntador al bloque, para que
+ * tambien sirva con datos implicitos (por ejemplo la suma de 1..N, donde el elemento
+ * i vale i + 1 y datos es NULL).
+ *
+ * Los resultados parciales se combinan en arbol: en la ronda k el hilo i (con i multiplo
+ * de 2^(k+1)) absorbe al hilo i + 2^k, separados por una barrera. Con p hilos son
+ * log2(p) rondas en lugar de p - 1 combinaciones hechas por un solo hilo. Cada acumulador
+ * parcial vive en su propia linea de cache (ranura.h), asi que una operacion que acumule
+ * directamente sobre el no provoca falso compartido con sus vecinos.
+ *
+ * Operaciones incluidas (con lazos que el compilador vectoriza con -O3 -march=native):
+ *      - REDUCCION_SUMA_I32:   int32_t → acumulador int64_t (no se desborda como int)
+ *      - REDUCCION_SUMA_I64:   int64_t → acumulador int64_t
+ *      - REDUCCION_SUMA_F64:   double  → suma compensada de Kahan-Neumaier
+ *      - REDUCCION_MIN_I32 / REDUCCION_MAX_I32
+ */
+
+#ifndef REDUCCION_H
+#define REDUCCION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "ranura.h"
+
+/**
+ * @struct OperacionReduccion
+ * @brief Describe una operacion asociativa para reducir_paralelo.
+ */
+typedef struct {
+    size_t tam_acumulador;                                              ///< Bytes del acumulador
+    void (*identidad)(void *acc);                                       ///< Valor neutro
+    void (*acumular)(const void *datos, size_t inicio, size_t fin, void *acc); ///< Reduce un rango
+    void (*combinar)(void *acc, const void *otro);                      ///< acc = acc op otro
+} OperacionReduccion;
+
+/**
+ * @struct KahanF64
+ * @brief Acumulador de la suma compensada: suma + compensacion es el valor exacto
+ *        aproximado con el doble de precision que una suma de double simple.
+ */
+typedef struct {
+    double suma;
+    double compensacion;
+} KahanF64;
+
+/**
+ * @brief Calcula el bloque [inicio, fin) que le toca al hilo id de num_hilos.
+ *
+ * Reparte el residuo n % num_hilos entre los primeros hilos, asi los bloques difieren
+ * a lo mas en un elemento y ninguno se salta ni se repite.
+ */
+static inline void reduccion_bloque(size_t n, int num_hilos, int id, size_t *inicio, size_t *fin) {
+    size_t base = n / num_hilos, resto = n % num_hilos;
+    *inicio = base * id + ((size_t)id < resto ? (size_t)id : resto);
+    *fin = *inicio + base + ((size_t)id < resto ? 1 : 0);
+}
+
+/* ---------- Operaciones incluidas ---------- */
+
+static inline void reduccion_cero_i64(void *acc) { *(int64_t *)acc = 0; }
+
+static inline void reduccion_combinar_suma_i64(void *acc, const void *otro) {
+    *(int64_t *)acc += *(const int64_t *)otro;
+}
+
+static inline void reduccion_acumular_suma_i32(const void *datos, size_t inicio, size_t fin, void *acc) {
+    const int32_t *a = datos;
+    int64_t suma = 0;
+    for (size_t i = inicio; i < fin; i++) {
+        suma += a[i];
+    }
+    *(int64_t *)acc += suma;
+}
+
+static inline void reduccion_acumular_suma_i64(const void *datos, size_t inicio, size_t fin, void *acc) {
+    const int64_t *a = datos;
+    int64_t suma = 0;
+    for (size_t i = inicio; i < fin; i++) {
+        suma += a[i];
+    }
+    *(int64_t *)acc += suma;
+}
+
+static inline void reduccion_identidad_min_i32(void *acc) { *(int32_t *)acc = INT32_MAX; }
+static inline void reduccion_identidad_max_i32(void *acc) { *(int32_t *)acc = INT32_MIN; }
+
+static inline void reduccion_acumular_min_i32(const void *datos, size_t inicio, size_t fin, void *acc) {
+    const int32_t *a = datos;
+    int32_t m = *(int32_t *)acc;
+    for (size_t i = inicio; i < fin; i++) {
+        m = (a[i] < m) ? a[i] : m;
+    }
+    *(int32_t *)acc = m;
+}
+
+static inline void reduccion_acumular_max_i32(const void *datos, size_t inicio, size_t fin, void *acc) {
+    const int32_t *a = datos;
+    int32_t m = *(int32_t *)acc;
+    for (size_t i = inicio; i < fin; i++) {
+        m = (a[i] > m) ? a[i] : m;
+    }
+    *(int32_t *)acc = m;
+}
+
+static inline void reduccion_combinar_min_i32(void *acc, const void *otro) {
+    int32_t o = *(const int32_t *)otro;
+    if (o < *(int32_t *)acc) *(int32_t *)acc = o;
+}
+
+static inline void reduccion_combinar_max_i32(void *acc, const void *otro) {
+    int32_t o = *(const int32_t *)otro;
+    if (o > *(int32_t *)acc) *(int32_t *)acc = o;
+}
+
+/**
+ * @brief Suma x al acumulador compensado (paso de Kahan-Neumaier).
+ *
+ * La parte de x (o de la suma) que se pierde al redondear se guarda en compensacion.
+ * Requiere que el compilador no reordene sumas de punto flotante: no usar -ffast-math.
+ */
+static inline void reduccion_kahan_sumar(double *suma, double *compensacion, double x) {
+    double t = *suma + x;
+    if (fabs(*suma) >= fabs(x)) *compensacion += (*suma - t) + x;
+    else *compensacion += (x - t) + *suma;
+    *suma = t;
+}
+
+static inline void reduccion_cero_kahan(void *acc) {
+    KahanF64 *k = acc;
+    k->suma = 0.0;
+    k->compensacion = 0.0;
+}
+
+/**
+ * @brief Suma compensada del rango en 4 carriles independientes.
+ *
+ * Cada carril lleva su propia suma y compensacion; al no depender uno del otro el
+ * compilador puede procesar los 4 carriles con una sola instruccion SIMD de 256 bits.
+ */
+static inline void reduccion_acumular_kahan(const void *datos, size_t inicio, size_t fin, void *acc) {
+    const double *a = datos;
+    double suma[4] = {0}, comp[4] = {0};
+    size_t i = inicio;
+
+    for (; i + 4 <= fin; i += 4) {
+        for (int c = 0; c < 4; c++) {
+            double t = suma[c] + a[i + c];
+            comp[c] += (fabs(suma[c]) >= fabs(a[i + c])) ? (suma[c] - t) + a[i + c] : (a[i + c] - t) + suma[c];
+            suma[c] = t;
+        }
+    }
+    KahanF64 *k = acc;
+    for (int c = 0; c < 4; c++) {
+        reduccion_kahan_sumar(&k->suma, &k->compensacion, suma[c]);
+        reduccion_kahan_sumar(&k->suma, &k->compensacion, comp[c]);
+    }
+    for (; i < fin; i++) {
+        reduccion_kahan_sumar(&k->suma, &k->compensacion, a[i]);
+    }
+}
+
+static inline void reduccion_combinar_kahan(void *acc, const void *otro) {
+    KahanF64 *k = acc;
+    const KahanF64 *o = otro;
+    reduccion_kahan_sumar(&k->suma, &k->compensacion, o->suma);
+    reduccion_kahan_sumar(&k->suma, &k->compensacion, o->compensacion);
+}
+
+/** Valor final de un acumulador KahanF64. */
+static inline double reduccion_kahan_valor(const KahanF64 *k) {
+    return k->suma + k->compensacion;
+}
+
+static const OperacionReduccion REDUCCION_SUMA_I32 = {
+    sizeof(int64_t), reduccion_cero_i64, reduccion_acumular_suma_i32, reduccion_combinar_suma_i64
+};
+static const OperacionReduccion REDUCCION_SUMA_I64 = {
+    sizeof(int64_t), reduccion_cero_i64, reduccion_acumular_suma_i64, reduccion_combinar_suma_i64
+};
+static const OperacionReduccion REDUCCION_SUMA_F64 = {
+    sizeof(KahanF64), reduccion_cero_kahan, reduccion_acumular_kahan, reduccion_combinar_kahan
+};
+static const OperacionReduccion REDUCCION_MIN_I32 = {
+    sizeof(int32_t), reduccion_identidad_min_i32, reduccion_acumular_min_i32, reduccion_combinar_min_i32
+};
+static const OperacionReduccion REDUCCION_MAX_I32 = {
+    sizeof(int32_t), reduccion_identidad_max_i32, reduccion_acumular_max_i32, reduccion_combinar_max_i32
+};
+
+/* ---------- Motor de la reduccion ---------- */
+
+/**
+ * @struct TrabajoReduccion
+ * @brief Estado compartido por los hilos de una llamada a reducir_paralelo.
+ */
+typedef struct {
+    const void *datos;
+    size_t n;
+    const OperacionReduccion *op;
+    int num_hilos;
+    void *parciales;                ///< num_hilos acumuladores, uno por linea de cache
+    pthread_barrier_t barrera;
+} TrabajoReduccion;
+
+/**
+ * @struct HiloReduccion
+ * @brief Argumento de cada hilo: el trabajo comun y su indice.
+ */
+typedef struct {
+    TrabajoReduccion *trabajo;
+    int id;
+} HiloReduccion;
+
+static inline void *reduccion_hilo(void *arg) {
+    HiloReduccion *h = arg;
+    TrabajoReduccion *t = h->trabajo;
+    const OperacionReduccion *op = t->op;
+    void *mio = ranura_en(t->parciales, h->id, op->tam_acumulador);
+    size_t inicio, fin;
+
+    // 1. Cada hilo reduce su bloque
+    reduccion_bloque(t->n, t->num_hilos, h->id, &inicio, &fin);
+    op->identidad(mio);
+    op->acumular(t->datos, inicio, fin, mio);
+
+    // 2. Combinacion en arbol: en cada ronda la mitad de los hilos activos absorbe a la otra
+    for (int paso = 1; paso < t->num_hilos; paso *= 2) {
+        pthread_barrier_wait(&t->barrera);
+        if (h->id % (2 * paso) == 0 && h->id + paso < t->num_hilos) {
+            op->combinar(mio, ranura_en(t->parciales, h->id + paso, op->tam_acumulador));
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Reduce los n elementos de datos con la operacion op usando num_hilos hilos.
+ *
+ * @param datos Arreglo de entrada (o NULL si op genera los elementos a partir del indice)
+ * @param n Numero de elementos
+ * @param op Operacion asociativa a aplicar
+ * @param num_hilos Numero de hilos (>= 1)
+ * @param resultado Donde se copia el acumulador final (op->tam_acumulador bytes)
+ * @return int 0 si todo salio bien, -1 si no se pudo reservar memoria
+ */
+static inline int reducir_paralelo(const void *datos, size_t n, const OperacionReduccion *op,
+                                   int num_hilos, void *resultado) {
+    if (num_hilos < 1) num_hilos = 1;
+    if ((size_t)num_hilos > n && n > 0) num_hilos = (int)n;
+
+    TrabajoReduccion t;
+    t.datos = datos;
+    t.n = n;
+    t.op = op;
+    t.num_hilos = num_hilos;
+    pthread_t *hilos = malloc(sizeof(pthread_t) * num_hilos);
+    HiloReduccion *args = malloc(sizeof(HiloReduccion) * num_hilos);
+    t.parciales = ranuras_reservar(num_hilos, op->tam_acumulador);
+    if (!hilos || !args || !t.parciales) {
+        free(hilos);
+        free(args);
+        free(t.parciales);
+        return -1;
+    }
+
+    pthread_barrier_init(&t.barrera, NULL, num_hilos);
+    for (int i = 0; i < num_hilos; i++) {
+        args[i].trabajo = &t;
+        args[i].id = i;
+        if (pthread_create(&hilos[i], NULL, reduccion_hilo, &args[i]) != 0) {
+            // Sin todos los hilos la barrera nunca se completaria: no hay forma de recuperarse
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    pthread_barrier_destroy(&t.barrera);
+
+    memcpy(resultado, t.parciales, op->tam_acumulador);
+    free(hilos);
+    free(args);
+    free(t.parciales);
+    return 0;
+}
+
+/**
+ * @struct TrabajoBloques
+ * @brief Argumento de cada hilo de recorrer_paralelo.
+ */
+typedef struct {
+    size_t n;
+    int num_hilos;
+    int id;
+    void (*funcion)(size_t inicio, size_t fin, void *contexto);
+    void *contexto;
+} TrabajoBloques;
+
+static inline void *reduccion_hilo_bloques(void *arg) {
+    TrabajoBloques *t = arg;
+    size_t inicio, fin;
+    reduccion_bloque(t->n, t->num_hilos, t->id, &inicio, &fin);
+    t->funcion(inicio, fin, t->contexto);
+    return NULL;
+}
+
+/**
+ * @brief Ejecuta funcion(inicio, fin, contexto) sobre los mismos bloques que usa
+ *        reducir_paralelo, un hilo por bloque.
+ *
+ * Sirve para inicializar los datos en paralelo: cada pagina la toca primero el hilo
+ * que despues la va a reducir (first-touch), lo que importa en equipos NUMA.
+ *
+ * @return int 0 si todo salio bien, -1 si no se pudo reservar memoria
+ */
+static inline int recorrer_paralelo(size_t n, int num_hilos,
+                                    void (*funcion)(size_t inicio, size_t fin, void *contexto),
+                                    void *contexto) {
+    if (num_hilos < 1) num_hilos = 1;
+    if ((size_t)num_hilos > n && n > 0) num_hilos = (int)n;
+
+    pthread_t *hilos = malloc(sizeof(pthread_t) * num_hilos);
+    TrabajoBloques *args = malloc(sizeof(TrabajoBloques) * num_hilos);
+    if (!hilos || !args) {
+        free(hilos);
+        free(args);
+        return -1;
+    }
+
+    for (int i = 0; i < num_hilos; i++) {
+        args[i] = (TrabajoBloques){ n, num_hilos, i, funcion, contexto };
+        if (pthread_create(&hilos[i], NULL, reduccion_hilo_bloques, &args[i]) != 0) {
+            fprintf(stderr, "Error al crear el hilo %d\n", i);
+            exit(1);
+        }
+    }
+    for (int i = 0; i < num_hilos; i++) {
+        pthread_join(hilos[i], NULL);
+    }
+    free(hilos);
+    free(args);
+    return 0;
+}
+
+#endif // REDUCCION_H